@@ -27,6 +27,9 @@
 #include "driver/gpio.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 #include "esp_rom_sys.h"
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
@@ -44,6 +47,28 @@ static int s_play_sample_rate = 16000;
 static int s_play_channel_format = 1;
 static int s_bits_per_chan = 16;
 
+// Playback staging: mono int16 is widened into this buffer, one chunk at a
+// time, then copied by i2s_channel_write into the driver's DMA ring.
+// Allocated once in internal DMA-capable RAM; the mutex serializes callers
+// (decode_Task and i2s_writer_task both play).
+#define BSP_PLAY_CHUNK_SAMPLES 256 // Mono samples per i2s_channel_write, 2 KB of stereo int32
+#if CONFIG_IDF_TARGET_ESP32S3
+#define BSP_PLAY_HAS_PIE 1
+#endif
+static int32_t *s_play_buf = NULL;
+static SemaphoreHandle_t s_play_lock = NULL;
+static bool s_play_pie = false;
+static bool s_tx_enabled = false; // TX channel running; kept running while RX needs its clock
+static bsp_play_stats_t s_play_stats;
+
+// Capture staging: I2S frames are read into this buffer a block at a time
+// and narrowed straight into the caller's buffer. Left slot is the 24-bit
+// mic, right slot the 16-bit playback loopback; each has its own right
+// shift (the mic default keeps 2 bits below the top 16, i.e. +12 dB).
+#define BSP_FEED_BLOCK_FRAMES 256 // Stereo frames per i2s_channel_read, 2 KB
+static int32_t *s_feed_buf = NULL;
+static uint8_t s_feed_shift[ADC_I2S_CHANNEL] = {14, 16};
+
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 static i2s_chan_handle_t rx_handle = NULL; // I2S rx channel handler
 static i2s_chan_handle_t tx_handle = NULL; // I2S rx channel handler
@@ -55,13 +80,16 @@ static esp_err_t bsp_i2s_init(i2s_port_t i2s_num, uint32_t sample_rate, int chan
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(i2s_num, I2S_ROLE_MASTER);
+    chan_cfg.auto_clear = true; // TX underflow sends zeros instead of repeating the last DMA buffers
 
     ret_val |= i2s_new_channel(&chan_cfg, &tx_handle, &rx_handle);
+    s_play_stats.dma_ms = chan_cfg.dma_desc_num * chan_cfg.dma_frame_num * 1000 / 16000;
     i2s_std_config_t std_cfg = I2S_CONFIG_DEFAULT(16000, I2S_SLOT_MODE_STEREO, 32);
     ret_val |= i2s_channel_init_std_mode(tx_handle, &std_cfg);
     ret_val |= i2s_channel_init_std_mode(rx_handle, &std_cfg);
     ret_val |= i2s_channel_enable(tx_handle);
     ret_val |= i2s_channel_enable(rx_handle);
+    s_tx_enabled = (ret_val == ESP_OK);
 #else
     // i2s_config_t i2s_config = I2S_CONFIG_DEFAULT(16000, I2S_CHANNEL_FMT_ONLY_LEFT, 32);
     i2s_config_t i2s_config = I2S_CONFIG_DEFAULT(sample_rate, I2S_CHANNEL_FMT_ONLY_LEFT, bits_per_chan);
@@ -100,71 +128,236 @@ static esp_err_t bsp_i2s_deinit(i2s_port_t i2s_num)
     return ret_val;
 }
 
+// dst[i] = sat16(src[i] >> shift), channels interleaved, n frames. The clamp
+// compiles to Xtensa CLAMPS, so a frame is two loads, two shifts, two
+// clamps and two stores with no branches.
+static void bsp_narrow(int16_t *dst, const int32_t *src, int n, int shift_l, int shift_r)
+{
+    for (int i = 0; i < n; i++)
+    {
+        int32_t l = src[i * 2] >> shift_l;
+        int32_t r = src[i * 2 + 1] >> shift_r;
+        l = l < -32768 ? -32768 : (l > 32767 ? 32767 : l);
+        r = r < -32768 ? -32768 : (r > 32767 ? 32767 : r);
+        dst[i * 2] = (int16_t)l;
+        dst[i * 2 + 1] = (int16_t)r;
+    }
+}
+
 esp_err_t bsp_get_feed_data(bool is_get_raw_channel, int16_t *buffer, int buffer_len)
 {
     esp_err_t ret = ESP_OK;
-    size_t bytes_read = 0;
-
-    // Calculate how many 32-bit samples we can fit in the buffer
-    int sample_count = buffer_len / sizeof(int16_t);
-    int32_t i2s_read_buffer[sample_count]; // temp 32-bit buffer
+    if (s_feed_buf == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
-    ret = i2s_channel_read(rx_handle, (void *)i2s_read_buffer, sizeof(i2s_read_buffer), &bytes_read, portMAX_DELAY);
-#else
-    ret = i2s_read(I2S_NUM_1, (void *)i2s_read_buffer, sizeof(i2s_read_buffer), &bytes_read, portMAX_DELAY);
-#endif
+    int frames = buffer_len / (int)(sizeof(int16_t) * ADC_I2S_CHANNEL);
+    while (frames > 0 && ret == ESP_OK)
+    {
+        int n = frames < BSP_FEED_BLOCK_FRAMES ? frames : BSP_FEED_BLOCK_FRAMES;
+        size_t bytes_read = 0;
+        ret = i2s_channel_read(rx_handle, (void *)s_feed_buf, n * ADC_I2S_CHANNEL * sizeof(int32_t), &bytes_read, portMAX_DELAY);
+
+        int got = bytes_read / (ADC_I2S_CHANNEL * sizeof(int32_t));
+        bsp_narrow(buffer, s_feed_buf, got, s_feed_shift[0], s_feed_shift[1]);
+        buffer += got * ADC_I2S_CHANNEL;
+        frames -= got;
+    }
 
-    int samples_read = bytes_read / sizeof(int32_t);
+    return ret;
+}
 
-    for (int i = 0; i < samples_read; i += 2)
+esp_err_t bsp_set_feed_shift(int channel, int shift)
+{
+    if (channel < 0 || channel >= ADC_I2S_CHANNEL || shift < 0 || shift > 31)
     {
-        // Process left channel (24-bit mic) - Extract from bits 23:0
-        // Shift right by 8 to convert 24-bit to 16-bit
-        buffer[i] = (int16_t)(i2s_read_buffer[i] >> 14);
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_feed_shift[channel] = (uint8_t)shift;
+    return ESP_OK;
+}
 
-        // Process right channel (16-bit loopback) - Extract from bits 15:0
-        // No shift needed as it's already 16-bit
-        buffer[i + 1] = (int16_t)(i2s_read_buffer[i + 1] >> 16);
+// Mono to stereo: audio in the left slot as the top 16 bits of 32, right slot silent
+static void bsp_widen_scalar(int32_t *dst, const int16_t *src, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        dst[i * 2] = (int32_t)src[i] << 16;
+        dst[i * 2 + 1] = 0;
     }
+}
 
-    return ret;
+#ifdef BSP_PLAY_HAS_PIE
+// Blocks of 8 samples, both pointers 16-byte aligned. Two zips against a zero
+// register: 16-bit lanes give (0, s) = s << 16, then 32-bit lanes add the
+// silent right slot.
+static void bsp_widen_pie(int32_t *dst, const int16_t *src, int blocks)
+{
+    for (int i = 0; i < blocks; i++)
+    {
+        __asm__ volatile(
+            "ee.vld.128.ip q0, %0, 16\n"
+            "ee.zero.q q1\n"
+            "ee.zero.q q2\n"
+            "ee.zero.q q3\n"
+            "ee.vzip.16 q1, q0\n"
+            "ee.vzip.32 q1, q2\n"
+            "ee.vzip.32 q0, q3\n"
+            "ee.vst.128.ip q1, %1, 16\n"
+            "ee.vst.128.ip q2, %1, 16\n"
+            "ee.vst.128.ip q0, %1, 16\n"
+            "ee.vst.128.ip q3, %1, 16\n"
+            : "+r"(src), "+r"(dst)
+            :
+            : "memory");
+    }
 }
+#endif
 
-esp_err_t bsp_audio_play(const int16_t *data, int length, TickType_t ticks_to_wait)
+static void bsp_widen(int32_t *dst, const int16_t *src, int n)
 {
-    // For stereo output, we need twice the buffer size to interleave left/right samples
-    size_t stereo_length = length * 2;
-    int32_t *stereo_buffer = malloc(stereo_length * sizeof(int32_t));
+#ifdef BSP_PLAY_HAS_PIE
+    if (s_play_pie && ((uintptr_t)src & 15) == 0)
+    {
+        int blocks = n / 8;
+        bsp_widen_pie(dst, src, blocks);
+        dst += blocks * 16;
+        src += blocks * 8;
+        n -= blocks * 8;
+    }
+#endif
+    bsp_widen_scalar(dst, src, n);
+}
 
-    if (stereo_buffer == NULL)
+static esp_err_t bsp_audio_buf_init(void)
+{
+    s_feed_buf = heap_caps_malloc(BSP_FEED_BLOCK_FRAMES * ADC_I2S_CHANNEL * sizeof(int32_t),
+                                  MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    s_play_buf = heap_caps_aligned_alloc(16, BSP_PLAY_CHUNK_SAMPLES * 2 * sizeof(int32_t),
+                                         MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    s_play_lock = xSemaphoreCreateMutex();
+    if (s_feed_buf == NULL || s_play_buf == NULL || s_play_lock == NULL)
     {
+        ESP_LOGE(TAG, "Audio buffer allocation failed");
         return ESP_ERR_NO_MEM;
     }
 
-    // Interleave data - left channel silent (0), right channel has audio data
-    // Also convert from 16-bit to 32-bit (shift left by 16 bits)
-    for (int i = 0; i < length; i++)
+#ifdef BSP_PLAY_HAS_PIE
+    // Use the vector kernel only if it matches the scalar one on this chip
+    static int16_t probe[8] __attribute__((aligned(16))) = {1, -2, 3, -4, 0x7fff, -0x8000, 7, -8};
+    int32_t expect[16];
+    bsp_widen_scalar(expect, probe, 8);
+    bsp_widen_pie(s_play_buf, probe, 1);
+    s_play_pie = memcmp(expect, s_play_buf, sizeof(expect)) == 0;
+    s_play_stats.pie = s_play_pie;
+    ESP_LOGI(TAG, "Playback widening: %s", s_play_pie ? "PIE" : "scalar (PIE self-check failed)");
+#endif
+    return ESP_OK;
+}
+
+esp_err_t bsp_audio_play(const int16_t *data, int length, TickType_t ticks_to_wait)
+{
+    if (s_play_buf == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t t0 = esp_timer_get_time();
+    if (xSemaphoreTake(s_play_lock, ticks_to_wait) != pdTRUE)
     {
-        stereo_buffer[i * 2] = (int32_t)data[i] << 16;  // Left channel - audio data shifted to 32-bit
-        stereo_buffer[i * 2 + 1] = 0; // Right channel - silent 
+        return ESP_ERR_TIMEOUT;
     }
 
-    size_t bytes_written = 0;
-    esp_err_t ret = i2s_channel_write(tx_handle, (uint8_t *)stereo_buffer, stereo_length * sizeof(int32_t),
-                                     &bytes_written, ticks_to_wait);
+    esp_err_t ret = ESP_OK;
+    if (!s_tx_enabled)
+    {
+        ret = i2s_channel_enable(tx_handle);
+        s_tx_enabled = (ret == ESP_OK);
+    }
+    uint32_t widen_cycles = 0;
+    for (int off = 0; off < length && ret == ESP_OK; off += BSP_PLAY_CHUNK_SAMPLES)
+    {
+        int n = length - off;
+        if (n > BSP_PLAY_CHUNK_SAMPLES)
+        {
+            n = BSP_PLAY_CHUNK_SAMPLES;
+        }
+        uint32_t c0 = esp_cpu_get_cycle_count();
+        bsp_widen(s_play_buf, data + off, n);
+        widen_cycles += esp_cpu_get_cycle_count() - c0;
+
+        size_t bytes = n * 2 * sizeof(int32_t);
+        size_t bytes_written = 0;
+        ret = i2s_channel_write(tx_handle, (uint8_t *)s_play_buf, bytes, &bytes_written, ticks_to_wait);
 
-    // Check if all bytes were written
-    if (ret == ESP_OK && bytes_written != stereo_length * sizeof(int32_t))
+        // Check if all bytes were written
+        if (ret == ESP_OK && bytes_written != bytes)
+        {
+            ret = ESP_ERR_TIMEOUT; // Not all bytes were written within the timeout period
+        }
+    }
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    s_play_stats.calls++;
+    s_play_stats.samples += length;
+    s_play_stats.total_us += us;
+    s_play_stats.widen_cycles += widen_cycles;
+    if (us > s_play_stats.max_us)
     {
-        ret = ESP_ERR_TIMEOUT; // Not all bytes were written within the timeout period
+        s_play_stats.max_us = us;
     }
+    xSemaphoreGive(s_play_lock);
 
-    free(stereo_buffer);
+    return ret;
+}
 
+esp_err_t bsp_audio_set_output(bool enable)
+{
+    if (s_play_lock == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // TX and RX are one full-duplex pair and RX runs on the TX BCK/WS, so
+    // stopping TX would stall capture (feed_Task, AFE, wake word). Leave it
+    // running while RX is up: with auto_clear it sends zeros once the
+    // writer stops feeding it.
+    if (!enable && rx_handle != NULL)
+    {
+        return ESP_OK;
+    }
+    xSemaphoreTake(s_play_lock, portMAX_DELAY);
+    esp_err_t ret = ESP_OK;
+    if (enable != s_tx_enabled)
+    {
+        ret = enable ? i2s_channel_enable(tx_handle) : i2s_channel_disable(tx_handle);
+        if (ret == ESP_OK)
+        {
+            s_tx_enabled = enable;
+        }
+    }
+    xSemaphoreGive(s_play_lock);
     return ret;
 }
 
+void bsp_audio_play_get_stats(bsp_play_stats_t *stats, bool reset)
+{
+    if (s_play_lock == NULL || xSemaphoreTake(s_play_lock, portMAX_DELAY) != pdTRUE)
+    {
+        *stats = s_play_stats;
+        return;
+    }
+    *stats = s_play_stats;
+    if (reset)
+    {
+        s_play_stats.calls = 0;
+        s_play_stats.samples = 0;
+        s_play_stats.total_us = 0;
+        s_play_stats.max_us = 0;
+        s_play_stats.widen_cycles = 0;
+    }
+    xSemaphoreGive(s_play_lock);
+}
+
 
 int bsp_get_feed_channel(void)
 {
@@ -181,7 +374,7 @@ esp_err_t bsp_board_init(uint32_t sample_rate, int channel_format, int bits_per_
     printf("------------bsp_i2s_init------------\n");
     bsp_i2s_init(I2S_NUM_1, 16000, 2, 32);
 
-    return ESP_OK;
+    return bsp_audio_buf_init();
 }
 
 esp_err_t bsp_sdcard_init(char *mount_point, size_t max_files)
@@ -101,8 +101,51 @@ esp_err_t bsp_sdcard_init(char *mount_point, size_t max_files);
 esp_err_t bsp_board_init(uint32_t sample_rate, int channel_format, int bits_per_chan);
 
 
+typedef struct {
+    uint32_t calls;
+    uint32_t samples;
+    uint64_t total_us;      // Time spent in bsp_audio_play, mostly waiting for room in the DMA ring
+    uint32_t max_us;
+    uint64_t widen_cycles;  // Mono to stereo conversion
+    uint32_t dma_ms;        // Audio the I2S DMA ring holds when full
+    bool pie;               // Vector widening kernel in use
+} bsp_play_stats_t;
+
+/**
+ * @brief Play mono 16-bit audio. Uses buffers allocated by bsp_board_init, no heap use per call.
+ *
+ * @param data Mono samples
+ * @param length Number of samples
+ * @param ticks_to_wait Timeout
+ * @return
+ *    - ESP_OK: Success
+ *    - ESP_ERR_TIMEOUT: Not all samples were written in time
+ *    - ESP_ERR_INVALID_STATE: Board not initialized
+ */
 esp_err_t bsp_audio_play(const int16_t* data, int length, TickType_t ticks_to_wait);
 
+/**
+ * @brief Start or stop the I2S TX channel. bsp_audio_play restarts it on demand.
+ *
+ * Stop only after the DMA ring has been filled with silence, or the stale
+ * contents play when it restarts. A stop is ignored while the RX channel is
+ * up, since RX is clocked by TX; the channel then sends zeros (auto_clear).
+ *
+ * @param enable Run the TX channel
+ * @return
+ *    - ESP_OK: Success
+ *    - Others: Fail
+ */
+esp_err_t bsp_audio_set_output(bool enable);
+
+/**
+ * @brief Get playback counters
+ *
+ * @param stats Filled with the counters
+ * @param reset Clear the per-call counters after reading
+ */
+void bsp_audio_play_get_stats(bsp_play_stats_t *stats, bool reset);
+
 /**
  * @brief Get the record pcm data.
  * 
@@ -116,6 +159,17 @@ esp_err_t bsp_audio_play(const int16_t* data, int length, TickType_t ticks_to_wa
  */
 esp_err_t bsp_get_feed_data(bool is_get_raw_channel, int16_t *buffer, int buffer_len);
 
+/**
+ * @brief Set the right shift that narrows a 32-bit I2S slot to the 16-bit feed sample
+ *
+ * @param channel Feed channel (0: mic, 1: playback reference)
+ * @param shift 16 keeps the top 16 bits; each step lower is +6 dB (saturating)
+ * @return
+ *    - ESP_OK                  Success
+ *    - ESP_ERR_INVALID_ARG     Bad channel or shift
+ */
+esp_err_t bsp_set_feed_shift(int channel, int shift);
+
 /**
  * @brief Get the record channel number.
  * 
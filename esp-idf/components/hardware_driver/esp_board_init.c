@@ -51,6 +51,11 @@ int esp_get_feed_channel(void)
     return bsp_get_feed_channel();
 }
 
+esp_err_t esp_set_feed_shift(int channel, int shift)
+{
+    return bsp_set_feed_shift(channel, shift);
+}
+
 char* esp_get_input_format(void)
 {
     return bsp_get_input_format();
@@ -61,6 +66,16 @@ esp_err_t esp_audio_play(const int16_t* data, int length, TickType_t ticks_to_wa
     return bsp_audio_play(data, length, ticks_to_wait);
 }
 
+esp_err_t esp_audio_set_output(bool enable)
+{
+    return bsp_audio_set_output(enable);
+}
+
+void esp_audio_play_get_stats(bsp_play_stats_t *stats, bool reset)
+{
+    bsp_audio_play_get_stats(stats, reset);
+}
+
 esp_err_t esp_audio_set_play_vol(int volume)
 {
     return bsp_audio_set_play_vol(volume);
@@ -19,6 +19,7 @@
 
 #include <stdbool.h>
 #include "esp_err.h"
+#include "bsp_board.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -65,6 +66,16 @@ esp_err_t get_i2s_data(char *buffer, int buffer_len);
 
 esp_err_t esp_audio_play(const int16_t* data, int length, TickType_t ticks_to_wait);
 
+/**
+ * @brief Start or stop the audio output (see bsp_audio_set_output)
+ */
+esp_err_t esp_audio_set_output(bool enable);
+
+/**
+ * @brief Get playback counters (calls, time per call, widening cost)
+ */
+void esp_audio_play_get_stats(bsp_play_stats_t *stats, bool reset);
+
 /**
  * @brief Get the record pcm data.
  * 
@@ -80,6 +91,11 @@ esp_err_t esp_get_feed_data(bool is_get_raw_channel, int16_t *buffer, int buffer
 
 int esp_get_feed_channel(void);
 
+/**
+ * @brief Set the per-channel capture gain as a right shift (see bsp_set_feed_shift)
+ */
+esp_err_t esp_set_feed_shift(int channel, int shift);
+
 char* esp_get_input_format(void);
 
 /**
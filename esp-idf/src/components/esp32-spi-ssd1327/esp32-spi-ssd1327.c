@@ -5,6 +5,9 @@
 
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "hal/gpio_ll.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -13,6 +16,32 @@
 // Helper macro for boundary checking
 #define BOUNDS_CHECK(x, y) ((x) < SSD1327_WIDTH && (y) < SSD1327_HEIGHT)
 
+// Opacity LUT: opacity_lut[opacity][gray] = gray * opacity / 15
+#define OPACITY_ROW(o) { 0 * (o) / 15, 1 * (o) / 15, 2 * (o) / 15, 3 * (o) / 15, \
+                         4 * (o) / 15, 5 * (o) / 15, 6 * (o) / 15, 7 * (o) / 15, \
+                         8 * (o) / 15, 9 * (o) / 15, 10 * (o) / 15, 11 * (o) / 15, \
+                         12 * (o) / 15, 13 * (o) / 15, 14 * (o) / 15, 15 * (o) / 15 }
+static const uint8_t opacity_lut[16][16] = {
+    OPACITY_ROW(0),
+    OPACITY_ROW(1),
+    OPACITY_ROW(2),
+    OPACITY_ROW(3),
+    OPACITY_ROW(4),
+    OPACITY_ROW(5),
+    OPACITY_ROW(6),
+    OPACITY_ROW(7),
+    OPACITY_ROW(8),
+    OPACITY_ROW(9),
+    OPACITY_ROW(10),
+    OPACITY_ROW(11),
+    OPACITY_ROW(12),
+    OPACITY_ROW(13),
+    OPACITY_ROW(14),
+    OPACITY_ROW(15)
+};
+
+#define BLIT_NO_KEY -1
+
 void spi_oled_init(struct spi_ssd1327 *spi_ssd1327)
 {
     spi_oled_reset(spi_ssd1327);
@@ -68,12 +97,30 @@ void spi_oled_init(struct spi_ssd1327 *spi_ssd1327)
 
     // Initialize frame buffer
     spi_oled_framebuffer_init(spi_ssd1327);
+    
+    // Transfer engine; without a staging buffer windows are sent blocking
+    if (!spi_ssd1327->staging) {
+        spi_ssd1327->staging = heap_caps_malloc(SSD1327_STAGING_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    }
+    spi_ssd1327->staging_used = 0;
+    spi_ssd1327->trans_head = 0;
+    spi_ssd1327->in_flight = 0;
+    spi_ssd1327->ctx_cmd.dev = spi_ssd1327;
+    spi_ssd1327->ctx_cmd.dc_level = 0;
+    spi_ssd1327->ctx_data.dev = spi_ssd1327;
+    spi_ssd1327->ctx_data.dc_level = 1;
     spi_ssd1327->auto_refresh = true;  // Default to auto refresh
+    spi_ssd1327->compose = false;
+    spi_ssd1327->dirty_count = 0;
+    memset(&spi_ssd1327->stats, 0, sizeof(spi_ssd1327->stats));
+    portMUX_INITIALIZE(&spi_ssd1327->dirty_lock);
     spi_ssd1327->display_mutex = xSemaphoreCreateMutex();
 }
 
 void spi_oled_deinit(struct spi_ssd1327 *spi_ssd1327)
 {
+    spi_oled_wait_idle(spi_ssd1327);
+    
     /* Clear the display buffer to prevent burn-in */
     spi_oled_send_cmd(spi_ssd1327, 0xA5);
 
@@ -94,6 +141,10 @@ void spi_oled_deinit(struct spi_ssd1327 *spi_ssd1327)
 
     // Free frame buffer
     spi_oled_framebuffer_free(spi_ssd1327);
+    if (spi_ssd1327->staging) {
+        heap_caps_free(spi_ssd1327->staging);
+        spi_ssd1327->staging = NULL;
+    }
 }
 
 void spi_oled_reset(struct spi_ssd1327 *spi_ssd1327)
@@ -108,6 +159,7 @@ void spi_oled_reset(struct spi_ssd1327 *spi_ssd1327)
 
 void spi_oled_send_cmd(struct spi_ssd1327 *spi_ssd1327, uint8_t cmd)
 {
+    spi_oled_wait_idle(spi_ssd1327);  // Queued transfers must finish first
     spi_device_acquire_bus(*(spi_ssd1327->spi_handle), portMAX_DELAY);
     gpio_set_level(spi_ssd1327->dc_pin_num, 0);
 
@@ -122,6 +174,7 @@ void spi_oled_send_cmd(struct spi_ssd1327 *spi_ssd1327, uint8_t cmd)
 
 void spi_oled_send_cmd_arg(struct spi_ssd1327 *spi_ssd1327, uint8_t cmd, uint8_t arg)
 {
+    spi_oled_wait_idle(spi_ssd1327);  // Queued transfers must finish first
     spi_device_acquire_bus(*(spi_ssd1327->spi_handle), portMAX_DELAY);
     gpio_set_level(spi_ssd1327->dc_pin_num, 0);
 
@@ -141,6 +194,7 @@ void spi_oled_send_data(struct spi_ssd1327 *spi_ssd1327, void *data, uint32_t da
     uint8_t *data_ptr = (uint8_t *)data;
     uint32_t bits_remaining = data_len_bits;
 
+    spi_oled_wait_idle(spi_ssd1327);
     spi_device_acquire_bus(*(spi_ssd1327->spi_handle), portMAX_DELAY);
     gpio_set_level(spi_ssd1327->dc_pin_num, 1);
 
@@ -162,6 +216,91 @@ void spi_oled_send_data(struct spi_ssd1327 *spi_ssd1327, void *data, uint32_t da
     spi_device_release_bus(*(spi_ssd1327->spi_handle));
 }
 
+// Transfer engine
+//
+// Windows are queued as a command transaction and a data transaction each,
+// with the rows gathered into the staging buffer so a multi-row window is a
+// single DMA transfer. The caller returns once they are queued; finished
+// transactions are collected on the next frame.
+void IRAM_ATTR spi_oled_pre_transfer_cb(spi_transaction_t *t)
+{
+    ssd1327_xfer_ctx_t *ctx = (ssd1327_xfer_ctx_t *)t->user;
+    if (!ctx) return;  // Blocking helpers drive DC themselves
+    gpio_ll_set_level(&GPIO, ctx->dev->dc_pin_num, ctx->dc_level);
+    ctx->dev->xfer_start_us = (uint32_t)esp_timer_get_time();
+}
+
+void IRAM_ATTR spi_oled_post_transfer_cb(spi_transaction_t *t)
+{
+    ssd1327_xfer_ctx_t *ctx = (ssd1327_xfer_ctx_t *)t->user;
+    if (!ctx) return;
+    ctx->dev->stats.bus_us += (uint32_t)esp_timer_get_time() - ctx->dev->xfer_start_us;
+}
+
+// Collect finished transactions, all of them if block is set
+static void spi_oled_reap(struct spi_ssd1327 *spi_ssd1327, bool block)
+{
+    uint8_t was_in_flight = spi_ssd1327->in_flight;
+    spi_transaction_t *done;
+    while (spi_ssd1327->in_flight > 0 &&
+           spi_device_get_trans_result(*(spi_ssd1327->spi_handle), &done, block ? portMAX_DELAY : 0) == ESP_OK) {
+        spi_ssd1327->trans_head = (spi_ssd1327->trans_head + 1) % SSD1327_QUEUE_DEPTH;
+        spi_ssd1327->in_flight--;
+    }
+    if (spi_ssd1327->in_flight == 0) {
+        // Nothing reads the staging buffer any more
+        spi_ssd1327->staging_used = 0;
+        if (was_in_flight) {
+            uint32_t frame_us = spi_ssd1327->stats.bus_us - spi_ssd1327->frame_bus_start;
+            if (frame_us > spi_ssd1327->stats.bus_max_us) {
+                spi_ssd1327->stats.bus_max_us = frame_us;
+            }
+        }
+    }
+}
+
+void spi_oled_wait_idle(struct spi_ssd1327 *spi_ssd1327)
+{
+    if (spi_ssd1327->in_flight) {
+        spi_oled_reap(spi_ssd1327, true);
+    }
+}
+
+// Room in the staging buffer, waiting for the bus if it is used up
+static uint8_t *spi_oled_staging_alloc(struct spi_ssd1327 *spi_ssd1327, uint16_t len)
+{
+    if (spi_ssd1327->staging_used + len > SSD1327_STAGING_SIZE) {
+        spi_ssd1327->stats.stalls++;
+        spi_oled_reap(spi_ssd1327, true);
+    }
+    uint8_t *p = spi_ssd1327->staging + spi_ssd1327->staging_used;
+    spi_ssd1327->staging_used += (len + 3) & ~3;  // Keep DMA buffers word aligned
+    return p;
+}
+
+static void spi_oled_queue(struct spi_ssd1327 *spi_ssd1327, const uint8_t *buf, uint16_t len,
+                           ssd1327_xfer_ctx_t *ctx)
+{
+    if (spi_ssd1327->in_flight == SSD1327_QUEUE_DEPTH) {
+        // Results come back in order, so this frees the oldest slot
+        spi_transaction_t *done;
+        spi_ssd1327->stats.stalls++;
+        ESP_ERROR_CHECK(spi_device_get_trans_result(*(spi_ssd1327->spi_handle), &done, portMAX_DELAY));
+        spi_ssd1327->trans_head = (spi_ssd1327->trans_head + 1) % SSD1327_QUEUE_DEPTH;
+        spi_ssd1327->in_flight--;
+    }
+    if (spi_ssd1327->in_flight == 0) {
+        spi_ssd1327->frame_bus_start = spi_ssd1327->stats.bus_us;
+    }
+    
+    spi_transaction_t *t = &spi_ssd1327->trans[(spi_ssd1327->trans_head + spi_ssd1327->in_flight) % SSD1327_QUEUE_DEPTH];
+    memset(t, 0, sizeof(*t));
+    t->length = len * 8;
+    t->tx_buffer = buf;
+    t->user = ctx;
+    ESP_ERROR_CHECK(spi_device_queue_trans(*(spi_ssd1327->spi_handle), t, portMAX_DELAY));
+    spi_ssd1327->in_flight++;
+}
 
 // Frame buffer management functions
 bool spi_oled_framebuffer_init(struct spi_ssd1327 *spi_ssd1327)
@@ -177,6 +316,8 @@ bool spi_oled_framebuffer_init(struct spi_ssd1327 *spi_ssd1327)
     
     // Clear the frame buffer
     memset(spi_ssd1327->framebuffer, 0x00, SSD1327_BUFFER_SIZE);
+    memset(spi_ssd1327->glyphs, 0, sizeof(spi_ssd1327->glyphs));
+    spi_ssd1327->glyph_clock = 0;
     return true;
 }
 
@@ -196,7 +337,74 @@ void spi_oled_framebuffer_clear(struct spi_ssd1327 *spi_ssd1327, ssd1327_gs_t co
     memset(spi_ssd1327->framebuffer, pixel_byte, SSD1327_BUFFER_SIZE);
     
     if (spi_ssd1327->auto_refresh) {
-        spi_oled_framebuffer_refresh(spi_ssd1327);
+        if (spi_ssd1327->compose) {
+            spi_oled_mark_dirty(spi_ssd1327, 0, 0, SSD1327_WIDTH, SSD1327_HEIGHT);
+        } else {
+            spi_oled_framebuffer_refresh(spi_ssd1327);
+        }
+    }
+}
+
+// Queue one address window of the frame buffer; caller holds display_mutex.
+// Columns are in panel units (two pixels each), bounds inclusive.
+static void spi_oled_write_window(struct spi_ssd1327 *spi_ssd1327,
+                                  uint8_t start_col, uint8_t end_col,
+                                  uint8_t start_row, uint8_t end_row)
+{
+    uint16_t bytes_per_row = end_col - start_col + 1;
+    uint16_t rows = end_row - start_row + 1;
+    
+    spi_ssd1327->stats.bytes += SSD1327_CMD_BYTES + (uint32_t)bytes_per_row * rows;
+    spi_ssd1327->stats.windows++;
+    
+    if (spi_ssd1327->staging) {
+        int64_t t0 = esp_timer_get_time();
+        spi_oled_reap(spi_ssd1327, false);
+        
+        uint8_t *cmd = spi_oled_staging_alloc(spi_ssd1327, SSD1327_CMD_BYTES);
+        cmd[0] = 0x15;  // Set Column Address
+        cmd[1] = start_col;
+        cmd[2] = end_col;
+        cmd[3] = 0x75;  // Set Row Address
+        cmd[4] = start_row;
+        cmd[5] = end_row;
+        spi_oled_queue(spi_ssd1327, cmd, SSD1327_CMD_BYTES, &spi_ssd1327->ctx_cmd);
+        
+        // Gather the rows, the frame buffer is free to change once queued
+        uint16_t len = bytes_per_row * rows;
+        uint8_t *data = spi_oled_staging_alloc(spi_ssd1327, len);
+        const uint8_t *src = &spi_ssd1327->framebuffer[start_row * (SSD1327_WIDTH / 2) + start_col];
+        if (bytes_per_row == SSD1327_WIDTH / 2) {
+            memcpy(data, src, len);
+        } else {
+            for (uint16_t row = 0; row < rows; row++) {
+                memcpy(&data[row * bytes_per_row], &src[row * (SSD1327_WIDTH / 2)], bytes_per_row);
+            }
+        }
+        spi_oled_queue(spi_ssd1327, data, len, &spi_ssd1327->ctx_data);
+        
+        spi_ssd1327->stats.queue_us += (uint32_t)(esp_timer_get_time() - t0);
+        return;
+    }
+    
+    spi_oled_send_cmd(spi_ssd1327, 0x15);  // Set Column Address
+    spi_oled_send_cmd(spi_ssd1327, start_col);
+    spi_oled_send_cmd(spi_ssd1327, end_col);
+    
+    spi_oled_send_cmd(spi_ssd1327, 0x75);  // Set Row Address
+    spi_oled_send_cmd(spi_ssd1327, start_row);
+    spi_oled_send_cmd(spi_ssd1327, end_row);
+    
+    if (bytes_per_row == SSD1327_WIDTH / 2) {
+        // Full width rows are contiguous in the frame buffer
+        uint16_t offset = start_row * (SSD1327_WIDTH / 2);
+        spi_oled_send_data(spi_ssd1327, &spi_ssd1327->framebuffer[offset], bytes_per_row * rows * 8);
+    } else {
+        // Send region data row by row
+        for (uint16_t row = start_row; row <= end_row; row++) {
+            uint16_t offset = (row * (SSD1327_WIDTH / 2)) + start_col;
+            spi_oled_send_data(spi_ssd1327, &spi_ssd1327->framebuffer[offset], bytes_per_row * 8);
+        }
     }
 }
 
@@ -207,17 +415,8 @@ void spi_oled_framebuffer_refresh(struct spi_ssd1327 *spi_ssd1327)
     // Take mutex with timeout to prevent deadlock
     if (xSemaphoreTake(spi_ssd1327->display_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
         
-        // Set full screen address window
-        spi_oled_send_cmd(spi_ssd1327, 0x15);  // Set Column Address
-        spi_oled_send_cmd(spi_ssd1327, 0x00);  // Column start
-        spi_oled_send_cmd(spi_ssd1327, 0x3F);  // Column end (128/2 - 1 = 63)
-        
-        spi_oled_send_cmd(spi_ssd1327, 0x75);  // Set Row Address
-        spi_oled_send_cmd(spi_ssd1327, 0x00);  // Row start
-        spi_oled_send_cmd(spi_ssd1327, 0x7F);  // Row end (128 - 1 = 127)
-        
-        // Send entire frame buffer
-        spi_oled_send_data(spi_ssd1327, spi_ssd1327->framebuffer, SSD1327_BUFFER_SIZE * 8);
+        // Full screen address window, the frame buffer is contiguous
+        spi_oled_write_window(spi_ssd1327, 0, SSD1327_WIDTH / 2 - 1, 0, SSD1327_HEIGHT - 1);
         
         // Release mutex
         xSemaphoreGive(spi_ssd1327->display_mutex);
@@ -241,26 +440,174 @@ void spi_oled_framebuffer_refresh_region(struct spi_ssd1327 *spi_ssd1327,
         uint8_t start_col = x / 2;
         uint8_t end_col = (x + width - 1) / 2;
         
-        spi_oled_send_cmd(spi_ssd1327, 0x15);
-        spi_oled_send_cmd(spi_ssd1327, start_col);
-        spi_oled_send_cmd(spi_ssd1327, end_col);
-        
-        spi_oled_send_cmd(spi_ssd1327, 0x75);
-        spi_oled_send_cmd(spi_ssd1327, y);
-        spi_oled_send_cmd(spi_ssd1327, y + height - 1);
-        
-        // Send region data row by row
-        uint16_t bytes_per_row = end_col - start_col + 1;
-        for (uint8_t row = 0; row < height; row++) {
-            uint16_t offset = ((y + row) * (SSD1327_WIDTH / 2)) + start_col;
-            spi_oled_send_data(spi_ssd1327, &spi_ssd1327->framebuffer[offset], bytes_per_row * 8);
-        }
+        spi_oled_write_window(spi_ssd1327, start_col, end_col, y, y + height - 1);
         
         // Release mutex
         xSemaphoreGive(spi_ssd1327->display_mutex);
     }
 }
 
+// Compositor functions
+void spi_oled_set_compose(struct spi_ssd1327 *spi_ssd1327, bool compose)
+{
+    spi_ssd1327->compose = compose;
+}
+
+// Panel bytes plus window overhead to send a rectangle
+static uint32_t rect_cost(const ssd1327_rect_t *r)
+{
+    return (uint32_t)((r->x1 - r->x0 + 1) / 2) * (r->y1 - r->y0 + 1) + SSD1327_WINDOW_COST;
+}
+
+static ssd1327_rect_t rect_union(const ssd1327_rect_t *a, const ssd1327_rect_t *b)
+{
+    ssd1327_rect_t u = {
+        .x0 = (a->x0 < b->x0) ? a->x0 : b->x0,
+        .y0 = (a->y0 < b->y0) ? a->y0 : b->y0,
+        .x1 = (a->x1 > b->x1) ? a->x1 : b->x1,
+        .y1 = (a->y1 > b->y1) ? a->y1 : b->y1,
+    };
+    return u;
+}
+
+// Merge rectangles while one window costs no more than two: overlaps stop
+// being sent twice and nearby fragments share one address window. Greedy,
+// best saving first; count is at most SSD1327_DIRTY_MAX so O(n^3) is cheap.
+// Returns the new count.
+uint8_t spi_oled_merge_rects(ssd1327_rect_t *rects, uint8_t count)
+{
+    while (count > 1) {
+        int32_t best_saving = -1;
+        uint8_t best_i = 0, best_j = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            for (uint8_t j = i + 1; j < count; j++) {
+                ssd1327_rect_t u = rect_union(&rects[i], &rects[j]);
+                int32_t saving = (int32_t)(rect_cost(&rects[i]) + rect_cost(&rects[j])) - (int32_t)rect_cost(&u);
+                if (saving > best_saving) {
+                    best_saving = saving;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+        if (best_saving < 0) break;
+        rects[best_i] = rect_union(&rects[best_i], &rects[best_j]);
+        rects[best_j] = rects[--count];
+    }
+    return count;
+}
+
+void spi_oled_mark_dirty(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                         int16_t width, int16_t height)
+{
+    // Clip, then widen to whole column pairs (one panel column is two pixels)
+    int16_t x1 = x + width - 1;
+    int16_t y1 = y + height - 1;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 >= SSD1327_WIDTH) x1 = SSD1327_WIDTH - 1;
+    if (y1 >= SSD1327_HEIGHT) y1 = SSD1327_HEIGHT - 1;
+    if (x > x1 || y > y1) return;
+    
+    ssd1327_rect_t r = {
+        .x0 = x & ~1,
+        .y0 = y,
+        .x1 = x1 | 1,
+        .y1 = y1,
+    };
+    
+    taskENTER_CRITICAL(&spi_ssd1327->dirty_lock);
+    spi_ssd1327->stats.marks++;
+    ssd1327_rect_t *dirty = spi_ssd1327->dirty;
+    uint8_t n = spi_ssd1327->dirty_count;
+    bool done = false;
+    for (uint8_t i = 0; i < n; i++) {
+        // Already covered: redrawing the same animation frame area
+        if (dirty[i].x0 <= r.x0 && dirty[i].y0 <= r.y0 && dirty[i].x1 >= r.x1 && dirty[i].y1 >= r.y1) {
+            done = true;
+            break;
+        }
+    }
+    if (!done && n == SSD1327_DIRTY_MAX) {
+        n = spi_oled_merge_rects(dirty, n);
+    }
+    if (!done && n == SSD1327_DIRTY_MAX) {
+        // Still full: grow the rectangle that grows least
+        uint8_t best = 0;
+        uint32_t best_growth = UINT32_MAX;
+        for (uint8_t i = 0; i < n; i++) {
+            ssd1327_rect_t u = rect_union(&dirty[i], &r);
+            uint32_t growth = rect_cost(&u) - rect_cost(&dirty[i]);
+            if (growth < best_growth) {
+                best_growth = growth;
+                best = i;
+            }
+        }
+        dirty[best] = rect_union(&dirty[best], &r);
+        done = true;
+    }
+    if (!done) {
+        dirty[n++] = r;
+    }
+    spi_ssd1327->dirty_count = n;
+    taskEXIT_CRITICAL(&spi_ssd1327->dirty_lock);
+}
+
+// Send everything marked dirty since the last flush; call once per display tick.
+// Returns the bytes sent.
+uint32_t spi_oled_flush(struct spi_ssd1327 *spi_ssd1327)
+{
+    if (!spi_ssd1327->framebuffer || !spi_ssd1327->display_mutex) return 0;
+    
+    // Take the list, drawing may carry on and mark the next frame meanwhile
+    ssd1327_rect_t rects[SSD1327_DIRTY_MAX];
+    taskENTER_CRITICAL(&spi_ssd1327->dirty_lock);
+    uint8_t n = spi_ssd1327->dirty_count;
+    memcpy(rects, spi_ssd1327->dirty, n * sizeof(rects[0]));
+    spi_ssd1327->dirty_count = 0;
+    taskEXIT_CRITICAL(&spi_ssd1327->dirty_lock);
+    if (n == 0) return 0;
+    
+    n = spi_oled_merge_rects(rects, n);
+    
+    uint32_t sent = 0;
+    if (xSemaphoreTake(spi_ssd1327->display_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        uint32_t before = spi_ssd1327->stats.bytes;
+        for (uint8_t i = 0; i < n; i++) {
+            spi_oled_write_window(spi_ssd1327, rects[i].x0 / 2, rects[i].x1 / 2, rects[i].y0, rects[i].y1);
+        }
+        spi_ssd1327->stats.flushes++;
+        sent = spi_ssd1327->stats.bytes - before;
+        xSemaphoreGive(spi_ssd1327->display_mutex);
+    } else {
+        // Bus busy too long: put the regions back for the next tick
+        for (uint8_t i = 0; i < n; i++) {
+            spi_oled_mark_dirty(spi_ssd1327, rects[i].x0, rects[i].y0,
+                                rects[i].x1 - rects[i].x0 + 1, rects[i].y1 - rects[i].y0 + 1);
+        }
+    }
+    return sent;
+}
+
+void spi_oled_get_stats(struct spi_ssd1327 *spi_ssd1327, ssd1327_stats_t *stats)
+{
+    taskENTER_CRITICAL(&spi_ssd1327->dirty_lock);
+    *stats = spi_ssd1327->stats;
+    taskEXIT_CRITICAL(&spi_ssd1327->dirty_lock);
+}
+
+// Drawing calls report what they touched: marked for the next flush when
+// composing, sent straight away otherwise
+static void spi_oled_invalidate(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                                int16_t width, int16_t height)
+{
+    if (spi_ssd1327->compose) {
+        spi_oled_mark_dirty(spi_ssd1327, x, y, width, height);
+    } else {
+        spi_oled_framebuffer_refresh_region(spi_ssd1327, x, y, width, height);
+    }
+}
+
 // Pixel manipulation functions
 void spi_oled_set_pixel(struct spi_ssd1327 *spi_ssd1327, uint8_t x, uint8_t y, ssd1327_gs_t gs)
 {
@@ -292,28 +639,58 @@ ssd1327_gs_t spi_oled_get_pixel(struct spi_ssd1327 *spi_ssd1327, uint8_t x, uint
     }
 }
 
+// Fill n pixels of one frame buffer row from pixel x: odd edge pixels are
+// read-modify-write, the whole bytes between them one memset
+static inline void spi_oled_fill_span(uint8_t *row, int16_t x, int16_t n,
+                                      ssd1327_gs_t gs, uint8_t both)
+{
+    if (x & 1) {
+        row[x / 2] = (row[x / 2] & 0xF0) | gs;
+        x++;
+        n--;
+    }
+    memset(&row[x / 2], both, n / 2);
+    if (n & 1) {
+        uint8_t *last = &row[(x + n - 1) / 2];
+        *last = (*last & 0x0F) | (gs << 4);
+    }
+}
+
+// Fill a clipped rectangle a row span at a time
+static void spi_oled_fill_rect(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                               int16_t width, int16_t height, ssd1327_gs_t gs)
+{
+    if (!spi_ssd1327->framebuffer) return;
+    
+    int16_t x1 = x + width;
+    int16_t y1 = y + height;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 > SSD1327_WIDTH) x1 = SSD1327_WIDTH;
+    if (y1 > SSD1327_HEIGHT) y1 = SSD1327_HEIGHT;
+    if (x >= x1 || y >= y1) return;
+    
+    uint8_t both = (gs << 4) | gs;
+    for (int16_t row = y; row < y1; row++) {
+        spi_oled_fill_span(&spi_ssd1327->framebuffer[row * (SSD1327_WIDTH / 2)],
+                           x, x1 - x, gs, both);
+    }
+}
+
 void spi_oled_clear_region(struct spi_ssd1327 *spi_ssd1327, uint8_t x, uint8_t y, 
                          uint8_t width, uint8_t height)
 {
-    for (uint8_t dy = 0; dy < height; dy++) {
-        for (uint8_t dx = 0; dx < width; dx++) {
-            spi_oled_set_pixel(spi_ssd1327, x + dx, y + dy, 0);
-        }
-    }
+    spi_oled_fill_rect(spi_ssd1327, x, y, width, height, SSD1327_GS_0);
 }
 
 // Drawing functions
 void spi_oled_draw_square(struct spi_ssd1327 *spi_ssd1327, uint8_t x, uint8_t y, 
                          uint8_t width, uint8_t height, ssd1327_gs_t gs)
 {
-    for (uint8_t dy = 0; dy < height; dy++) {
-        for (uint8_t dx = 0; dx < width; dx++) {
-            spi_oled_set_pixel(spi_ssd1327, x + dx, y + dy, gs);
-        }
-    }
+    spi_oled_fill_rect(spi_ssd1327, x, y, width, height, gs);
     
     if (spi_ssd1327->auto_refresh) {
-        spi_oled_framebuffer_refresh_region(spi_ssd1327, x, y, width, height);
+        spi_oled_invalidate(spi_ssd1327, x, y, width, height);
     }
 }
 
@@ -346,9 +723,9 @@ void spi_oled_draw_circle(struct spi_ssd1327 *spi_ssd1327, uint8_t cx, uint8_t c
     
     if (spi_ssd1327->auto_refresh) {
         uint8_t refresh_size = radius * 2 + 1;
-        spi_oled_framebuffer_refresh_region(spi_ssd1327, 
-                                          cx - radius, cy - radius, 
-                                          refresh_size, refresh_size);
+        spi_oled_invalidate(spi_ssd1327, 
+                            cx - radius, cy - radius, 
+                            refresh_size, refresh_size);
     }
 }
 
@@ -384,23 +761,224 @@ void spi_oled_draw_line(struct spi_ssd1327 *spi_ssd1327, uint8_t x0, uint8_t y0,
         uint8_t min_y = (y0 < y1) ? y0 : y1;
         uint8_t width = abs(x1 - x0) + 1;
         uint8_t height = abs(y1 - y0) + 1;
-        spi_oled_framebuffer_refresh_region(spi_ssd1327, min_x, min_y, width, height);
+        spi_oled_invalidate(spi_ssd1327, min_x, min_y, width, height);
     }
 }
 
 // Text drawing functions
+
+// Decode one UTF-8 sequence and step past it; malformed input gives U+FFFD
+static uint32_t utf8_next(const char **str)
+{
+    static const uint32_t min_cp[4] = {0, 0x80, 0x800, 0x10000};
+    const uint8_t *p = (const uint8_t *)*str;
+    uint32_t cp;
+    uint8_t extra;
+    
+    if (p[0] < 0x80) {
+        *str += 1;
+        return p[0];
+    } else if ((p[0] & 0xE0) == 0xC0) {
+        cp = p[0] & 0x1F;
+        extra = 1;
+    } else if ((p[0] & 0xF0) == 0xE0) {
+        cp = p[0] & 0x0F;
+        extra = 2;
+    } else if ((p[0] & 0xF8) == 0xF0) {
+        cp = p[0] & 0x07;
+        extra = 3;
+    } else {
+        *str += 1;
+        return 0xFFFD;
+    }
+    
+    for (uint8_t i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) {  // Also stops at the terminator
+            *str += i;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    *str += extra + 1;
+    
+    if (cp < min_cp[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return 0xFFFD;
+    }
+    return cp;
+}
+
+// Point glyph at the bitmap for codepoint: ASCII from the font tables, the
+// rest by binary search of the packed extra glyphs
+static bool spi_oled_find_glyph(const variable_font_t *font, uint32_t codepoint,
+                                ssd1327_glyph_t *glyph)
+{
+    if (codepoint >= 32 && codepoint <= 126) {
+        uint8_t char_idx = codepoint - 32;
+        glyph->width = font->widths[char_idx];
+        glyph->pitch = ((glyph->width + 7) / 8) * 8;
+        glyph->bits = &font->data[font->offsets[char_idx]];
+        glyph->top = 0;
+        glyph->rows = font->height;
+        return true;
+    }
+    
+    const packed_font_t *extra = font->extra;
+    if (!extra) return false;
+    
+    int lo = 0;
+    int hi = extra->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const packed_glyph_t *g = &extra->glyphs[mid];
+        if (g->codepoint < codepoint) {
+            lo = mid + 1;
+        } else if (g->codepoint > codepoint) {
+            hi = mid - 1;
+        } else {
+            glyph->width = g->width;
+            glyph->pitch = g->width;
+            glyph->bits = &extra->data[g->offset];
+            glyph->top = g->top;
+            glyph->rows = g->rows;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Control characters take no space; anything else the font lacks is '?'
+static bool spi_oled_resolve_glyph(const variable_font_t *font, uint32_t codepoint,
+                                   ssd1327_glyph_t *glyph)
+{
+    if (codepoint < 32 || (codepoint >= 127 && codepoint < 0xA0)) return false;
+    return spi_oled_find_glyph(font, codepoint, glyph) ||
+           spi_oled_find_glyph(font, '?', glyph);
+}
+
+static inline bool glyph_bit(const ssd1327_glyph_t *glyph, uint8_t row, uint8_t col)
+{
+    uint32_t bit = (uint32_t)row * glyph->pitch + col;
+    return glyph->bits[bit / 8] & (0x80 >> (bit % 8));
+}
+
+// Turn the bitmap into runs of inked pixels, dropping blank rows at the top
+// and bottom. spans_ok stays false if the glyph does not fit the cache slot.
+static void spi_oled_expand_glyph(ssd1327_glyph_t *glyph)
+{
+    glyph->spans_ok = false;
+    if (glyph->rows > SSD1327_GLYPH_MAX_ROWS) return;
+    
+    uint8_t count = 0;
+    int16_t first = -1;
+    int16_t last = -1;
+    for (uint8_t row = 0; row < glyph->rows; row++) {
+        uint8_t col = 0;
+        while (col < glyph->width) {
+            if (!glyph_bit(glyph, row, col)) {
+                col++;
+                continue;
+            }
+            uint8_t start = col;
+            while (col < glyph->width && glyph_bit(glyph, row, col)) col++;
+            if (count == SSD1327_GLYPH_MAX_SPANS) return;
+            glyph->span[count][0] = start;
+            glyph->span[count][1] = col - start;
+            count++;
+            if (first < 0) first = row;
+            last = row;
+        }
+        glyph->row_end[row] = count;
+    }
+    
+    if (first < 0) {
+        glyph->rows = 0;
+    } else {
+        // Shift row_end so index 0 is the first inked row; bits is only
+        // read for glyphs that did not fit, so it keeps the untrimmed rows
+        for (int16_t row = first; row <= last; row++) {
+            glyph->row_end[row - first] = glyph->row_end[row];
+        }
+        glyph->top += first;
+        glyph->rows = last - first + 1;
+    }
+    glyph->spans_ok = true;
+}
+
+// Cached glyph for codepoint, expanded into the least recently used slot on
+// a miss. NULL if it takes no space.
+static const ssd1327_glyph_t *spi_oled_get_glyph(struct spi_ssd1327 *spi_ssd1327,
+                                                 const variable_font_t *font,
+                                                 uint32_t codepoint, bool *hit)
+{
+    ssd1327_glyph_t *slot = &spi_ssd1327->glyphs[0];
+    for (uint8_t i = 0; i < SSD1327_GLYPH_CACHE_SIZE; i++) {
+        ssd1327_glyph_t *glyph = &spi_ssd1327->glyphs[i];
+        if (glyph->font == font && glyph->codepoint == codepoint) {
+            glyph->stamp = ++spi_ssd1327->glyph_clock;
+            *hit = true;
+            return glyph;
+        }
+        if (glyph->stamp < slot->stamp) slot = glyph;  // Free slots have stamp 0
+    }
+    
+    *hit = false;
+    if (!spi_oled_resolve_glyph(font, codepoint, slot)) return NULL;
+    slot->font = font;
+    slot->codepoint = codepoint;
+    slot->stamp = ++spi_ssd1327->glyph_clock;
+    spi_oled_expand_glyph(slot);
+    return slot;
+}
+
+// Draw a glyph with its left edge at x, clipped to [0, right) and the screen
+static void spi_oled_draw_glyph(uint8_t *framebuffer, const ssd1327_glyph_t *glyph,
+                                int16_t x, int16_t y, int16_t right, ssd1327_gs_t gs)
+{
+    uint8_t both = (gs << 4) | gs;
+    uint8_t s = 0;
+    
+    for (uint8_t row = 0; row < glyph->rows; row++) {
+        int16_t screen_y = y + glyph->top + row;
+        if (screen_y >= SSD1327_HEIGHT) break;
+        uint8_t *dst = &framebuffer[screen_y * (SSD1327_WIDTH / 2)];
+        
+        if (!glyph->spans_ok) {
+            if (screen_y < 0) continue;
+            for (uint8_t col = 0; col < glyph->width; col++) {
+                int16_t screen_x = x + col;
+                if (screen_x >= 0 && screen_x < right && glyph_bit(glyph, row, col)) {
+                    spi_oled_fill_span(dst, screen_x, 1, gs, both);
+                }
+            }
+            continue;
+        }
+        
+        uint8_t end = glyph->row_end[row];
+        if (screen_y < 0) {
+            s = end;
+            continue;
+        }
+        for (; s < end; s++) {
+            int16_t x0 = x + glyph->span[s][0];
+            int16_t x1 = x0 + glyph->span[s][1];
+            if (x0 < 0) x0 = 0;
+            if (x1 > right) x1 = right;
+            if (x0 < x1) spi_oled_fill_span(dst, x0, x1 - x0, gs, both);
+        }
+    }
+}
+
 uint16_t spi_oled_get_text_width(const variable_font_t *font, const char *text)
 {
     if (!text || !font) return 0;
     
     uint16_t width = 0;
     const char *str = text;
+    ssd1327_glyph_t glyph;
     
     while (*str) {
-        char c = *str++;
-        if (c >= 32 && c <= 126) {
-            uint8_t char_idx = c - 32;
-            width += font->widths[char_idx];
+        if (spi_oled_resolve_glyph(font, utf8_next(&str), &glyph)) {
+            width += glyph.width;
             if (*str) width++;  // Add spacing except for last character
         }
     }
@@ -413,162 +991,180 @@ void spi_oled_drawText(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
 {
     if (!text || !font || !spi_ssd1327->framebuffer) return;
     
+    if (max_width == 0) {
+        max_width = SSD1327_WIDTH - x;
+    }
+    int16_t right = x + max_width;
+    if (right > SSD1327_WIDTH) right = SSD1327_WIDTH;
+    
     int16_t char_x = x;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
     const char *str = text;
     
     while (*str) {
-        char c = *str++;
-        if (c < 32 || c > 126) continue;
-        
-        uint8_t char_idx = c - 32;
-        uint8_t char_width = font->widths[char_idx];
-        uint16_t data_offset = font->offsets[char_idx];
-        uint8_t bytes_per_row = (char_width + 7) / 8;
-        
-        // Calculate clipping for this character
-        int16_t start_row = (y < 0) ? -y : 0;
-        int16_t start_col = (char_x < 0) ? -char_x : 0;
-        int16_t end_row = font->height;
-        int16_t end_col = char_width;
-        if (max_width == 0) {
-            max_width = SSD1327_WIDTH - x;
-        }
-        int16_t right_limit = x + max_width;
-
-        // Clip per-character to the allowed width
-        if (char_x + end_col > right_limit) {
-            end_col = right_limit - char_x;
-            if (end_col < 0) end_col = 0;
-        }
-        
-        // Clip to screen boundaries
-        if (y + font->height > SSD1327_HEIGHT) {
-            end_row = SSD1327_HEIGHT - y;
-        }
-        if (char_x + char_width > SSD1327_WIDTH) {
-            end_col = SSD1327_WIDTH - char_x;
+        bool hit;
+        const ssd1327_glyph_t *glyph = spi_oled_get_glyph(spi_ssd1327, font, utf8_next(&str), &hit);
+        if (!glyph) continue;
+        if (hit) {
+            hits++;
+        } else {
+            misses++;
         }
         
         // Only draw if character is at least partially visible
-        if (start_row < end_row && start_col < end_col && 
-            char_x + char_width > 0 && char_x < SSD1327_WIDTH &&
+        if (char_x + glyph->width > 0 && char_x < right &&
             y + font->height > 0 && y < SSD1327_HEIGHT) {
-            
-            // Render visible portion of character
-            for (int16_t row = start_row; row < end_row; row++) {
-                int16_t screen_y = y + row;
-                if (screen_y < 0 || screen_y >= SSD1327_HEIGHT) continue;
-                
-                for (int16_t col = start_col; col < end_col; col++) {
-                    int16_t screen_x = char_x + col;
-                    if (screen_x < 0 || screen_x >= SSD1327_WIDTH) continue;
-                    
-                    uint8_t byte_idx = col / 8;
-                    uint8_t bit_idx = col % 8;
-                    uint8_t font_byte = font->data[data_offset + row * bytes_per_row + byte_idx];
-                    
-                    if (font_byte & (1 << (7 - bit_idx))) {
-                        spi_oled_set_pixel(spi_ssd1327, screen_x, screen_y, gs);
-                    }
-                }
-            }
+            spi_oled_draw_glyph(spi_ssd1327->framebuffer, glyph, char_x, y, right, gs);
         }
         
-        char_x += char_width + 1;  // Character spacing
+        char_x += glyph->width + 1;  // Character spacing
         
         // Stop if we've moved completely past the right edge
         if (char_x >= SSD1327_WIDTH) break;
     }
     
-    if (spi_ssd1327->auto_refresh) {
+    taskENTER_CRITICAL(&spi_ssd1327->dirty_lock);
+    spi_ssd1327->stats.glyph_hits += hits;
+    spi_ssd1327->stats.glyph_misses += misses;
+    taskEXIT_CRITICAL(&spi_ssd1327->dirty_lock);
+    
+    if (spi_ssd1327->auto_refresh && char_x > x) {
         // Calculate visible refresh region
-        int16_t text_width = spi_oled_get_text_width(font, text);
+        int16_t text_width = char_x - x - 1;
         int16_t refresh_x = (x < 0) ? 0 : x;
         int16_t refresh_y = (y < 0) ? 0 : y;
         int16_t refresh_width = (x + text_width > SSD1327_WIDTH) ? SSD1327_WIDTH - refresh_x : text_width;
         int16_t refresh_height = (y + font->height > SSD1327_HEIGHT) ? SSD1327_HEIGHT - refresh_y : font->height;
         
         if (refresh_width > 0 && refresh_height > 0) {
-            spi_oled_framebuffer_refresh_region(spi_ssd1327, refresh_x, refresh_y, 
-                                              refresh_width, refresh_height);
+            spi_oled_invalidate(spi_ssd1327, refresh_x, refresh_y, 
+                                refresh_width, refresh_height);
         }
     }
 }
 
-void spi_oled_drawImage(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
-                       uint8_t width, uint8_t height, const uint8_t *image, uint8_t opacity)
+// Copy n pixels of a 4bpp row, from pixel sx of src to pixel dx of dst.
+// Pixels equal to key (before opacity) are left alone.
+static void spi_oled_blit_row(uint8_t *dst, int16_t dx, const uint8_t *src, int16_t sx,
+                              int16_t n, const uint8_t *lut, int key)
+{
+    #define SRC_PIXEL(i) (((i) & 1) ? (src[(i) / 2] & 0x0F) : (src[(i) / 2] >> 4))
+    
+    // Leading odd destination pixel: the low nibble of its byte
+    if (dx & 1) {
+        uint8_t v = SRC_PIXEL(sx);
+        if (v != key) {
+            dst[dx / 2] = (dst[dx / 2] & 0xF0) | lut[v];
+        }
+        dx++;
+        sx++;
+        n--;
+    }
+    
+    uint8_t *d = &dst[dx / 2];
+    const uint8_t *s = &src[sx / 2];
+    int16_t pairs = n / 2;
+    if (!(sx & 1) && key == BLIT_NO_KEY && lut == opacity_lut[15]) {
+        // Same alignment, opaque: whole bytes
+        memcpy(d, s, pairs);
+    } else if (!(sx & 1) && key == BLIT_NO_KEY) {
+        for (int16_t i = 0; i < pairs; i++) {
+            d[i] = (lut[s[i] >> 4] << 4) | lut[s[i] & 0x0F];
+        }
+    } else if ((sx & 1) && key == BLIT_NO_KEY && lut == opacity_lut[15]) {
+        // Source one pixel out of step: every destination byte takes a
+        // nibble from two source bytes
+        for (int16_t i = 0; i < pairs; i++) {
+            d[i] = (uint8_t)(s[i] << 4) | (s[i + 1] >> 4);
+        }
+    } else if ((sx & 1) && key == BLIT_NO_KEY) {
+        for (int16_t i = 0; i < pairs; i++) {
+            d[i] = (lut[s[i] & 0x0F] << 4) | lut[s[i + 1] >> 4];
+        }
+    } else {
+        // Keyed: a nibble at a time
+        for (int16_t i = 0; i < pairs; i++) {
+            uint8_t hi, lo;
+            if (sx & 1) {
+                hi = s[i] & 0x0F;
+                lo = s[i + 1] >> 4;
+            } else {
+                hi = s[i] >> 4;
+                lo = s[i] & 0x0F;
+            }
+            uint8_t out = d[i];
+            if (hi != key) out = (out & 0x0F) | (lut[hi] << 4);
+            if (lo != key) out = (out & 0xF0) | lut[lo];
+            d[i] = out;
+        }
+    }
+    
+    // Trailing even destination pixel: the high nibble
+    if (n & 1) {
+        uint8_t v = SRC_PIXEL(sx + n - 1);
+        if (v != key) {
+            d[pairs] = (d[pairs] & 0x0F) | (lut[v] << 4);
+        }
+    }
+    #undef SRC_PIXEL
+}
+
+static void spi_oled_blit(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                          uint8_t width, uint8_t height, const uint8_t *image,
+                          uint8_t opacity, int key)
 {
     if (!image || !spi_ssd1327->framebuffer) return;
     
     // Clamp opacity to valid range (0-15 for 4-bit grayscale)
     if (opacity > 15) opacity = 15;
+    const uint8_t *lut = opacity_lut[opacity];
     
     uint8_t image_bytes_per_row = (width + 1) / 2;
     
-    // Calculate clipping boundaries
+    // Calculate clipping boundaries in image coordinates
     int16_t start_row = (y < 0) ? -y : 0;  // Skip rows that are above screen
     int16_t start_col = (x < 0) ? -x : 0;  // Skip columns that are left of screen
     int16_t end_row = height;
     int16_t end_col = width;
-    
-    // Clip to screen boundaries
     if (y + height > SSD1327_HEIGHT) {
-        end_row = SSD1327_HEIGHT - 1 - y;
+        end_row = SSD1327_HEIGHT - y;
     }
     if (x + width > SSD1327_WIDTH) {
         end_col = SSD1327_WIDTH - x;
     }
     
     // If completely outside screen, don't draw
-    if (start_row >= end_row || start_col >= end_col || 
-        y >= SSD1327_HEIGHT || x >= SSD1327_WIDTH ||
-        y + height <= 0 || x + width <= 0) {
+    if (start_row >= end_row || start_col >= end_col) {
         return;
     }
     
     for (int16_t row = start_row; row < end_row; row++) {
-        int16_t screen_y = y + row;
-        if (screen_y < 0 || screen_y >= SSD1327_HEIGHT) continue;
-        
-        for (int16_t col = start_col; col < end_col; col++) {
-            int16_t screen_x = x + col;
-            if (screen_x < 0 || screen_x >= SSD1327_WIDTH) continue;
-            
-            uint8_t byte_idx = col / 2;
-            uint8_t pixel_pos = col % 2;
-            uint8_t image_byte = image[row * image_bytes_per_row + byte_idx];
-            
-            ssd1327_gs_t pixel_value;
-            if (pixel_pos == 0) {
-                pixel_value = (image_byte >> 4) & 0x0F;  // Left pixel
-            } else {
-                pixel_value = image_byte & 0x0F;         // Right pixel
-            }
-            
-            // Apply opacity by scaling the pixel value
-            if (opacity < 15) {
-                uint16_t blended = ((uint16_t)pixel_value * opacity) / 15;
-                pixel_value = (ssd1327_gs_t)blended;
-            }
-            
-            spi_oled_set_pixel(spi_ssd1327, screen_x, screen_y, pixel_value);
-        }
+        spi_oled_blit_row(&spi_ssd1327->framebuffer[(y + row) * (SSD1327_WIDTH / 2)], x + start_col,
+                          &image[row * image_bytes_per_row], start_col,
+                          end_col - start_col, lut, key);
     }
     
     if (spi_ssd1327->auto_refresh) {
         // Only refresh the visible region
-        int16_t refresh_x = (x < 0) ? 0 : x;
-        int16_t refresh_y = (y < 0) ? 0 : y;
-        int16_t refresh_width = (x + width > SSD1327_WIDTH) ? SSD1327_WIDTH - refresh_x : width - start_col;
-        int16_t refresh_height = (y + height > SSD1327_HEIGHT) ? SSD1327_HEIGHT - refresh_y : height - start_row;
-        
-        if (refresh_width > 0 && refresh_height > 0) {
-            spi_oled_framebuffer_refresh_region(spi_ssd1327, refresh_x, refresh_y, 
-                                              refresh_width, refresh_height);
-        }
+        spi_oled_invalidate(spi_ssd1327, x + start_col, y + start_row,
+                            end_col - start_col, end_row - start_row);
     }
 }
 
+void spi_oled_drawImage(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                       uint8_t width, uint8_t height, const uint8_t *image, uint8_t opacity)
+{
+    spi_oled_blit(spi_ssd1327, x, y, width, height, image, opacity, BLIT_NO_KEY);
+}
+
+void spi_oled_drawImage_keyed(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                              uint8_t width, uint8_t height, const uint8_t *image,
+                              uint8_t opacity, ssd1327_gs_t key)
+{
+    spi_oled_blit(spi_ssd1327, x, y, width, height, image, opacity, key);
+}
+
 // Utility functions
 void spi_oled_set_auto_refresh(struct spi_ssd1327 *spi_ssd1327, bool auto_refresh)
 {
@@ -7,6 +7,71 @@
 #define SSD1327_BUFFER_SIZE ((SSD1327_WIDTH * SSD1327_HEIGHT) / 2) // 4bpp = 0.5 bytes per pixel
 #define MAX_BITS_PER_TRANSFER 4096
 
+// Compositor: dirty rectangles kept until the next spi_oled_flush
+#define SSD1327_DIRTY_MAX 8
+#define SSD1327_WINDOW_COST 32 // Bus bytes one extra address window is worth (6 commands + transaction setup)
+
+// Transfer engine: each window is a command transaction and one data
+// transaction, queued with spi_device_queue_trans. DC is driven from the
+// device pre_cb, so the bus device must be added with
+// .pre_cb = spi_oled_pre_transfer_cb, .post_cb = spi_oled_post_transfer_cb,
+// .queue_size = SSD1327_QUEUE_DEPTH, and the bus with
+// .max_transfer_sz >= SSD1327_BUFFER_SIZE.
+#define SSD1327_QUEUE_DEPTH (2 * SSD1327_DIRTY_MAX)
+#define SSD1327_CMD_BYTES 6                                              // Column and row address commands
+#define SSD1327_STAGING_SIZE (SSD1327_BUFFER_SIZE + SSD1327_DIRTY_MAX * 12) // One frame, commands and padding
+
+// Glyph cache: drawText expands each glyph once into runs of inked pixels
+// per row and keeps the most recently used ones
+#define SSD1327_GLYPH_CACHE_SIZE 32 // A bubble message plus the count digits
+#define SSD1327_GLYPH_MAX_ROWS 32  // Taller glyphs are drawn from the font bitmap
+#define SSD1327_GLYPH_MAX_SPANS 48 // Likewise glyphs with more runs (font_30 digits need 36)
+
+// Dirty rectangle, inclusive bounds; x0 even and x1 odd so it covers whole column pairs
+typedef struct
+{
+    uint8_t x0, y0, x1, y1;
+} ssd1327_rect_t;
+
+typedef struct
+{
+    uint32_t bytes;   // Bytes sent to the panel, commands included
+    uint32_t windows; // Address windows written
+    uint32_t flushes; // Flushes that had something to send
+    uint32_t marks;   // Dirty rectangles recorded
+    uint32_t bus_us;      // Time transactions spent on the bus (wraps)
+    uint32_t bus_max_us;  // Longest frame on the bus
+    uint32_t queue_us;    // Time callers spent building and queueing frames (wraps)
+    uint32_t stalls;      // Queue or staging full, the caller had to wait
+    uint32_t glyph_hits;  // Glyphs drawn from the span cache
+    uint32_t glyph_misses; // Glyphs expanded (or drawn from the bitmap)
+} ssd1327_stats_t;
+
+// A cached glyph: span[i] = {x, length}, row r owns spans [row_end[r - 1], row_end[r])
+typedef struct
+{
+    const void *font;      // Key: font and code point, NULL if the slot is free
+    uint32_t codepoint;
+    uint32_t stamp;        // Last use, for eviction
+    const uint8_t *bits;   // Font bitmap of the first stored row
+    uint16_t pitch;        // Bits from one bitmap row to the next
+    uint8_t width;
+    uint8_t top;           // First row with ink
+    uint8_t rows;          // Rows from top to the last row with ink
+    bool spans_ok;         // False if the glyph did not fit; draw from bits
+    uint8_t row_end[SSD1327_GLYPH_MAX_ROWS];
+    uint8_t span[SSD1327_GLYPH_MAX_SPANS][2];
+} ssd1327_glyph_t;
+
+struct spi_ssd1327;
+
+// Per-transaction context for the pre/post callbacks (transaction.user)
+typedef struct
+{
+    struct spi_ssd1327 *dev;
+    uint8_t dc_level;
+} ssd1327_xfer_ctx_t;
+
 struct spi_ssd1327
 {
     uint8_t dc_pin_num;
@@ -14,7 +79,25 @@ struct spi_ssd1327
     spi_device_handle_t *spi_handle;
     uint8_t *framebuffer; // Frame buffer for 4bpp grayscale (8192 bytes)
     bool auto_refresh;    // Auto refresh display after drawing operations
+    bool compose;         // Auto refresh only marks regions dirty; spi_oled_flush sends them
     SemaphoreHandle_t display_mutex;
+    portMUX_TYPE dirty_lock;
+    ssd1327_rect_t dirty[SSD1327_DIRTY_MAX];
+    uint8_t dirty_count;
+    ssd1327_stats_t stats;
+    // Transfer engine, serialized by display_mutex
+    uint8_t *staging;                 // DMA capable: commands and gathered window rows
+    uint16_t staging_used;
+    spi_transaction_t trans[SSD1327_QUEUE_DEPTH];
+    uint8_t trans_head;               // Oldest transaction in flight
+    uint8_t in_flight;
+    ssd1327_xfer_ctx_t ctx_cmd;
+    ssd1327_xfer_ctx_t ctx_data;
+    volatile uint32_t xfer_start_us;  // Set by pre_cb
+    uint32_t frame_bus_start;         // stats.bus_us when the current frame was queued
+    // Text, used from the drawing task only
+    ssd1327_glyph_t glyphs[SSD1327_GLYPH_CACHE_SIZE];
+    uint32_t glyph_clock;
 };
 
 typedef enum
@@ -37,12 +120,31 @@ typedef enum
     SSD1327_GS_15 = 15,
 } ssd1327_gs_t;
 
+// Glyphs beyond ASCII, generated by tools/generate_cjk_font.py: rows from
+// top to top + rows - 1 are bit-packed MSB first without row padding
+typedef struct
+{
+    uint16_t codepoint;
+    uint8_t width;
+    uint8_t top;
+    uint8_t rows;
+    uint16_t offset; // Into data, in bytes
+} packed_glyph_t;
+
+typedef struct
+{
+    uint16_t count;
+    const packed_glyph_t *glyphs; // Sorted by code point
+    const uint8_t *data;
+} packed_font_t;
+
 typedef struct
 {
     uint8_t height;
     const uint8_t *widths;
     const uint16_t *offsets;
     const uint8_t *data;
+    const packed_font_t *extra; // Optional, for UTF-8 text outside ASCII 32-126
 } variable_font_t;
 
 // Core initialization and communication functions
@@ -53,6 +155,11 @@ void spi_oled_send_cmd(struct spi_ssd1327 *spi_ssd1327, uint8_t cmd);
 void spi_oled_send_cmd_arg(struct spi_ssd1327 *spi_ssd1327, uint8_t cmd, uint8_t arg);
 void spi_oled_send_data(struct spi_ssd1327 *spi_ssd1327, void *data, uint32_t data_len_bits);
 
+// Transfer engine
+void spi_oled_pre_transfer_cb(spi_transaction_t *t);
+void spi_oled_post_transfer_cb(spi_transaction_t *t);
+void spi_oled_wait_idle(struct spi_ssd1327 *spi_ssd1327);
+
 // Frame buffer management functions
 bool spi_oled_framebuffer_init(struct spi_ssd1327 *spi_ssd1327);
 void spi_oled_framebuffer_free(struct spi_ssd1327 *spi_ssd1327);
@@ -62,6 +169,15 @@ void spi_oled_framebuffer_refresh_region(struct spi_ssd1327 *spi_ssd1327,
                                          uint8_t x, uint8_t y,
                                          uint8_t width, uint8_t height);
 
+// Compositor: with compose on, drawing calls accumulate dirty rectangles and
+// one spi_oled_flush per display tick sends them as merged address windows
+void spi_oled_set_compose(struct spi_ssd1327 *spi_ssd1327, bool compose);
+void spi_oled_mark_dirty(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                         int16_t width, int16_t height);
+uint8_t spi_oled_merge_rects(ssd1327_rect_t *rects, uint8_t count);
+uint32_t spi_oled_flush(struct spi_ssd1327 *spi_ssd1327);
+void spi_oled_get_stats(struct spi_ssd1327 *spi_ssd1327, ssd1327_stats_t *stats);
+
 // Drawing functions (all operate on frame buffer)
 void spi_oled_set_pixel(struct spi_ssd1327 *spi_ssd1327, uint8_t x, uint8_t y, ssd1327_gs_t gs);
 ssd1327_gs_t spi_oled_get_pixel(struct spi_ssd1327 *spi_ssd1327, uint8_t x, uint8_t y);
@@ -74,13 +190,17 @@ void spi_oled_draw_circle(struct spi_ssd1327 *spi_ssd1327, uint8_t x, uint8_t y,
 void spi_oled_draw_line(struct spi_ssd1327 *spi_ssd1327, uint8_t x0, uint8_t y0,
                         uint8_t x1, uint8_t y1, ssd1327_gs_t gs);
 
-// Text drawing functions
+// Text drawing functions; text is UTF-8, code points the font lacks show as '?'
 void spi_oled_drawText(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
                       const variable_font_t *font, ssd1327_gs_t gs, const char *text, uint8_t max_width);
 
 // Image drawing function
 void spi_oled_drawImage(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
                        uint8_t width, uint8_t height, const uint8_t *image, uint8_t opacity);
+// Same, leaving pixels that equal key untouched (overlays)
+void spi_oled_drawImage_keyed(struct spi_ssd1327 *spi_ssd1327, int16_t x, int16_t y,
+                              uint8_t width, uint8_t height, const uint8_t *image,
+                              uint8_t opacity, ssd1327_gs_t key);
 
 // Utility functions
 void spi_oled_set_auto_refresh(struct spi_ssd1327 *spi_ssd1327, bool auto_refresh);
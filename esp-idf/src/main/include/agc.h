@@ -1,3 +1,17 @@
+#pragma once
+// AGC for received audio
+//
+// Fixed point per call: the RMS of the chunk sets a desired gain, the gain
+// moves towards it at the attack/release rate, and the applied gain ramps
+// linearly sample by sample from the previous value to the new one, so
+// there is no step at chunk boundaries. Only the once-per-chunk gain
+// update touches float (the tuning knobs); the per-sample path is integer.
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
 // AGC Configuration
 #define TARGET_RMS 6000      // Target RMS level (adjust based on your needs)
 #define AGC_ATTACK 0.1f      // How fast to reduce gain when loud
@@ -5,9 +19,161 @@
 #define MIN_GAIN 0.1f        // Minimum gain multiplier
 #define MAX_GAIN 8.0f        // Maximum gain multiplier
 
+#define AGC_REF_SAMPLES 1024 // Attack/release are per chunk of this size, rates scale with the chunk
+#define AGC_Q 15             // Gain state is Q15 in an int32 (MAX_GAIN = 262144)
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define AGC_HAS_PIE 1
+#define AGC_PIE_MAX_BLOCKS 63 // 63 x 8 squares of int16 (each <= 2^30) stay below 2^39, the signed 40-bit ACCX
+#endif
+
 typedef struct {
     float current_gain;
     float target_rms;
     float attack_rate;
     float release_rate;
-} agc_t;
\ No newline at end of file
+    int32_t gain_q15;        // Fixed-point gain, seeded from current_gain when 0
+} agc_t;
+
+static inline uint32_t agc_isqrt(uint32_t x)
+{
+    uint32_t res = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (x >= res + bit)
+        {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+static inline uint64_t agc_energy_scalar(const int16_t *buf, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += (uint32_t)((int32_t)buf[i] * buf[i]);
+    }
+    return sum;
+}
+
+#ifdef AGC_HAS_PIE
+// Sum of squares of blocks of 8 samples, buf 16-byte aligned (EE.VMULAS.S16.ACCX)
+static inline uint64_t agc_energy_pie(const int16_t *buf, size_t blocks)
+{
+    uint64_t sum = 0;
+    while (blocks > 0)
+    {
+        size_t run = blocks < AGC_PIE_MAX_BLOCKS ? blocks : AGC_PIE_MAX_BLOCKS;
+        __asm__ volatile("ee.zero.accx\n");
+        for (size_t i = 0; i < run; i++)
+        {
+            __asm__ volatile(
+                "ee.vld.128.ip q0, %0, 16\n"
+                "ee.vmulas.s16.accx q0, q0\n"
+                : "+r"(buf)
+                :
+                : "memory");
+        }
+        uint32_t part;
+        uint32_t shift = 9; // (504 x 2^30) >> 9 still fits the 32-bit result
+        __asm__ volatile("ee.srs.accx %0, %1, 0\n" : "=r"(part) : "r"(shift));
+        sum += (uint64_t)part << 9;
+        blocks -= run;
+    }
+    return sum;
+}
+#endif
+
+static inline uint64_t agc_energy(const int16_t *buf, size_t n)
+{
+#ifdef AGC_HAS_PIE
+    if (((uintptr_t)buf & 15) == 0)
+    {
+        size_t blocks = n / 8;
+        return agc_energy_pie(buf, blocks) + agc_energy_scalar(buf + blocks * 8, n - blocks * 8);
+    }
+#endif
+    return agc_energy_scalar(buf, n);
+}
+
+// Update the gain from this chunk's level. Returns the gain to ramp from
+// (Q15); the gain to ramp to is left in agc->gain_q15.
+static inline int32_t agc_update(agc_t *agc, const int16_t *buf, size_t n)
+{
+    int32_t g0 = agc->gain_q15;
+    if (g0 == 0)
+    {
+        g0 = (int32_t)(agc->current_gain * (1 << AGC_Q));
+    }
+    if (n == 0)
+    {
+        return g0;
+    }
+
+    // Current RMS level, avoid division by zero
+    uint32_t rms = agc_isqrt((uint32_t)(agc_energy(buf, n) / n));
+    if (rms < 1)
+    {
+        rms = 1;
+    }
+    int64_t desired = ((int64_t)agc->target_rms << AGC_Q) / rms;
+
+    // Attack/release smoothing, rates normalized to AGC_REF_SAMPLES
+    float rate = (desired < g0) ? agc->attack_rate : agc->release_rate;
+    int64_t rate_q15 = (int64_t)(rate * (1 << AGC_Q) * (float)n / AGC_REF_SAMPLES);
+    if (rate_q15 > (1 << AGC_Q))
+    {
+        rate_q15 = 1 << AGC_Q;
+    }
+    int64_t g1 = g0 + (((desired - g0) * rate_q15) >> AGC_Q);
+
+    // Clamp gain to reasonable limits
+    const int32_t min_q15 = (int32_t)(MIN_GAIN * (1 << AGC_Q));
+    const int32_t max_q15 = (int32_t)(MAX_GAIN * (1 << AGC_Q));
+    if (g1 < min_q15)
+        g1 = min_q15;
+    if (g1 > max_q15)
+        g1 = max_q15;
+
+    agc->gain_q15 = (int32_t)g1;
+    agc->current_gain = (float)g1 / (1 << AGC_Q);
+    return g0;
+}
+
+// Apply AGC to a chunk in place, hard clipping at full scale
+// (limiter_process in limiter.h applies the same ramp without clipping)
+static inline void agc_apply(agc_t *agc, int16_t *buf, size_t n)
+{
+    int32_t g0 = agc_update(agc, buf, n);
+    if (n == 0)
+    {
+        return;
+    }
+
+    // Ramp from g0 to g1; the multiply uses Q12 so it stays in 32 bits
+    int32_t step = (agc->gain_q15 - g0) / (int32_t)n;
+    int32_t g = g0;
+    for (size_t i = 0; i < n; i++)
+    {
+        g += step;
+        int32_t v = ((int32_t)buf[i] * (g >> 3)) >> 12;
+        if (v > 32767)
+            v = 32767;
+        if (v < -32768)
+            v = -32768;
+        buf[i] = (int16_t)v;
+    }
+}
@@ -7,7 +7,9 @@ typedef struct
     bool is_playing;
     int stop_frame;
     bool reverse;
-    TaskHandle_t task_handle;
+    // Timeline state, owned by the display task
+    int current_frame;
+    uint32_t next_ms;  // When the next frame is due
 } spi_oled_animation_t;
 
 spi_oled_animation_t anim = {
@@ -19,8 +21,7 @@ spi_oled_animation_t anim = {
     .animation_data = (const uint8_t *)idle_single,
     .frame_delay_ms = 1000 / 5,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_speaking = {
     .x = 10,
@@ -31,8 +32,7 @@ spi_oled_animation_t anim_speaking = {
     .animation_data = (const uint8_t *)speaking_single,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_receiving = {
     .x = 10,
@@ -43,8 +43,7 @@ spi_oled_animation_t anim_receiving = {
     .animation_data = (const uint8_t *)receiving_single,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_idleBar = {
     .x = 10,
@@ -55,8 +54,7 @@ spi_oled_animation_t anim_idleBar = {
     .animation_data = (const uint8_t *)idle_bar,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_waveBar = {
     .x = 1,
@@ -67,8 +65,7 @@ spi_oled_animation_t anim_waveBar = {
     .animation_data = (const uint8_t *)wave_bar,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_idleWaveBar = {
     .x = 1,
@@ -79,8 +76,7 @@ spi_oled_animation_t anim_idleWaveBar = {
     .animation_data = (const uint8_t *)idle_wave_bar,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_podcast = {
     .x = 74,
@@ -91,8 +87,7 @@ spi_oled_animation_t anim_podcast = {
     .animation_data = (const uint8_t *)podcast,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_speaker = {
     .x = 74,
@@ -103,8 +98,7 @@ spi_oled_animation_t anim_speaker = {
     .animation_data = (const uint8_t *)speaker,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_byebye = {
     .x = 0,
@@ -115,7 +109,6 @@ spi_oled_animation_t anim_byebye = {
     .animation_data = (const uint8_t *)byebye_image,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 // custom map
@@ -13,8 +13,7 @@ spi_oled_animation_t anim_turn_left = {
     .animation_data = (const uint8_t *)turn_left,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_turn_right = {
     .x = 14,
@@ -25,8 +24,7 @@ spi_oled_animation_t anim_turn_right = {
     .animation_data = (const uint8_t *)turn_right,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_go_straight = {
     .x = 14,
@@ -37,8 +35,7 @@ spi_oled_animation_t anim_go_straight = {
     .animation_data = (const uint8_t *)go_straight,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_time_out = {
     .x = 14,
@@ -49,8 +46,7 @@ spi_oled_animation_t anim_time_out = {
     .animation_data = (const uint8_t *)time_out,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_wait = {
     .x = 14,
@@ -61,8 +57,7 @@ spi_oled_animation_t anim_wait = {
     .animation_data = (const uint8_t *)wait,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_hello = {
     .x = 8,
@@ -73,8 +68,7 @@ spi_oled_animation_t anim_hello = {
     .animation_data = (const uint8_t *)wave,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_check_mark = {
     .x = 14,
@@ -85,8 +79,7 @@ spi_oled_animation_t anim_check_mark = {
     .animation_data = (const uint8_t *)check_mark,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_help_sos = {
     .x = 14,
@@ -97,8 +90,7 @@ spi_oled_animation_t anim_help_sos = {
     .animation_data = (const uint8_t *)help_sos,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_up_hill = {
     .x = 14,
@@ -109,8 +101,7 @@ spi_oled_animation_t anim_up_hill = {
     .animation_data = (const uint8_t *)up_hill,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_down_hill = {
     .x = 14,
@@ -121,8 +112,7 @@ spi_oled_animation_t anim_down_hill = {
     .animation_data = (const uint8_t *)down_hill,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_slow = {
     .x = 14,
@@ -133,8 +123,7 @@ spi_oled_animation_t anim_slow = {
     .animation_data = (const uint8_t *)slow,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_attention = {
     .x = 14,
@@ -145,8 +134,7 @@ spi_oled_animation_t anim_attention = {
     .animation_data = (const uint8_t *)attention,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_walk = {
     .x = 14,
@@ -157,8 +145,7 @@ spi_oled_animation_t anim_walk = {
     .animation_data = (const uint8_t *)walk,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_add_oil = {
     .x = 14,
@@ -169,8 +156,7 @@ spi_oled_animation_t anim_add_oil = {
     .animation_data = (const uint8_t *)add_oil,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_eat = {
     .x = 14,
@@ -181,8 +167,7 @@ spi_oled_animation_t anim_eat = {
     .animation_data = (const uint8_t *)eat,
     .frame_delay_ms = 1000 / 30,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 spi_oled_animation_t anim_drink = {
     .x = 14,
@@ -193,8 +178,7 @@ spi_oled_animation_t anim_drink = {
     .animation_data = (const uint8_t *)drink,
     .frame_delay_ms = 1000 / 15,
     .stop_frame = -1,
-    .reverse = false,
-    .task_handle = NULL};
+    .reverse = false};
 
 static animation_map_entry_t animation_map[] = {
     {1, &anim_turn_left},
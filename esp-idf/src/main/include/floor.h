@@ -0,0 +1,224 @@
+#pragma once
+// Distributed floor control: who may transmit audio
+//
+// A unit that wants to talk broadcasts FLOOR_OP_REQUEST and waits one grant
+// window. If no one objects it takes the floor and announces it with
+// FLOOR_OP_GRANT; a unit already holding the floor answers any REQUEST with
+// GRANT so the requester backs off. Requests that cross in flight are
+// settled by a tie-break every unit evaluates the same way: the higher
+// priority wins, then the lower MAC. The priority is how many times the
+// unit has recently yielded, so a loser is favoured next round. Audio from
+// another unit counts as an implicit GRANT. The holder sends
+// FLOOR_OP_RELEASE when done; if it goes quiet the floor frees itself
+// after FLOOR_HOLD_TIMEOUT_MS.
+//
+// Plain C, no ESP-IDF dependencies; all times are caller supplied ms.
+// Not thread safe, the caller serializes access.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define FLOOR_GRANT_WINDOW_MS 30   // Longer than one-way latency of a control packet
+#define FLOOR_HOLD_TIMEOUT_MS 300  // Holder silent this long: floor is free
+#define FLOOR_MAX_PRIO 15
+#define FLOOR_MAC_LEN 6
+
+typedef enum
+{
+    FLOOR_IDLE = 0,     // Nobody is known to talk
+    FLOOR_REQUESTING,   // We asked, waiting out the grant window
+    FLOOR_TALKING,      // We hold the floor
+    FLOOR_LISTENING,    // Someone else holds (or is about to take) the floor
+} floor_state_t;
+
+typedef enum
+{
+    FLOOR_OP_NONE = 0xFF, // Nothing to send
+    FLOOR_OP_REQUEST = 0,
+    FLOOR_OP_GRANT = 1,
+    FLOOR_OP_RELEASE = 2,
+} floor_op_t;
+
+typedef struct
+{
+    uint32_t requests;
+    uint32_t granted;
+    uint32_t yielded;     // Lost a tie-break or found the floor taken
+    uint32_t collisions;  // Heard another talker while holding the floor
+} floor_stats_t;
+
+typedef struct
+{
+    floor_state_t state;
+    uint8_t self[FLOOR_MAC_LEN];
+    uint8_t holder[FLOOR_MAC_LEN]; // Valid while LISTENING
+    uint8_t prio;
+    bool have_next;                // A request heard while listening, valid until next_ms
+    uint8_t next[FLOOR_MAC_LEN];
+    uint8_t next_prio;
+    uint32_t next_ms;
+    uint32_t deadline_ms;          // End of the grant window, or of the holder's lease
+    floor_stats_t stats;
+} floor_ctl_t;
+
+static inline void floor_init(floor_ctl_t *f, const uint8_t *self_mac)
+{
+    memset(f, 0, sizeof(*f));
+    memcpy(f->self, self_mac, FLOOR_MAC_LEN);
+    f->state = FLOOR_IDLE;
+}
+
+// True if a (prio_a, mac_a) request beats (prio_b, mac_b)
+static inline bool floor_wins(uint8_t prio_a, const uint8_t *mac_a, uint8_t prio_b, const uint8_t *mac_b)
+{
+    if (prio_a != prio_b)
+    {
+        return prio_a > prio_b;
+    }
+    return memcmp(mac_a, mac_b, FLOOR_MAC_LEN) < 0;
+}
+
+static inline void floor_listen(floor_ctl_t *f, const uint8_t *holder, uint32_t now_ms, uint32_t lease_ms)
+{
+    if (f->state == FLOOR_REQUESTING || f->state == FLOOR_TALKING)
+    {
+        f->stats.yielded++;
+        if (f->prio < FLOOR_MAX_PRIO)
+        {
+            f->prio++;
+        }
+    }
+    f->state = FLOOR_LISTENING;
+    memcpy(f->holder, holder, FLOOR_MAC_LEN);
+    f->deadline_ms = now_ms + lease_ms;
+}
+
+// We have something to say. Returns the op to broadcast.
+static inline floor_op_t floor_want_talk(floor_ctl_t *f, uint32_t now_ms)
+{
+    if (f->state != FLOOR_IDLE)
+    {
+        return FLOOR_OP_NONE;
+    }
+    f->state = FLOOR_REQUESTING;
+    f->deadline_ms = now_ms + FLOOR_GRANT_WINDOW_MS;
+    f->stats.requests++;
+    return FLOOR_OP_REQUEST;
+}
+
+// Advance timers. Returns the op to broadcast.
+static inline floor_op_t floor_tick(floor_ctl_t *f, uint32_t now_ms)
+{
+    if ((int32_t)(now_ms - f->deadline_ms) < 0)
+    {
+        return FLOOR_OP_NONE;
+    }
+    if (f->state == FLOOR_REQUESTING)
+    {
+        f->state = FLOOR_TALKING;
+        f->stats.granted++;
+        f->prio = 0;
+        return FLOOR_OP_GRANT;
+    }
+    if (f->state == FLOOR_LISTENING)
+    {
+        f->state = FLOOR_IDLE;
+    }
+    return FLOOR_OP_NONE;
+}
+
+// Done talking. Returns the op to broadcast.
+static inline floor_op_t floor_release(floor_ctl_t *f)
+{
+    if (f->state == FLOOR_TALKING || f->state == FLOOR_REQUESTING)
+    {
+        f->state = FLOOR_IDLE;
+        return FLOOR_OP_RELEASE;
+    }
+    return FLOOR_OP_NONE;
+}
+
+// A floor message from src. Returns the op to broadcast in reply.
+static inline floor_op_t floor_on_op(floor_ctl_t *f, const uint8_t *src, floor_op_t op, uint8_t prio, uint32_t now_ms)
+{
+    switch (op)
+    {
+    case FLOOR_OP_REQUEST:
+        if (f->state == FLOOR_TALKING)
+        {
+            return FLOOR_OP_GRANT; // Still ours
+        }
+        if (f->state == FLOOR_REQUESTING && floor_wins(f->prio, f->self, prio, src))
+        {
+            return FLOOR_OP_NONE; // They will yield to our request
+        }
+        if (f->state == FLOOR_LISTENING)
+        {
+            // The holder answers for the floor, but if it has just released,
+            // this request is the next in line; remember the best one
+            if (!f->have_next || (int32_t)(now_ms - f->next_ms) >= 0 ||
+                floor_wins(prio, src, f->next_prio, f->next))
+            {
+                f->have_next = true;
+                memcpy(f->next, src, FLOOR_MAC_LEN);
+                f->next_prio = prio;
+                f->next_ms = now_ms + FLOOR_GRANT_WINDOW_MS;
+            }
+            return FLOOR_OP_NONE;
+        }
+        floor_listen(f, src, now_ms, FLOOR_GRANT_WINDOW_MS + FLOOR_HOLD_TIMEOUT_MS);
+        return FLOOR_OP_NONE;
+    case FLOOR_OP_GRANT:
+        if (f->state == FLOOR_TALKING)
+        {
+            f->stats.collisions++;
+            if (floor_wins(f->prio, f->self, prio, src))
+            {
+                return FLOOR_OP_GRANT;
+            }
+        }
+        floor_listen(f, src, now_ms, FLOOR_HOLD_TIMEOUT_MS);
+        return FLOOR_OP_NONE;
+    case FLOOR_OP_RELEASE:
+        if (f->state == FLOOR_LISTENING && memcmp(f->holder, src, FLOOR_MAC_LEN) == 0)
+        {
+            f->state = FLOOR_IDLE;
+            if (f->have_next && (int32_t)(now_ms - f->next_ms) < 0)
+            {
+                // Someone asked while the release was in flight: they go first
+                f->state = FLOOR_LISTENING;
+                memcpy(f->holder, f->next, FLOOR_MAC_LEN);
+                f->deadline_ms = now_ms + FLOOR_GRANT_WINDOW_MS + FLOOR_HOLD_TIMEOUT_MS;
+            }
+            f->have_next = false;
+        }
+        return FLOOR_OP_NONE;
+    default:
+        return FLOOR_OP_NONE;
+    }
+}
+
+// Audio from src: the sender holds the floor (an implicit GRANT with no priority)
+static inline void floor_on_audio(floor_ctl_t *f, const uint8_t *src, uint32_t now_ms)
+{
+    if (f->state == FLOOR_TALKING)
+    {
+        f->stats.collisions++;
+        if (memcmp(f->self, src, FLOOR_MAC_LEN) < 0)
+        {
+            return;
+        }
+    }
+    if (f->state == FLOOR_LISTENING && memcmp(f->holder, src, FLOOR_MAC_LEN) == 0)
+    {
+        f->deadline_ms = now_ms + FLOOR_HOLD_TIMEOUT_MS;
+        return;
+    }
+    floor_listen(f, src, now_ms, FLOOR_HOLD_TIMEOUT_MS);
+}
+
+static inline bool floor_may_send(const floor_ctl_t *f)
+{
+    return f->state == FLOOR_TALKING;
+}
@@ -0,0 +1,291 @@
+// Generated by tools/generate_cjk_font.py, do not edit
+// Font height: 10 pixels, variable width
+// 63 glyphs from the speech command vocabularies
+// Total size: 756 bytes (1260 row-padded)
+
+// Glyph table, sorted by code point
+const packed_glyph_t font_cjk_10_glyphs[63] = {
+    {0x4E0A, 10, 1, 9, 0}, // '上'
+    {0x4E0B, 10, 1, 9, 12}, // '下'
+    {0x4E1C, 10, 1, 9, 24}, // '东'
+    {0x4E86, 10, 1, 9, 36}, // '了'
+    {0x4EBA, 10, 1, 9, 48}, // '人'
+    {0x4F11, 10, 1, 9, 60}, // '休'
+    {0x4FDD, 10, 1, 9, 72}, // '保'
+    {0x505C, 10, 1, 9, 84}, // '停'
+    {0x50CF, 10, 1, 9, 96}, // '像'
+    {0x5168, 10, 1, 9, 108}, // '全'
+    {0x51CF, 10, 1, 9, 120}, // '减'
+    {0x5230, 10, 1, 9, 132}, // '到'
+    {0x524D, 10, 1, 9, 144}, // '前'
+    {0x52A0, 10, 1, 9, 156}, // '加'
+    {0x53D8, 10, 1, 9, 168}, // '变'
+    {0x53F3, 10, 1, 9, 180}, // '右'
+    {0x5403, 10, 1, 9, 192}, // '吃'
+    {0x5417, 10, 1, 9, 204}, // '吗'
+    {0x559D, 10, 1, 9, 216}, // '喝'
+    {0x56DE, 10, 1, 9, 228}, // '回'
+    {0x5728, 10, 1, 9, 240}, // '在'
+    {0x5761, 10, 1, 9, 252}, // '坡'
+    {0x5927, 10, 1, 9, 264}, // '大'
+    {0x5934, 10, 1, 9, 276}, // '头'
+    {0x59CB, 10, 1, 9, 288}, // '始'
+    {0x5B89, 10, 1, 9, 300}, // '安'
+    {0x5C0F, 10, 1, 9, 312}, // '小'
+    {0x5DE6, 10, 1, 9, 324}, // '左'
+    {0x5F00, 10, 1, 9, 336}, // '开'
+    {0x5F55, 10, 1, 9, 348}, // '录'
+    {0x606F, 10, 1, 9, 360}, // '息'
+    {0x610F, 10, 1, 9, 372}, // '意'
+    {0x6162, 10, 1, 9, 384}, // '慢'
+    {0x6211, 10, 1, 9, 396}, // '我'
+    {0x6301, 10, 1, 9, 408}, // '持'
+    {0x63F4, 10, 1, 9, 420}, // '援'
+    {0x652F, 10, 1, 9, 432}, // '支'
+    {0x6536, 10, 1, 9, 444}, // '收'
+    {0x653E, 10, 1, 9, 456}, // '放'
+    {0x6682, 10, 1, 9, 468}, // '暂'
+    {0x6709, 10, 1, 9, 480}, // '有'
+    {0x6B62, 10, 1, 9, 492}, // '止'
+    {0x6C34, 10, 1, 9, 504}, // '水'
+    {0x6C42, 10, 1, 9, 516}, // '求'
+    {0x6CB9, 10, 1, 9, 528}, // '油'
+    {0x6CE8, 10, 1, 9, 540}, // '注'
+    {0x7126, 10, 1, 9, 552}, // '焦'
+    {0x76F4, 10, 1, 9, 564}, // '直'
+    {0x7AD9, 10, 1, 9, 576}, // '站'
+    {0x7B49, 10, 1, 9, 588}, // '等'
+    {0x7B54, 10, 1, 9, 600}, // '答'
+    {0x7F29, 10, 1, 9, 612}, // '缩'
+    {0x884C, 10, 1, 9, 624}, // '行'
+    {0x897F, 10, 1, 9, 636}, // '西'
+    {0x8BF7, 10, 1, 9, 648}, // '请'
+    {0x8D70, 10, 1, 9, 660}, // '走'
+    {0x8DEF, 10, 1, 9, 672}, // '路'
+    {0x8F66, 10, 1, 9, 684}, // '车'
+    {0x8F6C, 10, 1, 9, 696}, // '转'
+    {0x901F, 10, 1, 9, 708}, // '速'
+    {0x955C, 10, 1, 9, 720}, // '镜'
+    {0x9762, 10, 1, 9, 732}, // '面'
+    {0x997F, 10, 1, 9, 744} // '饿'
+};
+
+// Bit-packed glyph rows, MSB first, no row padding
+const uint8_t font_cjk_10_data[756] = {
+    // '上' (U+4E0A) - 10x9 pixels
+    0x08,0x02,0x00,0x80,0x3C,0x08,0x02,0x00,
+    0x80,0x20,0xFF,0x80,
+    // '下' (U+4E0B) - 10x9 pixels
+    0xFF,0x82,0x00,0x80,0x30,0x0A,0x02,0x40,
+    0x80,0x20,0x08,0x00,
+    // '东' (U+4E1C) - 10x9 pixels
+    0x10,0x3F,0xE2,0x01,0x20,0x7F,0x02,0x04,
+    0x92,0x22,0x18,0x00,
+    // '了' (U+4E86) - 10x9 pixels
+    0x7F,0x80,0x20,0x10,0x18,0x04,0x01,0x00,
+    0x40,0x10,0x1C,0x00,
+    // '人' (U+4EBA) - 10x9 pixels
+    0x08,0x02,0x00,0x80,0x20,0x14,0x05,0x02,
+    0x21,0x04,0x80,0x80,
+    // '休' (U+4F11) - 10x9 pixels
+    0x24,0x09,0x05,0xFB,0x10,0x4E,0x15,0x46,
+    0x49,0x10,0x44,0x00,
+    // '保' (U+4FDD) - 10x9 pixels
+    0x2F,0x8A,0x24,0x8B,0x3E,0x42,0x17,0xE4,
+    0x71,0x2A,0x52,0x00,
+    // '停' (U+505C) - 10x9 pixels
+    0x22,0x0F,0xE4,0x93,0x24,0x5F,0x94,0x24,
+    0xF1,0x08,0x46,0x00,
+    // '像' (U+50CF) - 10x9 pixels
+    0x2F,0x0C,0x45,0xFB,0x52,0x5F,0x92,0xA5,
+    0x71,0x2A,0x56,0x80,
+    // '全' (U+5168) - 10x9 pixels
+    0x1C,0x08,0x84,0x12,0xFA,0x08,0x1F,0xC0,
+    0x80,0x20,0xFF,0x80,
+    // '减' (U+51CF) - 10x9 pixels
+    0x02,0xA7,0xE5,0x20,0x78,0x12,0x97,0xA9,
+    0x32,0xB4,0x22,0x80,
+    // '到' (U+5230) - 10x9 pixels
+    0xF8,0x88,0xA4,0xAB,0xEA,0x22,0xBE,0xA2,
+    0x28,0xE2,0xC1,0x80,
+    // '前' (U+524D) - 10x9 pixels
+    0x24,0x3F,0xE0,0x03,0xD2,0x94,0xBD,0x29,
+    0x4B,0xC2,0x91,0x80,
+    // '加' (U+52A0) - 10x9 pixels
+    0x20,0x08,0xEF,0xA9,0x2A,0x4A,0x92,0xA8,
+    0xAA,0x2A,0x33,0x80,
+    // '变' (U+53D8) - 10x9 pixels
+    0x08,0x3F,0xE1,0x41,0x54,0x94,0x9F,0xC2,
+    0x20,0x70,0xE3,0x80,
+    // '右' (U+53F3) - 10x9 pixels
+    0x08,0x3F,0xE1,0x00,0x40,0x3F,0x18,0x4A,
+    0x10,0x84,0x3F,0x00,
+    // '吃' (U+5403) - 10x9 pixels
+    0x08,0x3B,0xEB,0x02,0xBE,0xA2,0x29,0x0A,
+    0x8B,0xA2,0x0F,0x80,
+    // '吗' (U+5417) - 10x9 pixels
+    0x0F,0x38,0x4A,0x92,0xA4,0xAF,0xA8,0x2F,
+    0xE8,0x02,0x01,0x80,
+    // '喝' (U+559D) - 10x9 pixels
+    0x1F,0x3C,0x49,0xF2,0x44,0x9F,0xA2,0x29,
+    0x2B,0xF2,0x03,0x00,
+    // '回' (U+56DE) - 10x9 pixels
+    0xFF,0xA0,0x2B,0xEA,0x8A,0xA2,0xA8,0xAB,
+    0xEA,0x02,0xFF,0x80,
+    // '在' (U+5728) - 10x9 pixels
+    0x10,0x3F,0xE2,0x00,0x90,0x44,0x37,0xC4,
+    0x41,0x10,0x5F,0x80,
+    // '坡' (U+5761) - 10x9 pixels
+    0x42,0x17,0xEF,0x29,0x48,0x5F,0x95,0x25,
+    0x4B,0x8C,0x1C,0x80,
+    // '大' (U+5927) - 10x9 pixels
+    0x08,0x02,0x0F,0xF8,0x20,0x08,0x05,0x01,
+    0x40,0x88,0xC1,0x80,
+    // '头' (U+5934) - 10x9 pixels
+    0x24,0x05,0x04,0x40,0x90,0x08,0x3F,0xE1,
+    0x20,0x84,0xC0,0x80,
+    // '始' (U+59CB) - 10x9 pixels
+    0x22,0x08,0x8F,0x49,0x5E,0x90,0x19,0xE2,
+    0x49,0x52,0x97,0x80,
+    // '安' (U+5B89) - 10x9 pixels
+    0x08,0x3F,0xE8,0x08,0x40,0xFF,0x88,0x82,
+    0x20,0xF0,0xC3,0x80,
+    // '小' (U+5C0F) - 10x9 pixels
+    0x08,0x02,0x04,0x91,0x24,0x48,0xA2,0x28,
+    0x88,0x20,0x18,0x00,
+    // '左' (U+5DE6) - 10x9 pixels
+    0x10,0x3F,0xE2,0x00,0x80,0x5F,0x91,0x08,
+    0x42,0x10,0x3F,0x80,
+    // '开' (U+5F00) - 10x9 pixels
+    0xFF,0x88,0x82,0x20,0x88,0xFF,0x88,0x84,
+    0x21,0x08,0x82,0x00,
+    // '录' (U+5F55) - 10x9 pixels
+    0x7F,0x00,0x47,0xF0,0x04,0xFF,0x92,0x42,
+    0xE1,0x24,0x98,0x80,
+    // '息' (U+606F) - 10x9 pixels
+    0x10,0x1F,0xC4,0x11,0xFC,0x41,0x1F,0xC0,
+    0x82,0x94,0xBE,0x80,
+    // '意' (U+610F) - 10x9 pixels
+    0x08,0x1F,0xC2,0x23,0xFE,0x41,0x1F,0xC0,
+    0x82,0x94,0xBE,0x80,
+    // '慢' (U+6162) - 10x9 pixels
+    0x2F,0x0A,0x4A,0x92,0xFE,0xAA,0xAF,0xEA,
+    0x90,0x98,0x39,0x80,
+    // '我' (U+6211) - 10x9 pixels
+    0x15,0x39,0x22,0x43,0xFE,0x24,0x0D,0x4E,
+    0x20,0x8A,0x6D,0x80,
+    // '持' (U+6301) - 10x9 pixels
+    0x44,0x17,0xEE,0x41,0x7E,0x41,0x37,0xE4,
+    0x11,0x44,0xCB,0x00,
+    // '援' (U+63F4) - 10x9 pixels
+    0x5F,0x92,0xAE,0x11,0x7E,0x44,0x1F,0xEC,
+    0x91,0x38,0xF1,0x80,
+    // '支' (U+652F) - 10x9 pixels
+    0x08,0x3F,0xE0,0x80,0x20,0x7F,0x10,0x42,
+    0x20,0x70,0xE3,0x80,
+    // '收' (U+6536) - 10x9 pixels
+    0x28,0x2B,0xEA,0x92,0xC4,0xA5,0x29,0x4E,
+    0x22,0x98,0x39,0x80,
+    // '放' (U+653E) - 10x9 pixels
+    0x44,0x3F,0xE4,0x91,0x04,0x75,0x25,0x49,
+    0x20,0x58,0x69,0x80,
+    // '暂' (U+6682) - 10x9 pixels
+    0x27,0xBF,0x05,0x79,0x54,0xFF,0x10,0x47,
+    0xF1,0x04,0x7F,0x00,
+    // '有' (U+6709) - 10x9 pixels
+    0x10,0x3F,0xE2,0x01,0xFC,0xA1,0x0F,0xC2,
+    0x10,0xFC,0x21,0x00,
+    // '止' (U+6B62) - 10x9 pixels
+    0x08,0x02,0x00,0x81,0x20,0x4F,0x12,0x04,
+    0x81,0x20,0xFF,0x80,
+    // '水' (U+6C34) - 10x9 pixels
+    0x08,0x02,0x2E,0x90,0xA8,0x2A,0x12,0x44,
+    0x8A,0x22,0x18,0x00,
+    // '求' (U+6C42) - 10x9 pixels
+    0x08,0xBF,0xE0,0x81,0x22,0x2D,0x06,0x82,
+    0x93,0x22,0x18,0x00,
+    // '油' (U+6CB9) - 10x9 pixels
+    0x82,0x10,0x81,0xFA,0x4A,0x52,0x87,0xE1,
+    0x29,0x4A,0x9F,0x80,
+    // '注' (U+6CE8) - 10x9 pixels
+    0x84,0x10,0x81,0xFA,0x08,0x42,0x03,0xE2,
+    0x21,0x08,0x9F,0x80,
+    // '焦' (U+7126) - 10x9 pixels
+    0x24,0x1F,0xC4,0x83,0xFC,0x48,0x1F,0xC0,
+    0x01,0x54,0x8A,0x80,
+    // '直' (U+76F4) - 10x9 pixels
+    0x08,0x3F,0xE0,0x81,0xFC,0x41,0x1F,0xC4,
+    0x11,0x04,0xFF,0x80,
+    // '站' (U+7AD9) - 10x9 pixels
+    0x42,0x08,0x8F,0xB8,0x48,0x52,0x17,0xE2,
+    0x88,0xE2,0xCF,0x80,
+    // '等' (U+7B49) - 10x9 pixels
+    0x44,0x1D,0xEA,0x90,0x20,0x7F,0x00,0x8F,
+    0xF8,0x88,0x16,0x00,
+    // '答' (U+7B54) - 10x9 pixels
+    0x44,0x1D,0xEA,0x90,0x48,0x3D,0x10,0x2B,
+    0xF0,0x84,0x3F,0x00,
+    // '缩' (U+7F29) - 10x9 pixels
+    0x24,0x17,0xE8,0xAB,0xA8,0x57,0xA5,0x2F,
+    0x78,0x52,0xF7,0x80,
+    // '行' (U+884C) - 10x9 pixels
+    0x4F,0xA0,0x02,0x01,0x7E,0xC1,0x10,0x44,
+    0x11,0x04,0x47,0x00,
+    // '西' (U+897F) - 10x9 pixels
+    0xFF,0x85,0x0F,0xFA,0x52,0x94,0xA9,0xEC,
+    0x0A,0x02,0xFF,0x80,
+    // '请' (U+8BF7) - 10x9 pixels
+    0x82,0x13,0xE0,0x23,0x7E,0x48,0x93,0xE4,
+    0x89,0xBE,0x48,0x80,
+    // '走' (U+8D70) - 10x9 pixels
+    0x08,0x1F,0xC0,0x83,0xFE,0x08,0x0B,0xC2,
+    0x80,0xE0,0xC7,0x80,
+    // '路' (U+8DEF) - 10x9 pixels
+    0xF7,0xA6,0x29,0x53,0xCC,0x24,0xAE,0x0A,
+    0x7A,0x92,0xFF,0x80,
+    // '车' (U+8F66) - 10x9 pixels
+    0x10,0x1F,0xC1,0x00,0x90,0x7F,0x01,0x0F,
+    0xF8,0x10,0x04,0x00,
+    // '转' (U+8F6C) - 10x9 pixels
+    0x22,0x3B,0xE4,0x22,0xBE,0xF4,0x09,0xE3,
+    0x0B,0x92,0x23,0x00,
+    // '速' (U+901F) - 10x9 pixels
+    0x84,0x17,0xC0,0x40,0x7C,0xD5,0x17,0xC4,
+    0xC1,0x54,0xBF,0x80,
+    // '镜' (U+955C) - 10x9 pixels
+    0x42,0x1B,0xE8,0x53,0xD4,0x4F,0xBE,0x24,
+    0xF9,0x94,0x49,0x80,
+    // '面' (U+9762) - 10x9 pixels
+    0xFF,0x82,0x0F,0xFA,0x8A,0xBE,0xA8,0xAB,
+    0xEA,0x8A,0xFF,0x80,
+    // '饿' (U+997F) - 10x9 pixels
+    0x46,0x9E,0xAA,0xA1,0x7E,0x4A,0x13,0xA5,
+    0x91,0xAA,0x5C,0x80
+};
+
+// Pinyin command string -> display text
+const char *const font_cjk_10_phrases[][2] = {
+    {"qian mian zuo zhuan", "前面左转"},
+    {"qian mian you zhuan", "前面右转"},
+    {"bao chi zhi xing", "保持直行"},
+    {"ting che xiu xi", "停车休息"},
+    {"zan ting xiu xi", "暂停休息"},
+    {"deng deng wo", "等等我"},
+    {"you ren zai ma", "有人在吗"},
+    {"shou dao qing hui da", "收到请回答"},
+    {"shou dao le", "收到了"},
+    {"qing qiu zhi yuan", "请求支援"},
+    {"shang po lu", "上坡路"},
+    {"xia po lu", "下坡路"},
+    {"jian su man xing", "减速慢行"},
+    {"zhu yi an quan", "注意安全"},
+    {"kai shi zou lu", "开始走路"},
+    {"wo e le", "我饿了"},
+    {"chi dong xi", "吃东西"},
+    {"he shui le", "喝水了"},
+    {"jia you zhan", "加油站"},
+    {"kai shi lu xiang", "开始录像"},
+    {"jing tou fang da", "镜头放大"},
+    {"jing tou suo xiao", "镜头缩小"},
+    {"ting zhi bian jiao", "停止变焦"}
+};
@@ -0,0 +1,322 @@
+#pragma once
+// Sequence-aware adaptive jitter buffer for received audio frames
+//
+// Frames are stored by sequence number and released when their playout
+// deadline (sender timestamp + playout offset) has passed. The offset is
+// anchored at the start of each stream from the measured transit time plus
+// a target delay derived from the interarrival jitter (RFC 3550 estimator).
+// After an underrun the next arriving frame re-anchors playout, so the
+// delay grows only when the link actually needs it. When packets carry
+// redundant copies of the previous frames the target also covers the extra
+// frame times the last copy of each frame takes to arrive.
+//
+// Plain C, no ESP-IDF dependencies; all times are caller supplied ms.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define JB_SLOTS 8             // Must cover max delay / frame duration
+#define JB_MAX_PAYLOAD 512
+#define JB_JITTER_MULT 3       // Target delay = (1 + redundancy) * frame + JB_JITTER_MULT * jitter
+
+typedef enum
+{
+    JB_EMPTY = 0,   // Nothing due yet
+    JB_FRAME,       // A frame was copied out
+    JB_MISSING,     // The due frame was lost, later frames are waiting (conceal it)
+    JB_UNDERRUN,    // Buffer ran dry past the deadline, playout will re-anchor
+} jb_result_t;
+
+typedef struct
+{
+    bool used;
+    uint16_t seq;
+    uint32_t ts;
+    uint16_t len;
+    uint32_t arrival_ms;        // When the packet carrying it was received
+    uint8_t data[JB_MAX_PAYLOAD];
+} jb_slot_t;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t played;
+    uint32_t missing;    // Frames skipped as lost
+    uint32_t late;       // Arrived after their slot was played or skipped
+    uint32_t duplicate;
+    uint32_t overrun;    // Frames dropped because the window was full
+    uint32_t underrun;
+} jb_stats_t;
+
+typedef struct
+{
+    jb_slot_t slots[JB_SLOTS];
+    bool active;
+    bool rebuffer;
+    uint8_t stream_id;
+    uint16_t next_seq;
+    uint32_t next_ts;           // Sender timestamp expected for next_seq
+    int32_t offset_ms;          // Playout time = ts + offset_ms
+    bool have_transit;
+    int32_t last_transit;
+    uint32_t jitter_q4;         // Interarrival jitter in ms, Q4
+    uint16_t frame_ms;
+    uint16_t min_delay_ms;
+    uint16_t max_delay_ms;
+    uint16_t target_delay_ms;
+    uint8_t red_level;          // Redundant copies per packet on this stream
+    uint8_t red_absorbed;       // Redundancy level offset_ms currently covers
+    uint32_t put_ms;            // Arrival time of the last jb_put, stamps its redundant copies too
+    uint32_t played_arrival_ms; // Arrival time of the last frame jb_get returned
+    jb_stats_t stats;
+} jitter_buffer_t;
+
+static inline void jb_init(jitter_buffer_t *jb, uint16_t frame_ms, uint16_t min_delay_ms, uint16_t max_delay_ms)
+{
+    memset(jb, 0, sizeof(*jb));
+    jb->frame_ms = frame_ms;
+    jb->min_delay_ms = min_delay_ms;
+    jb->max_delay_ms = max_delay_ms;
+    jb->target_delay_ms = min_delay_ms;
+}
+
+// End of stream: drop queued frames but keep the jitter estimate
+static inline void jb_reset(jitter_buffer_t *jb)
+{
+    for (int i = 0; i < JB_SLOTS; i++)
+    {
+        jb->slots[i].used = false;
+    }
+    jb->active = false;
+    jb->rebuffer = false;
+    jb->have_transit = false;
+}
+
+static inline uint16_t jb_jitter_ms(const jitter_buffer_t *jb)
+{
+    return (uint16_t)(jb->jitter_q4 >> 4);
+}
+
+static inline int jb_depth(const jitter_buffer_t *jb)
+{
+    int depth = 0;
+    for (int i = 0; i < JB_SLOTS; i++)
+    {
+        depth += jb->slots[i].used;
+    }
+    return depth;
+}
+
+static inline void jb_update_target(jitter_buffer_t *jb)
+{
+    uint32_t target = (1u + jb->red_level) * jb->frame_ms + JB_JITTER_MULT * jb_jitter_ms(jb);
+    if (target < jb->min_delay_ms)
+        target = jb->min_delay_ms;
+    if (target > jb->max_delay_ms)
+        target = jb->max_delay_ms;
+    jb->target_delay_ms = (uint16_t)target;
+}
+
+static inline void jb_anchor(jitter_buffer_t *jb, uint16_t seq, uint32_t ts, int32_t transit)
+{
+    jb_update_target(jb);
+    jb->next_seq = seq;
+    jb->next_ts = ts;
+    jb->offset_ms = transit + jb->target_delay_ms;
+    jb->red_absorbed = jb->red_level;
+    jb->rebuffer = false;
+}
+
+// Redundancy level of the next packet, set before its jb_put. The copy of
+// frame n at level L rides on packet n + L, L frame times later, so a level
+// above what playout was anchored with pushes the live playout point back at
+// once; a lower level only shortens the delay at the next anchor.
+static inline void jb_set_redundancy(jitter_buffer_t *jb, uint8_t level)
+{
+    jb->red_level = level;
+    if (!jb->active || jb->rebuffer || level <= jb->red_absorbed)
+    {
+        return;
+    }
+    uint32_t target = jb->target_delay_ms + (uint32_t)(level - jb->red_absorbed) * jb->frame_ms;
+    if (target > jb->max_delay_ms)
+        target = jb->max_delay_ms;
+    if (target > jb->target_delay_ms)
+    {
+        jb->offset_ms += (int32_t)(target - jb->target_delay_ms);
+        jb->target_delay_ms = (uint16_t)target;
+    }
+    jb->red_absorbed = level;
+}
+
+static inline void jb_store(jb_slot_t *slot, uint16_t seq, uint32_t ts, const uint8_t *data, size_t len, uint32_t arrival_ms)
+{
+    slot->used = true;
+    slot->seq = seq;
+    slot->ts = ts;
+    slot->len = (uint16_t)len;
+    slot->arrival_ms = arrival_ms;
+    memcpy(slot->data, data, len);
+}
+
+// Insert a received frame; now_ms is its arrival time. Returns false if it was dropped.
+static inline bool jb_put(jitter_buffer_t *jb, uint8_t stream_id, uint16_t seq, uint32_t ts,
+                          const uint8_t *data, size_t len, uint32_t now_ms)
+{
+    if (len > JB_MAX_PAYLOAD)
+    {
+        return false;
+    }
+
+    int32_t transit = (int32_t)(now_ms - ts);
+    jb->put_ms = now_ms;
+    if (!jb->active || stream_id != jb->stream_id)
+    {
+        jb_reset(jb);
+        jb->active = true;
+        jb->stream_id = stream_id;
+        jb_anchor(jb, seq, ts, transit);
+    }
+
+    // Interarrival jitter, J += (|D| - J) / 16
+    if (jb->have_transit)
+    {
+        int32_t d = transit - jb->last_transit;
+        if (d < 0)
+            d = -d;
+        jb->jitter_q4 += (uint32_t)d - ((jb->jitter_q4 + 8) >> 4);
+    }
+    jb->last_transit = transit;
+    jb->have_transit = true;
+    jb->stats.received++;
+
+    int16_t diff = (int16_t)(seq - jb->next_seq);
+    if (jb->rebuffer && diff >= 0)
+    {
+        jb_anchor(jb, seq, ts, transit);
+        diff = 0;
+    }
+    if (diff < 0)
+    {
+        jb->stats.late++;
+        return false;
+    }
+
+    // Window full: give up the oldest frames to make room
+    while (diff >= JB_SLOTS)
+    {
+        jb_slot_t *old = &jb->slots[jb->next_seq % JB_SLOTS];
+        if (old->used && old->seq == jb->next_seq)
+        {
+            old->used = false;
+            jb->stats.overrun++;
+        }
+        jb->next_seq++;
+        jb->next_ts += jb->frame_ms;
+        diff--;
+    }
+
+    jb_slot_t *slot = &jb->slots[seq % JB_SLOTS];
+    if (slot->used && slot->seq == seq)
+    {
+        jb->stats.duplicate++;
+        return false;
+    }
+    jb_store(slot, seq, ts, data, len, now_ms);
+    return true;
+}
+
+// True if seq belongs to the current stream and its slot is still waiting to be filled
+static inline bool jb_wants(const jitter_buffer_t *jb, uint8_t stream_id, uint16_t seq)
+{
+    if (!jb->active || jb->rebuffer || stream_id != jb->stream_id)
+    {
+        return false;
+    }
+    int16_t diff = (int16_t)(seq - jb->next_seq);
+    if (diff < 0 || diff >= JB_SLOTS)
+    {
+        return false;
+    }
+    const jb_slot_t *slot = &jb->slots[seq % JB_SLOTS];
+    return !(slot->used && slot->seq == seq);
+}
+
+// Fill a hole from a redundant copy. Doesn't touch the jitter estimate or
+// the late/duplicate counters; returns true only if the frame was missing.
+static inline bool jb_put_redundant(jitter_buffer_t *jb, uint8_t stream_id, uint16_t seq, uint32_t ts,
+                                    const uint8_t *data, size_t len)
+{
+    if (len > JB_MAX_PAYLOAD || !jb_wants(jb, stream_id, seq))
+    {
+        return false;
+    }
+    jb_store(&jb->slots[seq % JB_SLOTS], seq, ts, data, len, jb->put_ms);
+    return true;
+}
+
+// Take the next frame if its playout deadline has passed
+static inline jb_result_t jb_get(jitter_buffer_t *jb, uint32_t now_ms, uint8_t *out, size_t *out_len)
+{
+    if (!jb->active || jb->rebuffer)
+    {
+        return JB_EMPTY;
+    }
+
+    jb_slot_t *slot = &jb->slots[jb->next_seq % JB_SLOTS];
+    if (slot->used && slot->seq == jb->next_seq)
+    {
+        if ((int32_t)(now_ms - (slot->ts + jb->offset_ms)) < 0)
+        {
+            return JB_EMPTY;
+        }
+        memcpy(out, slot->data, slot->len);
+        *out_len = slot->len;
+        jb->played_arrival_ms = slot->arrival_ms;
+        slot->used = false;
+        jb->next_seq++;
+        jb->next_ts = slot->ts + jb->frame_ms;
+        jb->stats.played++;
+        return JB_FRAME;
+    }
+
+    // Due frame is absent; wait until its deadline before giving up on it
+    if ((int32_t)(now_ms - (jb->next_ts + jb->offset_ms)) < 0)
+    {
+        return JB_EMPTY;
+    }
+
+    if (jb_depth(jb) > 0)
+    {
+        jb->next_seq++;
+        jb->next_ts += jb->frame_ms;
+        jb->stats.missing++;
+        return JB_MISSING;
+    }
+
+    jb->stats.underrun++;
+    jb->rebuffer = true;
+    return JB_UNDERRUN;
+}
+
+// Time until jb_get has something to return (0 if already due). Returns
+// false when playout waits for input rather than a deadline.
+static inline bool jb_next_due(const jitter_buffer_t *jb, uint32_t now_ms, uint32_t *due_in_ms)
+{
+    if (!jb->active || jb->rebuffer)
+    {
+        return false;
+    }
+    const jb_slot_t *slot = &jb->slots[jb->next_seq % JB_SLOTS];
+    uint32_t ts = (slot->used && slot->seq == jb->next_seq) ? slot->ts : jb->next_ts;
+    int32_t due = (int32_t)(ts + jb->offset_ms - now_ms);
+    *due_in_ms = due > 0 ? (uint32_t)due : 0;
+    return true;
+}
+
+// True when the buffer holds nothing and is waiting for input
+static inline bool jb_idle(const jitter_buffer_t *jb)
+{
+    return !jb->active || (jb->rebuffer && jb_depth(jb) == 0);
+}
@@ -0,0 +1,53 @@
+#pragma once
+// Fixed-bin latency histogram with percentile readout
+//
+// Values are in caller chosen units (one bin per unit); anything past the
+// last bin lands in it. Cheap enough to update per packet.
+//
+// Plain C, no ESP-IDF dependencies. Not thread safe, one writer.
+#include <stdint.h>
+#include <string.h>
+
+#define LAT_HIST_BINS 256
+
+typedef struct
+{
+    uint32_t bins[LAT_HIST_BINS];
+    uint32_t count;
+    uint32_t max;
+} lat_hist_t;
+
+static inline void lat_hist_reset(lat_hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+static inline void lat_hist_add(lat_hist_t *h, uint32_t v)
+{
+    if (v > h->max)
+    {
+        h->max = v;
+    }
+    h->bins[v < LAT_HIST_BINS ? v : LAT_HIST_BINS - 1]++;
+    h->count++;
+}
+
+// Smallest value with at least pct percent of samples at or below it
+static inline uint32_t lat_hist_percentile(const lat_hist_t *h, uint32_t pct)
+{
+    if (h->count == 0)
+    {
+        return 0;
+    }
+    uint32_t want = (uint32_t)(((uint64_t)h->count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < LAT_HIST_BINS; i++)
+    {
+        seen += h->bins[i];
+        if (seen >= want)
+        {
+            return i;
+        }
+    }
+    return LAT_HIST_BINS - 1;
+}
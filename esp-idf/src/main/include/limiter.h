@@ -0,0 +1,163 @@
+#pragma once
+// Look-ahead peak limiter
+//
+// Sits on the AGC gain stage: the AGC ramp is applied in 32 bits with no
+// clamp, and the limiter pulls any peak that would exceed LIMITER_CEILING
+// back under it before the sample is narrowed to int16. Output is delayed
+// by LIMITER_LOOKAHEAD samples so the gain can start falling before a peak
+// arrives; limiter_drain() flushes the delayed tail at the end of a stream.
+//
+// Gain computer per sample: required gain r = min(1, ceiling / |x|), a
+// sliding minimum of r over the look-ahead window (monotonic deque), then a
+// one-pole release towards unity, then a box average over the look-ahead
+// window. Every gain averaged into the output of a peak is at most that
+// peak's required gain, so the output never exceeds the ceiling and the
+// attack is a linear ramp over the window rather than a step.
+//
+// Plain C, no ESP-IDF dependencies.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define LIMITER_LOOKAHEAD 64       // 4 ms at 16 kHz, power of two
+#define LIMITER_LOOKAHEAD_SHIFT 6
+#define LIMITER_CEILING 29491      // -0.9 dBFS
+#define LIMITER_RELEASE_Q15 41     // 1 - exp(-1 / 50 ms) at 16 kHz
+#define LIMITER_UNITY (1 << 15)
+
+typedef struct
+{
+    int32_t delay[LIMITER_LOOKAHEAD];      // Gained, not yet limited samples
+    int32_t box[LIMITER_LOOKAHEAD];        // Last gains fed to the average
+    int32_t box_sum;
+    int32_t dq_gain[LIMITER_LOOKAHEAD + 1]; // Sliding minimum: increasing gains
+    uint32_t dq_pos[LIMITER_LOOKAHEAD + 1]; // ... and the sample they expire after
+    uint8_t dq_head;
+    uint8_t dq_len;
+    int32_t release;                       // Gain after the release filter, Q15
+    uint32_t pos;                          // Samples processed
+    bool pending;                          // Delay line holds samples not yet output
+    uint32_t limited;                      // Samples output with gain < 1
+    int32_t min_gain;                      // Deepest gain since last read, Q15
+} limiter_t;
+
+static inline void limiter_init(limiter_t *l)
+{
+    memset(l, 0, sizeof(*l));
+    for (int i = 0; i < LIMITER_LOOKAHEAD; i++)
+    {
+        l->box[i] = LIMITER_UNITY;
+    }
+    l->box_sum = LIMITER_UNITY << LIMITER_LOOKAHEAD_SHIFT;
+    l->release = LIMITER_UNITY;
+    l->min_gain = LIMITER_UNITY;
+}
+
+static inline int32_t limiter_required(int32_t v)
+{
+    int32_t a = v < 0 ? -v : v;
+    if (a <= LIMITER_CEILING)
+    {
+        return LIMITER_UNITY;
+    }
+    return (int32_t)(((int64_t)LIMITER_CEILING << 15) / a);
+}
+
+// Push one gained sample, return the limited sample that leaves the delay line
+static inline int16_t limiter_step(limiter_t *l, int32_t v)
+{
+    const uint8_t cap = LIMITER_LOOKAHEAD + 1;
+    uint32_t pos = l->pos++;
+    int32_t r = limiter_required(v);
+
+    // Sliding minimum over the last LIMITER_LOOKAHEAD + 1 required gains
+    if (l->dq_len > 0 && (int32_t)(pos - l->dq_pos[l->dq_head]) > LIMITER_LOOKAHEAD)
+    {
+        l->dq_head = (uint8_t)((l->dq_head + 1) % cap);
+        l->dq_len--;
+    }
+    while (l->dq_len > 0)
+    {
+        uint8_t tail = (uint8_t)((l->dq_head + l->dq_len - 1) % cap);
+        if (l->dq_gain[tail] < r)
+        {
+            break;
+        }
+        l->dq_len--;
+    }
+    uint8_t slot = (uint8_t)((l->dq_head + l->dq_len) % cap);
+    l->dq_gain[slot] = r;
+    l->dq_pos[slot] = pos;
+    l->dq_len++;
+    int32_t h = l->dq_gain[l->dq_head];
+
+    // Release towards unity, never above the held minimum
+    int32_t rel = l->release + (((LIMITER_UNITY - l->release) * LIMITER_RELEASE_Q15) >> 15);
+    if (rel < h)
+    {
+        h = rel;
+    }
+    l->release = h;
+
+    // Box average: a linear attack over the look-ahead
+    uint32_t idx = pos & (LIMITER_LOOKAHEAD - 1);
+    l->box_sum += h - l->box[idx];
+    l->box[idx] = h;
+    int32_t g = l->box_sum >> LIMITER_LOOKAHEAD_SHIFT;
+
+    int32_t x = l->delay[idx];
+    l->delay[idx] = v;
+    l->pending = true;
+    if (g < LIMITER_UNITY)
+    {
+        l->limited++;
+        if (g < l->min_gain)
+        {
+            l->min_gain = g;
+        }
+    }
+
+    // |x| * g can reach 2^32 at MAX_GAIN; Q12 keeps it in 32 bits
+    int32_t y = (x * (g >> 3)) >> 12;
+    if (y > 32767)
+        y = 32767;
+    if (y < -32768)
+        y = -32768;
+    return (int16_t)y;
+}
+
+// Apply a gain ramping from g0 to g1 (Q15, as agc_update reports) to buf in
+// place and limit it. The output lags the input by LIMITER_LOOKAHEAD samples.
+static inline void limiter_process(limiter_t *l, int16_t *buf, size_t n, int32_t g0, int32_t g1)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    int32_t step = (g1 - g0) / (int32_t)n;
+    int32_t g = g0;
+    for (size_t i = 0; i < n; i++)
+    {
+        g += step;
+        int32_t v = ((int32_t)buf[i] * (g >> 3)) >> 12;
+        buf[i] = limiter_step(l, v);
+    }
+}
+
+// End of stream: feed silence until the last LIMITER_LOOKAHEAD samples have
+// left the delay line, writing them to buf. Returns the samples written, 0
+// if nothing was pushed since the last drain.
+static inline size_t limiter_drain(limiter_t *l, int16_t *buf)
+{
+    if (!l->pending)
+    {
+        return 0;
+    }
+    for (int i = 0; i < LIMITER_LOOKAHEAD; i++)
+    {
+        buf[i] = limiter_step(l, 0);
+    }
+    l->pending = false;
+    return LIMITER_LOOKAHEAD;
+}
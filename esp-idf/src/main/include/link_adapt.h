@@ -0,0 +1,146 @@
+#pragma once
+// Per-peer link quality estimate and transmit configuration choice
+//
+// Each peer keeps an RSSI EWMA and a loss EWMA fed from sequence gaps in
+// its audio stream. The sender evaluates the packet error model from
+// tools/rssi-packet-analysis.html (BER from SNR over a -95 dBm noise floor,
+// PER = 1 - (1 - BER)^bits) for every candidate packet layout, combines
+// it with the measured loss, and picks the one with the lowest
+// expected residual loss + added latency.
+//
+// Plain C, no ESP-IDF dependencies.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define LINK_NOISE_FLOOR_DBM -95
+#define LINK_RSSI_SHIFT 3          // RSSI EWMA weight 1/8
+#define LINK_LOSS_SHIFT 5          // Loss EWMA weight 1/32 per packet
+#define LINK_LOSS_WEIGHT_MS 1000.0f // 1% residual loss costs as much as 10 ms latency
+
+typedef struct
+{
+    int32_t rssi_q4;     // dBm, Q4
+    uint32_t loss_q16;   // Loss probability, Q16
+    bool have_rssi;
+    bool have_seq;
+    uint8_t stream_id;
+    uint16_t last_seq;
+} link_quality_t;
+
+static inline void link_init(link_quality_t *lq)
+{
+    lq->rssi_q4 = 0;
+    lq->loss_q16 = 0;
+    lq->have_rssi = false;
+    lq->have_seq = false;
+}
+
+static inline void link_update_rssi(link_quality_t *lq, int rssi)
+{
+    if (!lq->have_rssi)
+    {
+        lq->rssi_q4 = rssi * 16;
+        lq->have_rssi = true;
+        return;
+    }
+    lq->rssi_q4 += (rssi * 16 - lq->rssi_q4) >> LINK_RSSI_SHIFT;
+}
+
+static inline void link_loss_sample(link_quality_t *lq, bool lost)
+{
+    int32_t target = lost ? 65536 : 0;
+    lq->loss_q16 += (target - (int32_t)lq->loss_q16) >> LINK_LOSS_SHIFT;
+}
+
+// Account one received audio packet; a jump in seq counts the skipped packets as lost
+static inline void link_update_seq(link_quality_t *lq, uint8_t stream_id, uint16_t seq)
+{
+    if (lq->have_seq && stream_id == lq->stream_id)
+    {
+        int16_t gap = (int16_t)(seq - lq->last_seq) - 1;
+        if (gap < 0)
+        {
+            return; // Reordered or duplicate
+        }
+        if (gap > 16)
+        {
+            gap = 16;
+        }
+        for (int i = 0; i < gap; i++)
+        {
+            link_loss_sample(lq, true);
+        }
+    }
+    link_loss_sample(lq, false);
+    lq->have_seq = true;
+    lq->stream_id = stream_id;
+    lq->last_seq = seq;
+}
+
+static inline int link_rssi(const link_quality_t *lq)
+{
+    return lq->rssi_q4 / 16;
+}
+
+// Packet error rate from the RSSI model in tools/rssi-packet-analysis.html
+static inline float link_model_per(int rssi, size_t packet_bytes)
+{
+    int snr = rssi - LINK_NOISE_FLOOR_DBM;
+    float ber;
+    if (snr > 30)
+        ber = 1e-9f;
+    else if (snr > 25)
+        ber = 1e-7f;
+    else if (snr > 20)
+        ber = 5e-6f;
+    else if (snr > 15)
+        ber = 5e-5f;
+    else if (snr > 10)
+        ber = 5e-4f;
+    else
+        ber = 1e-2f;
+    return 1.0f - expf((float)(packet_bytes * 8) * log1pf(-ber));
+}
+
+// Choose how many redundant copies to carry. frame_bytes is one encoded
+// frame, overhead the fixed header bytes, max_packet the largest frame the
+// transport accepts. A lost frame survives if any of the next `level`
+// packets arrives. The receiving jitter buffer holds (1 + level) frame times
+// to let those copies arrive, within its min_delay_ms..max_delay_ms range,
+// so only the part above its level-0 delay is charged as latency, and
+// levels it can't hold are not considered.
+static inline uint8_t link_choose_red_level(int rssi, uint32_t loss_q16, size_t frame_bytes,
+                                            size_t overhead, size_t max_packet, uint8_t max_level,
+                                            float frame_ms, float min_delay_ms, float max_delay_ms)
+{
+    float measured = (float)loss_q16 / 65536.0f;
+    uint8_t best_level = 0;
+    float best_cost = 0.0f;
+
+    for (uint8_t level = 0; level <= max_level; level++)
+    {
+        size_t bytes = overhead + frame_bytes + (level ? 1 + level * (2 + frame_bytes) : 0);
+        if (bytes > max_packet)
+        {
+            break;
+        }
+        float per = link_model_per(rssi, bytes);
+        float p = 1.0f - (1.0f - per) * (1.0f - measured);
+        float residual = powf(p, (float)(level + 1));
+        float delay = (level + 1) * frame_ms;
+        if (delay > max_delay_ms)
+        {
+            break;
+        }
+        float added = fmaxf(delay, min_delay_ms) - fmaxf(frame_ms, min_delay_ms);
+        float cost = residual * LINK_LOSS_WEIGHT_MS + added;
+        if (level == 0 || cost < best_cost)
+        {
+            best_cost = cost;
+            best_level = level;
+        }
+    }
+    return best_level;
+}
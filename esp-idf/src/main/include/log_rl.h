@@ -0,0 +1,44 @@
+#pragma once
+// Token bucket for rate-limited logging
+//
+// Each call to log_rl_allow spends one token; tokens refill at
+// LOG_RL_PER_SEC up to LOG_RL_BURST. Lines refused are counted so the
+// caller can report how many were suppressed.
+//
+// Plain C, no ESP-IDF dependencies; all times are caller supplied ms.
+// Not thread safe, one caller.
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LOG_RL_PER_SEC 5
+#define LOG_RL_BURST 10
+
+typedef struct
+{
+    uint32_t tokens_ms;   // Tokens scaled by 1000 / LOG_RL_PER_SEC ms each
+    uint32_t last_ms;
+    uint32_t suppressed;
+} log_rl_t;
+
+static inline void log_rl_init(log_rl_t *rl, uint32_t now_ms)
+{
+    rl->tokens_ms = LOG_RL_BURST * (1000 / LOG_RL_PER_SEC);
+    rl->last_ms = now_ms;
+    rl->suppressed = 0;
+}
+
+static inline bool log_rl_allow(log_rl_t *rl, uint32_t now_ms)
+{
+    const uint32_t cost = 1000 / LOG_RL_PER_SEC;
+    const uint32_t cap = LOG_RL_BURST * cost;
+    uint32_t elapsed = now_ms - rl->last_ms;
+    rl->last_ms = now_ms;
+    rl->tokens_ms = (elapsed >= cap || rl->tokens_ms + elapsed >= cap) ? cap : rl->tokens_ms + elapsed;
+    if (rl->tokens_ms < cost)
+    {
+        rl->suppressed++;
+        return false;
+    }
+    rl->tokens_ms -= cost;
+    return true;
+}
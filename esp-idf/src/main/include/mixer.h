@@ -0,0 +1,70 @@
+#pragma once
+// Saturating int16 mixing kernel
+//
+// On the ESP32-S3 the bulk of the buffer goes through the PIE vector unit
+// (EE.VADDS.S16, 8 lanes of saturating add per instruction) when both
+// buffers are 16-byte aligned; the rest uses the portable scalar loop.
+// Builds on the host without ESP-IDF (scalar path only).
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define MIXER_HAS_PIE 1
+#endif
+
+#define MIXER_ALIGN 16
+
+static inline int16_t mixer_sat16(int32_t v)
+{
+    if (v > 32767)
+        return 32767;
+    if (v < -32768)
+        return -32768;
+    return (int16_t)v;
+}
+
+static inline void mixer_add_s16_scalar(int16_t *dst, const int16_t *src, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[i] = mixer_sat16((int32_t)dst[i] + src[i]);
+    }
+}
+
+#ifdef MIXER_HAS_PIE
+// dst[i] = sat(dst[i] + src[i]) for blocks of 8 samples, both pointers 16-byte aligned
+static inline void mixer_add_s16_pie(int16_t *dst, const int16_t *src, size_t blocks)
+{
+    int16_t *out = dst;
+    for (size_t i = 0; i < blocks; i++)
+    {
+        __asm__ volatile(
+            "ee.vld.128.ip q0, %0, 16\n"
+            "ee.vld.128.ip q1, %1, 16\n"
+            "ee.vadds.s16 q0, q0, q1\n"
+            "ee.vst.128.ip q0, %2, 16\n"
+            : "+r"(dst), "+r"(src), "+r"(out)
+            :
+            : "memory");
+    }
+}
+#endif
+
+// Accumulate src into dst with int16 saturation
+static inline void mixer_add_s16(int16_t *dst, const int16_t *src, size_t n)
+{
+#ifdef MIXER_HAS_PIE
+    if ((((uintptr_t)dst | (uintptr_t)src) & (MIXER_ALIGN - 1)) == 0)
+    {
+        size_t blocks = n / 8;
+        mixer_add_s16_pie(dst, src, blocks);
+        dst += blocks * 8;
+        src += blocks * 8;
+        n -= blocks * 8;
+    }
+#endif
+    mixer_add_s16_scalar(dst, src, n);
+}
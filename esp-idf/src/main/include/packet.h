@@ -0,0 +1,194 @@
+#pragma once
+// bbTalkie ESP-NOW wire format
+//
+// Every frame starts with a fixed 12-byte little-endian header:
+//
+//   0  magic        0xBB
+//   1  ver_type     version (high nibble) | packet type (low nibble)
+//   2  codec        BB_CODEC_*
+//   3  stream_id    talk burst id, bumped by the sender for each burst
+//   4  seq          16-bit sequence number within the stream
+//   6  timestamp    capture time of the first sample, ms since boot
+//  10  payload_len  bytes following the header
+//
+// Plain C, no ESP-IDF dependencies, so it also builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define BB_PKT_MAGIC 0xBB
+#define BB_PKT_VERSION 1
+#define BB_PKT_HEADER_SIZE 12
+
+typedef enum
+{
+    BB_PKT_AUDIO = 0,
+    BB_PKT_PING = 1,
+    BB_PKT_CMD = 2, // payload: uint16 command id
+    BB_PKT_MSG = 3, // payload: UTF-8 text, not NUL terminated
+    BB_PKT_FLOOR = 4, // payload: u8 floor op (FLOOR_OP_*, see floor.h), u8 priority
+} bb_pkt_type_t;
+
+typedef enum
+{
+    BB_CODEC_NONE = 0,
+    BB_CODEC_ADPCM = 1,
+    BB_CODEC_ADPCM_RED = 2, // ADPCM with redundant copies of earlier frames, see below
+} bb_codec_t;
+
+// Redundant (RED-style) audio payload:
+//
+//   u8   count                 number of redundant frames, at most BB_RED_MAX
+//   count x { u16 len, bytes } frames seq-1, seq-2, ... (nearest first)
+//   bytes                      primary frame for seq, to the end of the payload
+//
+// count is the sender's redundancy level; copies of frames from before the
+// start of the stream are sent with len 0.
+#define BB_RED_MAX 2
+
+typedef struct
+{
+    uint8_t count;
+    const uint8_t *red[BB_RED_MAX];
+    uint16_t red_len[BB_RED_MAX];
+    const uint8_t *primary;
+    uint16_t primary_len;
+} bb_red_t;
+
+// Parsed header; payload points into the received buffer (no copy)
+typedef struct
+{
+    uint8_t version;
+    uint8_t type;
+    uint8_t codec;
+    uint8_t stream_id;
+    uint16_t seq;
+    uint32_t timestamp;
+    uint16_t payload_len;
+    const uint8_t *payload;
+} bb_pkt_t;
+
+static inline uint16_t bb_rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t bb_rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void bb_wr16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void bb_wr32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Write a header in front of a payload already placed at buf + BB_PKT_HEADER_SIZE.
+// Returns the total frame length.
+static inline size_t bb_pkt_write_header(uint8_t *buf, bb_pkt_type_t type, bb_codec_t codec,
+                                         uint8_t stream_id, uint16_t seq, uint32_t timestamp,
+                                         uint16_t payload_len)
+{
+    buf[0] = BB_PKT_MAGIC;
+    buf[1] = (uint8_t)((BB_PKT_VERSION << 4) | (type & 0x0F));
+    buf[2] = (uint8_t)codec;
+    buf[3] = stream_id;
+    bb_wr16(&buf[4], seq);
+    bb_wr32(&buf[6], timestamp);
+    bb_wr16(&buf[10], payload_len);
+    return BB_PKT_HEADER_SIZE + payload_len;
+}
+
+// Validate and decode a received frame. Returns false for anything that is
+// not a well-formed frame of our version, so stray packets are dropped.
+static inline bool bb_pkt_parse(const uint8_t *data, size_t len, bb_pkt_t *pkt)
+{
+    if (len < BB_PKT_HEADER_SIZE || data[0] != BB_PKT_MAGIC)
+    {
+        return false;
+    }
+
+    pkt->version = data[1] >> 4;
+    pkt->type = data[1] & 0x0F;
+    if (pkt->version != BB_PKT_VERSION || pkt->type > BB_PKT_FLOOR)
+    {
+        return false;
+    }
+
+    pkt->payload_len = bb_rd16(&data[10]);
+    if ((size_t)pkt->payload_len > len - BB_PKT_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    pkt->codec = data[2];
+    pkt->stream_id = data[3];
+    pkt->seq = bb_rd16(&data[4]);
+    pkt->timestamp = bb_rd32(&data[6]);
+    pkt->payload = data + BB_PKT_HEADER_SIZE;
+    return true;
+}
+
+// Size of the redundancy block that goes in front of the primary frame
+static inline size_t bb_red_block_size(uint8_t count, const uint16_t *red_len)
+{
+    size_t size = 1;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        size += 2 + red_len[i];
+    }
+    return size;
+}
+
+// Write the redundancy block at p, returns the bytes written
+static inline size_t bb_red_write(uint8_t *p, uint8_t count, const uint8_t *const *red, const uint16_t *red_len)
+{
+    size_t off = 0;
+    p[off++] = count;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        bb_wr16(&p[off], red_len[i]);
+        memcpy(&p[off + 2], red[i], red_len[i]);
+        off += 2 + red_len[i];
+    }
+    return off;
+}
+
+// Split a BB_CODEC_ADPCM_RED payload (zero-copy)
+static inline bool bb_red_parse(const uint8_t *payload, size_t len, bb_red_t *out)
+{
+    if (len < 1 || payload[0] > BB_RED_MAX)
+    {
+        return false;
+    }
+    size_t off = 1;
+    out->count = payload[0];
+    for (uint8_t i = 0; i < out->count; i++)
+    {
+        if (off + 2 > len)
+        {
+            return false;
+        }
+        out->red_len[i] = bb_rd16(&payload[off]);
+        off += 2;
+        if (off + out->red_len[i] > len)
+        {
+            return false;
+        }
+        out->red[i] = &payload[off];
+        off += out->red_len[i];
+    }
+    out->primary = &payload[off];
+    out->primary_len = (uint16_t)(len - off);
+    return true;
+}
@@ -0,0 +1,174 @@
+#pragma once
+// Registry of units we hear, keyed by MAC
+//
+// Open addressing with linear probing in a power-of-two table at most half
+// full, so a lookup is one hash and a probe or two. Removal shifts the
+// following entries back instead of leaving tombstones, so lookups never
+// slow down as peers come and go. Each peer carries its link quality
+// (RSSI EWMA and loss, link_adapt.h), interarrival jitter and last-seen
+// time; peers not heard for the timeout are evicted by peer_expire.
+//
+// Plain C, no ESP-IDF dependencies; all times are caller supplied ms.
+// Not thread safe, the caller serializes access (short, non-blocking).
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "link_adapt.h"
+
+#define PEER_MAX 64
+#define PEER_SLOTS 128          // Power of two, 2 x PEER_MAX
+#define PEER_MAC_LEN 6
+
+typedef struct
+{
+    bool used;
+    uint8_t mac[PEER_MAC_LEN];
+    uint32_t last_seen_ms;
+    link_quality_t link;
+    uint32_t jitter_q4;         // Interarrival jitter in ms, Q4 (RFC 3550)
+    int32_t last_transit;
+    bool have_transit;
+} peer_t;
+
+typedef struct
+{
+    peer_t slots[PEER_SLOTS];
+    uint16_t count;
+    uint32_t full;              // Inserts refused because PEER_MAX peers are known
+    uint32_t expired;
+} peer_registry_t;
+
+static inline void peer_reg_init(peer_registry_t *reg)
+{
+    memset(reg, 0, sizeof(*reg));
+}
+
+static inline uint32_t peer_hash(const uint8_t *mac)
+{
+    // FNV-1a; the vendor prefix is shared, so hash all six bytes
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < PEER_MAC_LEN; i++)
+    {
+        h = (h ^ mac[i]) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+static inline peer_t *peer_find(peer_registry_t *reg, const uint8_t *mac)
+{
+    uint32_t i = peer_hash(mac) & (PEER_SLOTS - 1);
+    while (reg->slots[i].used)
+    {
+        if (memcmp(reg->slots[i].mac, mac, PEER_MAC_LEN) == 0)
+        {
+            return &reg->slots[i];
+        }
+        i = (i + 1) & (PEER_SLOTS - 1);
+    }
+    return NULL;
+}
+
+// Find a peer, adding it if new. *added tells which; NULL if the registry is full.
+static inline peer_t *peer_touch(peer_registry_t *reg, const uint8_t *mac, uint32_t now_ms, bool *added)
+{
+    *added = false;
+    uint32_t i = peer_hash(mac) & (PEER_SLOTS - 1);
+    while (reg->slots[i].used)
+    {
+        if (memcmp(reg->slots[i].mac, mac, PEER_MAC_LEN) == 0)
+        {
+            reg->slots[i].last_seen_ms = now_ms;
+            return &reg->slots[i];
+        }
+        i = (i + 1) & (PEER_SLOTS - 1);
+    }
+    if (reg->count >= PEER_MAX)
+    {
+        reg->full++;
+        return NULL;
+    }
+    peer_t *p = &reg->slots[i];
+    memset(p, 0, sizeof(*p));
+    p->used = true;
+    memcpy(p->mac, mac, PEER_MAC_LEN);
+    p->last_seen_ms = now_ms;
+    link_init(&p->link);
+    reg->count++;
+    *added = true;
+    return p;
+}
+
+// Interarrival jitter from the sender timestamp and our arrival time
+static inline void peer_update_transit(peer_t *p, uint32_t ts, uint32_t arrival_ms)
+{
+    int32_t transit = (int32_t)(arrival_ms - ts);
+    if (p->have_transit)
+    {
+        int32_t d = transit - p->last_transit;
+        if (d < 0)
+            d = -d;
+        p->jitter_q4 += (uint32_t)d - ((p->jitter_q4 + 8) >> 4);
+    }
+    p->last_transit = transit;
+    p->have_transit = true;
+}
+
+static inline uint16_t peer_jitter_ms(const peer_t *p)
+{
+    return (uint16_t)(p->jitter_q4 >> 4);
+}
+
+static inline void peer_remove_slot(peer_registry_t *reg, uint32_t i)
+{
+    // Backward shift: pull later entries of the probe run into the hole
+    uint32_t hole = i;
+    uint32_t j = i;
+    while (1)
+    {
+        j = (j + 1) & (PEER_SLOTS - 1);
+        if (!reg->slots[j].used)
+        {
+            break;
+        }
+        uint32_t home = peer_hash(reg->slots[j].mac) & (PEER_SLOTS - 1);
+        // Move j into the hole unless its home lies cyclically in (hole, j]
+        if (((j - home) & (PEER_SLOTS - 1)) >= ((j - hole) & (PEER_SLOTS - 1)))
+        {
+            reg->slots[hole] = reg->slots[j];
+            hole = j;
+        }
+    }
+    reg->slots[hole].used = false;
+    reg->count--;
+}
+
+static inline bool peer_remove(peer_registry_t *reg, const uint8_t *mac)
+{
+    peer_t *p = peer_find(reg, mac);
+    if (p == NULL)
+    {
+        return false;
+    }
+    peer_remove_slot(reg, (uint32_t)(p - reg->slots));
+    return true;
+}
+
+// Evict peers not heard for timeout_ms. Returns how many went.
+static inline int peer_expire(peer_registry_t *reg, uint32_t now_ms, uint32_t timeout_ms)
+{
+    int removed = 0;
+    for (uint32_t i = 0; i < PEER_SLOTS;)
+    {
+        if (reg->slots[i].used && now_ms - reg->slots[i].last_seen_ms > timeout_ms)
+        {
+            // The shift may pull an unchecked entry into slot i, look again
+            peer_remove_slot(reg, i);
+            reg->expired++;
+            removed++;
+            continue;
+        }
+        i++;
+    }
+    return removed;
+}
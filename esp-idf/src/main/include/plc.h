@@ -0,0 +1,126 @@
+#pragma once
+// Packet loss concealment for 16 kHz mono PCM
+//
+// On the first lost frame the pitch period of the recent history is found
+// by normalized autocorrelation; lost frames are then filled by repeating
+// the last period with a linear fade-out. When real audio resumes its head
+// is cross-faded with the continued synthetic signal to avoid a click.
+//
+// Plain C, no ESP-IDF dependencies.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define PLC_MIN_PITCH 40      // 400 Hz
+#define PLC_MAX_PITCH 320     // 50 Hz
+#define PLC_CORR_WINDOW 160   // 10 ms analysis window
+#define PLC_HISTORY (PLC_MAX_PITCH + PLC_CORR_WINDOW)
+#define PLC_FADE_SAMPLES 960  // Concealment fades to silence over 60 ms
+#define PLC_XFADE 64          // Cross-fade length when audio resumes
+
+typedef struct
+{
+    int16_t history[PLC_HISTORY]; // Most recent good output, oldest first
+    int pitch;
+    uint32_t lost_samples;         // Samples synthesized since the loss began
+    uint32_t concealed_frames;
+    uint32_t recovered_frames;     // Good frames that ended a loss
+} plc_t;
+
+static inline void plc_reset(plc_t *plc)
+{
+    memset(plc->history, 0, sizeof(plc->history));
+    plc->pitch = PLC_MIN_PITCH;
+    plc->lost_samples = 0;
+}
+
+static inline void plc_init(plc_t *plc)
+{
+    plc_reset(plc);
+    plc->concealed_frames = 0;
+    plc->recovered_frames = 0;
+}
+
+// Pick the lag with the highest normalized correlation, on a 2:1 decimated grid
+static inline int plc_find_pitch(const int16_t *h)
+{
+    const int16_t *x = &h[PLC_HISTORY - PLC_CORR_WINDOW];
+    int best_lag = PLC_MIN_PITCH;
+    float best_score = 0.0f;
+
+    for (int lag = PLC_MIN_PITCH; lag <= PLC_MAX_PITCH; lag += 2)
+    {
+        const int16_t *y = x - lag;
+        float corr = 0.0f, energy = 1.0f;
+        for (int i = 0; i < PLC_CORR_WINDOW; i += 2)
+        {
+            corr += (float)x[i] * y[i];
+            energy += (float)y[i] * y[i];
+        }
+        if (corr > 0.0f)
+        {
+            float score = corr * corr / energy;
+            if (score > best_score)
+            {
+                best_score = score;
+                best_lag = lag;
+            }
+        }
+    }
+    return best_lag;
+}
+
+// Synthetic continuation sample k after the start of the loss
+static inline int16_t plc_synth(const plc_t *plc, uint32_t k)
+{
+    if (k >= PLC_FADE_SAMPLES)
+    {
+        return 0;
+    }
+    int16_t s = plc->history[PLC_HISTORY - plc->pitch + (k % plc->pitch)];
+    int32_t gain = (int32_t)(((PLC_FADE_SAMPLES - k) << 15) / PLC_FADE_SAMPLES); // Q15
+    return (int16_t)(((int32_t)s * gain) >> 15);
+}
+
+static inline void plc_push_history(plc_t *plc, const int16_t *pcm, size_t samples)
+{
+    if (samples >= PLC_HISTORY)
+    {
+        memcpy(plc->history, pcm + samples - PLC_HISTORY, sizeof(plc->history));
+        return;
+    }
+    memmove(plc->history, plc->history + samples, (PLC_HISTORY - samples) * sizeof(int16_t));
+    memcpy(plc->history + PLC_HISTORY - samples, pcm, samples * sizeof(int16_t));
+}
+
+// Fill one lost frame
+static inline void plc_conceal(plc_t *plc, int16_t *out, size_t samples)
+{
+    if (plc->lost_samples == 0)
+    {
+        plc->pitch = plc_find_pitch(plc->history);
+    }
+    for (size_t i = 0; i < samples; i++)
+    {
+        out[i] = plc_synth(plc, plc->lost_samples + i);
+    }
+    plc->lost_samples += samples;
+    plc->concealed_frames++;
+}
+
+// Feed a correctly decoded frame; cross-fades its head if it ends a loss
+static inline void plc_good_frame(plc_t *plc, int16_t *pcm, size_t samples)
+{
+    if (plc->lost_samples > 0)
+    {
+        size_t n = samples < PLC_XFADE ? samples : PLC_XFADE;
+        for (size_t i = 0; i < n; i++)
+        {
+            int32_t syn = plc_synth(plc, plc->lost_samples + i);
+            pcm[i] = (int16_t)((syn * (int32_t)(n - i) + (int32_t)pcm[i] * (int32_t)i) / (int32_t)n);
+        }
+        plc->lost_samples = 0;
+        plc->recovered_frames++;
+    }
+    plc_push_history(plc, pcm, samples);
+}
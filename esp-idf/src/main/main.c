@@ -38,6 +38,8 @@
 #include "esp_now.h"
 #include "esp_wifi.h"
 #include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
@@ -62,11 +64,22 @@
 
 #include "include/fonts/fusion_pixel.h"
 #include "include/fonts/fusion_pixel_30.h"
+#include "include/fonts/fusion_pixel_cjk.h"
 
 #include "driver/adc.h"
 #include "soc/adc_channel.h"
 
 #include "include/agc.h"
+#include "include/limiter.h"
+#include "include/packet.h"
+#include "include/jitter_buffer.h"
+#include "include/plc.h"
+#include "include/link_adapt.h"
+#include "include/peer_registry.h"
+#include "include/lat_hist.h"
+#include "include/log_rl.h"
+#include "include/mixer.h"
+#include "include/floor.h"
 #include "include/led.h"
 #include "esp_sleep.h"
 #include "driver/rtc_io.h"
@@ -78,7 +91,11 @@
 #define ENCODED_BUF_SIZE 10240
 #define PLAY_RING_BUFFER_SIZE 8192
 #define PLAY_CHUNK_SIZE 2048
-#define ESP_NOW_PACKET_SIZE 512
+
+#define ESP_NOW_PACKET_SIZE 800           // Header + primary ADPCM frame + up to two redundant frames
+#define ESP_NOW_TX_QUEUE_LEN 8
+#define ESP_NOW_TX_TOKENS 2               // Packets allowed in flight before a send callback
+#define ESP_NOW_TX_TOKEN_TIMEOUT_MS 50
 
 #define SPI_MOSI_PIN_NUM 14
 #define SPI_SCK_PIN_NUM 13
@@ -96,40 +113,144 @@
 #define BUTTON_ACTIVE_LEVEL 0   // Active low (pressed = 0)
 #define LONG_PRESS_TIME_MS 2000 // 2 seconds for long press
 
-#define PING_MAGIC "PING"
-#define PING_MAGIC_LEN 4
-#define MAX_MAC_TRACK 9
-#define MAC_TIMEOUT_MS 20000
-int macCount = 1;
+#define MAC_TIMEOUT_MS 20000   // Peers not heard this long are evicted (two missed pings)
 int lastMacCount = 0;
 spi_oled_animation_t *anim_currentCommand = NULL;
 
-typedef struct
-{
-    uint8_t mac[ESP_NOW_ETH_ALEN]; // 6 bytes
-    int64_t last_seen_ms;          // Timestamp in ms
-    bool valid;
-} mac_track_entry_t;
 
 
 #define ADPCM_FRAME_SIZE 505  // 每帧样本数
 #define ADPCM_FRAME_BYTES (ADPCM_FRAME_SIZE * sizeof(int16_t))
+#define ADPCM_FRAME_MS (ADPCM_FRAME_SIZE * 1000 / SAMPLE_RATE)
+#define ADPCM_ENC_MAX_BYTES ((ADPCM_FRAME_BYTES / 4) + 7)
+#define ADPCM_RED_LEVEL_AUTO 0xFF  // 根据链路质量自动选择冗余级别
+#define ADPCM_RED_LEVEL_DEFAULT ADPCM_RED_LEVEL_AUTO  // 每个音频包附带的前几帧冗余副本数 (0 = 关闭)
+#define ENCODE_BENCH_SECONDS 0  // > 0: time this much speech through the encoder at boot (600 = the 10 min burst)
 
-// 编码缓冲区结构
+// 接收抖动缓冲
+#define JB_MIN_DELAY_MS 40
+#define JB_MAX_DELAY_MS 200
+
+// 编码器状态；PCM 直接从暂存环形缓冲区读取，不再复制到这里
 typedef struct {
-    int16_t buffer[ADPCM_FRAME_SIZE];
-    size_t current_samples;  // 当前缓冲区中的样本数
+    int16_t buffer[ADPCM_FRAME_SIZE]; // 只用于讲话结尾不满一帧的尾巴（补零）
+    esp_audio_enc_handle_t encoder; // 整个讲话期间复用的编码器，flush 时关闭
+    uint8_t stream_id;              // 每次讲话递增
+    uint16_t seq;
+    // 冗余帧：最近已编码的几帧，附在后续包中
+    uint8_t red_level;              // 当前包使用的冗余级别，可在讲话中途切换
+    uint8_t red_count;              // 已保存的历史帧数
+    uint8_t red_head;               // red_frames 环形索引，指向最近一帧
+    uint8_t red_frames[BB_RED_MAX][ADPCM_ENC_MAX_BYTES];
+    uint16_t red_len[BB_RED_MAX];
+    // Per-burst encoder stats
+    uint32_t frames;
+    uint64_t cycles;
+    int heap_at_open;
 } adpcm_encode_buffer_t;
 
 adpcm_encode_buffer_t encode_buffer;
+uint8_t tx_red_level = ADPCM_RED_LEVEL_DEFAULT; // Fixed level, or ADPCM_RED_LEVEL_AUTO to follow the link
+#define TX_RED_RECHECK_MS 500
+static uint8_t tx_red_auto = 0;          // Last level picked from the link
+static uint32_t tx_red_checked_ms = 0;
+static volatile bool tx_red_stale = true; // Rescan peers on the next packet
+uint32_t tx_link_switches = 0;
+
+// 每个发送端一路接收流：独立的抖动缓冲、解码器、丢包补偿、AGC 和限幅器
+#define MAX_RX_STREAMS 3
+#define RX_STREAM_FIFO 2048      // Decoded samples waiting for the mixer
+#define MIX_CHUNK_SAMPLES 512
+#define DECODE_CHECK_MS 32       // decode_Task wake-up for end-of-burst checks while streams are live
 
-static mac_track_entry_t mac_track_list[MAX_MAC_TRACK];
+typedef struct {
+    bool valid;
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    TickType_t last_recv;
+    esp_audio_dec_handle_t decoder;
+    jitter_buffer_t jb;
+    plc_t plc;
+    agc_t agc;
+    limiter_t lim;               // Look-ahead limiter fused with the AGC gain
+    int16_t fifo[RX_STREAM_FIFO];
+    size_t fifo_head;
+    size_t fifo_count;
+    bool joined;                 // Has produced audio, so the mixer waits for it
+} rx_stream_t;
+
+static rx_stream_t *rx_streams = NULL; // MAX_RX_STREAMS entries, allocated by decode_Task
+static uint64_t plc_cycles = 0;
+static uint64_t agc_cycles = 0;
+static uint64_t agc_samples = 0;
+static uint32_t lim_samples = 0;     // Samples the limiter turned down
+static int32_t lim_min_gain = LIMITER_UNITY;
+static uint32_t red_recovered = 0;
+static uint32_t rx_frames_played = 0;
+static uint32_t rx_frames_concealed = 0;
+static uint32_t rx_fifo_overflow = 0;
+static uint32_t mix_dropped = 0;      // Mixed samples play_stream_buf had no room for
+
+// Output path: playing, fading out and draining the DMA ring on silence, or
+// stopped until the next burst, which starts with a fade-in. Stopped means the
+// writer sleeps; the TX channel keeps clocking the mics and sends zeros.
+typedef enum {
+    OUT_ACTIVE = 0,
+    OUT_STOPPING,
+    OUT_IDLE,
+    OUT_STATE_COUNT
+} out_state_t;
+#define OUT_IDLE_MS 128       // No audio this long: stop the output
+#define OUT_FADE_SAMPLES 128  // 8 ms fade-out and fade-in
+static const char *out_state_names[OUT_STATE_COUNT] = {"active", "stopping", "idle"};
+static out_state_t out_state = OUT_ACTIVE;
+static int64_t out_state_since = 0;
+static uint64_t out_state_us[OUT_STATE_COUNT];
+static uint32_t out_wakeups = 0;
+
+// 发言权控制：没有发言权时，本机语音先暂存，拿到发言权后再按采集速率发出
+// Speech held while another unit talks, about 3 s. A whole number of ADPCM
+// frames and consumed frame by frame, so every frame is contiguous in the
+// ring and the encoder reads it in place.
+#define FLOOR_HOLD_FRAMES 95
+#define FLOOR_HOLD_SAMPLES (ADPCM_FRAME_SIZE * FLOOR_HOLD_FRAMES)
+
+floor_ctl_t floor_ctl;
+static portMUX_TYPE floor_lock = portMUX_INITIALIZER_UNLOCKED; // floor_ctl is touched by the WiFi and detect tasks
+static int16_t *hold_buf = NULL;  // FLOOR_HOLD_SAMPLES ring, allocated by detect_Task
+static size_t hold_head = 0;
+static size_t hold_count = 0;
+static size_t hold_max = 0;       // High-water mark, samples
+static uint32_t hold_dropped = 0; // Oldest samples discarded because the hold overflowed
+static size_t tx_credit = 0;      // Samples we may encode, accrues at capture rate
+static uint64_t tx_bytes_copied = 0;  // Audio bytes memcpy'd on the send side
+static uint32_t tx_frames_direct = 0; // Frames encoded straight from the AFE buffer
+static uint32_t tx_frames_held = 0;   // Frames encoded from the hold ring
+static size_t tx_sent_direct = 0;     // Samples sent by tx_speech_push since the last floor_tx_service
+static uint64_t tx_speech_samples = 0;
+static bool is_capturing = false;     // VAD speech being captured; is_speaking waits for the floor
+
+// 回放时的双讲判断：只有 AEC 有有效参考信号且近端明显更响时才采集，否则 VAD 听到的是自己的喇叭
+#define DOUBLE_TALK_REF_MIN 10737     // Reference mean square at -50 dBFS, below it nothing is playing
+#define DOUBLE_TALK_MARGIN 4          // AFE output must be 6 dB above the reference
+static bool aec_active = false;       // AFE cancels echo against a reference channel
+static int aec_ref_channel = -1;      // Reference channel in the interleaved feed frames
+static volatile uint32_t aec_ref_power = 0; // Mean square of the last fed reference chunk
+
+static peer_registry_t peers;           // Updated from the receive callback, under peer_lock
+static portMUX_TYPE peer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 命令词汉字子集，由 tools/generate_cjk_font.py 生成
+const packed_font_t font_cjk_10 = {
+    .count = sizeof(font_cjk_10_glyphs) / sizeof(font_cjk_10_glyphs[0]),
+    .glyphs = font_cjk_10_glyphs,
+    .data = font_cjk_10_data};
 
 const variable_font_t font_10 = {
     .height = 10,
     .widths = font_10_widths,
     .offsets = font_10_offsets,
-    .data = font_10_data};
+    .data = font_10_data,
+    .extra = &font_cjk_10};
 
 const variable_font_t font_30 = {
     .height = 30,
@@ -141,6 +262,8 @@ static esp_afe_sr_iface_t *afe_handle = NULL;
 srmodel_list_t *models = NULL;
 StreamBufferHandle_t play_stream_buf;
 static QueueHandle_t s_recv_queue = NULL;
+static TaskHandle_t s_decode_task = NULL;      // Notified on every queued packet and playout deadline
+static esp_timer_handle_t s_decode_timer = NULL;
 static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}; // Broadcast MAC address (all ones)
 volatile bool is_receiving = false;
 volatile bool is_speaking = false;
@@ -159,7 +282,25 @@ struct spi_ssd1327 spi_ssd1327 = {
     .rst_pin_num = RST_PIN_NUM,
     .spi_handle = &oled_dev_handle,
 };
-SemaphoreHandle_t spi_mutex;
+
+// Display compositor: drawing marks regions dirty, one flush per tick sends them
+#define DISPLAY_TICK_MS 33 // The fastest animation (wave bar) runs at 30 fps
+#define UI_STATE_COUNT 4
+typedef struct
+{
+    uint64_t us;      // Time spent in the UI state
+    uint32_t ticks;
+    uint32_t frames;  // Ticks that sent something
+    uint32_t bytes;
+    uint32_t windows;
+    uint32_t bus_us;  // SPI busy time
+    uint32_t queue_us; // Time the flush spent building and queueing
+    uint32_t render_us; // Commands and timelines drawn into the frame buffer
+    uint32_t render_max_us;
+} display_stats_t;
+static display_stats_t display_stats[UI_STATE_COUNT];
+static portMUX_TYPE display_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static const char *const ui_state_names[UI_STATE_COUNT] = {"idle", "speaking", "receiving", "command"};
 
 // AGC playback
 // Initialize AGC
@@ -170,343 +311,831 @@ agc_t agc_custom = {
     .release_rate = AGC_RELEASE
 };
 
-// Calculate RMS of audio buffer
-float calculate_rms(int16_t* buffer, size_t samples) {
-    float sum = 0.0f;
-    for (size_t i = 0; i < samples; i++) {
-        float sample = (float)buffer[i];
-        sum += sample * sample;
-    }
-    return sqrtf(sum / samples);
-}
+// Structure to hold received data
+typedef struct
+{
+    uint8_t src_addr[ESP_NOW_ETH_ALEN];
+    uint8_t codec;
+    uint8_t stream_id;
+    uint16_t seq;
+    uint32_t timestamp;
+    int64_t rx_us;                         // Receive callback time
+    uint8_t data[ESP_NOW_PACKET_SIZE - BB_PKT_HEADER_SIZE]; // Payload only, header stripped
+    size_t data_len;
+} esp_now_recv_data_t;
 
-// Apply AGC to audio buffer
-void apply_agc(int16_t* buffer, size_t samples, agc_t* agc) {
-    // Calculate current RMS level
-    float current_rms = calculate_rms(buffer, samples);
-    
-    // Avoid division by zero
-    if (current_rms < 1.0f) current_rms = 1.0f;
-    
-    // Calculate desired gain
-    float desired_gain = agc->target_rms / current_rms;
-    
-    // Apply attack/release smoothing
-    float rate = (desired_gain < agc->current_gain) ? agc->attack_rate : agc->release_rate;
-    agc->current_gain += rate * (desired_gain - agc->current_gain);
-    
-    // Clamp gain to reasonable limits
-    if (agc->current_gain < MIN_GAIN) agc->current_gain = MIN_GAIN;
-    if (agc->current_gain > MAX_GAIN) agc->current_gain = MAX_GAIN;
-    
-    // Apply gain to all samples
-    for (size_t i = 0; i < samples; i++) {
-        float sample = (float)buffer[i] * agc->current_gain;
-        
-        // Clamp to prevent overflow
-        if (sample > 32767.0f) sample = 32767.0f;
-        if (sample < -32768.0f) sample = -32768.0f;
-        
-        buffer[i] = (int16_t)sample;
+// Received audio is copied once, into a pooled buffer; the queues carry pointers
+#define ESP_NOW_RX_QUEUE_LEN 10
+#define ESP_NOW_RX_POOL (ESP_NOW_RX_QUEUE_LEN + 1) // Queued + being decoded
+static esp_now_recv_data_t rx_pool[ESP_NOW_RX_POOL];
+static QueueHandle_t s_rx_free = NULL;
+
+uint32_t rx_invalid_count = 0;
+uint32_t rx_queue_full = 0;
+uint32_t rx_pool_exhausted = 0;
+uint32_t rx_pool_min_free = ESP_NOW_RX_POOL; // Free buffer low-water mark
+
+// Receive-side work that must not run in the WiFi task (logging, UI, radio
+// power changes) is posted by the callback and done by rx_event_task
+typedef enum {
+    RX_EV_PING = 0,
+    RX_EV_NEW_PEER,
+    RX_EV_CMD,
+    RX_EV_MSG,
+    RX_EV_RADIO_WAKE,  // First audio packet after idle: keep the radio listening
+    RX_EV_RADIO_SLEEP, // Burst over: back to the power-saving wake interval
+} rx_event_type_t;
+
+#define RX_EVENT_QUEUE_LEN 8
+#define RX_EVENT_TEXT_MAX 64   // The bubble shows no more than this
+
+typedef struct {
+    uint8_t type;
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    int16_t value;             // CMD id, or RSSI
+    char text[RX_EVENT_TEXT_MAX];
+} rx_event_t;
+
+static QueueHandle_t s_rx_event_queue = NULL;
+static volatile bool radio_awake = false;   // Wake interval 0 requested, cleared when decode_Task posts RX_EV_RADIO_SLEEP
+uint32_t rx_event_dropped = 0;
+uint32_t rx_packets = 0;
+int8_t rx_last_rssi = 0;
+uint32_t rx_cb_cycles_max = 0;
+uint64_t rx_cb_cycles = 0;
+static log_rl_t rx_log_rl;                  // Shared by rx_event_task log lines
+static lat_hist_t rx_queue_hist;   // Receive callback to decode_Task, 100 us bins
+static lat_hist_t rx_playout_hist; // Receive callback to playout, 1 ms bins
+
+// Build a control frame (PING/CMD/MSG) into buf, returns the frame length
+size_t build_control_packet(uint8_t *buf, bb_pkt_type_t type, const void *payload, size_t payload_len)
+{
+    if (payload_len > ESP_NOW_PACKET_SIZE - BB_PKT_HEADER_SIZE)
+    {
+        payload_len = ESP_NOW_PACKET_SIZE - BB_PKT_HEADER_SIZE;
     }
+    if (payload_len > 0)
+    {
+        memcpy(buf + BB_PKT_HEADER_SIZE, payload, payload_len);
+    }
+    return bb_pkt_write_header(buf, type, BB_CODEC_NONE, 0, 0,
+                               (uint32_t)(esp_timer_get_time() / 1000), payload_len);
 }
 
-// Structure to hold received data
+// Outgoing packet descriptor for the TX task
 typedef struct
 {
-    uint8_t data[ESP_NOW_MAX_DATA_LEN_V2];
-    size_t data_len;
-} esp_now_recv_data_t;
+    uint8_t data[ESP_NOW_PACKET_SIZE];
+    size_t len;
+} esp_now_tx_packet_t;
+
+typedef struct
+{
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t dropped;       // Pool or queue exhausted, packet discarded by the producer
+    uint32_t send_failed;   // esp_now_send() error or failed send callback
+    uint32_t token_timeouts; // No completion within ESP_NOW_TX_TOKEN_TIMEOUT_MS, token taken as lost
+    uint32_t max_depth;     // Queue depth high-water mark
+} esp_now_tx_stats_t;
+
+// Packets are built in place in pooled buffers; the queues carry pointers
+#define ESP_NOW_TX_POOL (ESP_NOW_TX_QUEUE_LEN + 2) // Queued + being built + being sent
+static esp_now_tx_packet_t tx_pool[ESP_NOW_TX_POOL];
+static QueueHandle_t s_tx_free = NULL;
+static QueueHandle_t s_tx_queue = NULL;
+static SemaphoreHandle_t s_tx_tokens = NULL;
+esp_now_tx_stats_t tx_stats;
+static portMUX_TYPE tx_stats_lock = portMUX_INITIALIZER_UNLOCKED; // Written from the WiFi, TX and producer tasks
 
 // Callback function called when data is sent
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status)
 {
+    taskENTER_CRITICAL(&tx_stats_lock);
     if (status == ESP_NOW_SEND_SUCCESS)
     {
         // ESP_LOGI(TAG, "ESP-NOW data sent successfully");
+        tx_stats.sent++;
     }
     else
     {
-        ESP_LOGW(TAG, "ESP-NOW data send failed");
+        tx_stats.send_failed++;
+    }
+    taskEXIT_CRITICAL(&tx_stats_lock);
+    // Completion returns a token to the bucket
+    xSemaphoreGive(s_tx_tokens);
+}
+
+// Take a free packet buffer, NULL (and counted as dropped) if the pool is empty
+esp_now_tx_packet_t *tx_packet_get(void)
+{
+    esp_now_tx_packet_t *pkt = NULL;
+    if (s_tx_free == NULL || xQueueReceive(s_tx_free, &pkt, 0) != pdTRUE)
+    {
+        taskENTER_CRITICAL(&tx_stats_lock);
+        tx_stats.dropped++;
+        taskEXIT_CRITICAL(&tx_stats_lock);
+        return NULL;
+    }
+    return pkt;
+}
+
+// Hand a filled buffer to the TX task, never blocks the caller.
+// Control frames (PING/CMD/MSG/FLOOR) go to the front of the queue, ahead of audio.
+void tx_packet_submit(esp_now_tx_packet_t *pkt, bool is_control)
+{
+    BaseType_t ok = is_control ? xQueueSendToFront(s_tx_queue, &pkt, 0)
+                               : xQueueSendToBack(s_tx_queue, &pkt, 0);
+    if (ok != pdTRUE)
+    {
+        taskENTER_CRITICAL(&tx_stats_lock);
+        tx_stats.dropped++;
+        taskEXIT_CRITICAL(&tx_stats_lock);
+        xQueueSend(s_tx_free, &pkt, 0);
+        return;
+    }
+    uint32_t depth = uxQueueMessagesWaiting(s_tx_queue);
+    taskENTER_CRITICAL(&tx_stats_lock);
+    tx_stats.queued++;
+    if (depth > tx_stats.max_depth)
+    {
+        tx_stats.max_depth = depth;
     }
+    taskEXIT_CRITICAL(&tx_stats_lock);
 }
 
-void send_data_esp_now(const uint8_t *data, size_t len)
+// Copy data into pooled packets and queue them (control frames and other
+// callers that don't build in place)
+void send_data_esp_now(const uint8_t *data, size_t len, bool is_control)
 {
-    size_t offset = 0;
+    if (s_tx_queue == NULL || len == 0)
+    {
+        return;
+    }
 
-    while (offset < len)
+    size_t chunk_count = (len + ESP_NOW_PACKET_SIZE - 1) / ESP_NOW_PACKET_SIZE;
+    for (size_t n = 0; n < chunk_count; n++)
     {
+        // Front-queued chunks are pushed last-to-first so they still go out in order
+        size_t index = is_control ? chunk_count - 1 - n : n;
+        size_t offset = index * ESP_NOW_PACKET_SIZE;
         size_t chunk_size = len - offset > ESP_NOW_PACKET_SIZE ? ESP_NOW_PACKET_SIZE : len - offset;
 
-        esp_err_t ret = esp_now_send(broadcast_mac, data + offset, chunk_size);
-        if (ret != ESP_OK)
+        esp_now_tx_packet_t *pkt = tx_packet_get();
+        if (pkt == NULL)
         {
-            ESP_LOGE(TAG, "ESP-NOW send failed at offset %zu: %s", offset, esp_err_to_name(ret));
+            continue;
         }
-        else
+        memcpy(pkt->data, data + offset, chunk_size);
+        pkt->len = chunk_size;
+        tx_packet_submit(pkt, is_control);
+    }
+}
+
+// Drains the TX queue, paced by send-completion tokens instead of fixed sleeps
+void esp_now_tx_task(void *arg)
+{
+    esp_now_tx_packet_t *pkt;
+    while (1)
+    {
+        if (xQueueReceive(s_tx_queue, &pkt, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        // Wait for a free slot. A send callback normally returns within a
+        // few ms, so a timeout means a completion was lost: the token is
+        // reclaimed and the packet sent rather than stalling the queue for
+        // good. If the completion was only late, its give is absorbed by the
+        // semaphore's ESP_NOW_TX_TOKENS ceiling, so the limit is exceeded by
+        // at most this one packet and then restores itself.
+        if (xSemaphoreTake(s_tx_tokens, pdMS_TO_TICKS(ESP_NOW_TX_TOKEN_TIMEOUT_MS)) != pdTRUE)
+        {
+            taskENTER_CRITICAL(&tx_stats_lock);
+            tx_stats.token_timeouts++;
+            taskEXIT_CRITICAL(&tx_stats_lock);
+        }
+
+        // esp_now_send() copies the frame, so the buffer is free again on return
+        esp_err_t ret = esp_now_send(broadcast_mac, pkt->data, pkt->len);
+        xQueueSend(s_tx_free, &pkt, 0);
+        if (ret != ESP_OK)
         {
-            // ESP_LOGI(TAG, "Sent %zu bytes of data via ESP-NOW (offset %zu)", chunk_size, offset);
+            taskENTER_CRITICAL(&tx_stats_lock);
+            tx_stats.send_failed++;
+            taskEXIT_CRITICAL(&tx_stats_lock);
+            xSemaphoreGive(s_tx_tokens);
         }
+    }
+}
 
-        offset += chunk_size;
-        vTaskDelay(pdMS_TO_TICKS(16));
+// Broadcast a floor control message
+void send_floor_op(floor_op_t op, uint8_t prio)
+{
+    if (op == FLOOR_OP_NONE)
+    {
+        return;
+    }
+    uint8_t payload[2] = {(uint8_t)op, prio};
+    uint8_t buf[BB_PKT_HEADER_SIZE + sizeof(payload)];
+    size_t len = build_control_packet(buf, BB_PKT_FLOOR, payload, sizeof(payload));
+    send_data_esp_now(buf, len, true);
+}
+
+// Get received data (non-blocking). Hand the buffer back with rx_packet_release.
+esp_now_recv_data_t *get_esp_now_data(void)
+{
+    esp_now_recv_data_t *recv_data = NULL;
+    if (s_recv_queue == NULL || xQueueReceive(s_recv_queue, &recv_data, 0) != pdTRUE)
+    {
+        return NULL;
     }
+    lat_hist_add(&rx_queue_hist, (uint32_t)((esp_timer_get_time() - recv_data->rx_us) / 100));
+    return recv_data;
+}
+
+void rx_packet_release(esp_now_recv_data_t *recv_data)
+{
+    xQueueSend(s_rx_free, &recv_data, 0);
 }
 
-// Get received data (non-blocking)
-bool get_esp_now_data(esp_now_recv_data_t *recv_data)
+// Display server: one task owns the frame buffer. Other tasks post commands;
+// animations are timelines ticked by the task instead of a task each.
+#define DISP_QUEUE_LEN 16
+#define DISP_MAX_ANIMS 4
+#define DISP_TEXT_MAX RX_EVENT_TEXT_MAX
+#define DISP_FADE_STEPS 15 // Peer count fade in, one step per 1000 / 15 ms
+#define DISP_STEP_MS (1000 / 15)
+
+typedef enum
+{
+    DISP_CMD_SCENE,      // value: UI state, anim: the command animation for state 3
+    DISP_CMD_PEER_COUNT, // text: count to fade in
+    DISP_CMD_BUBBLE,     // text: message to slide in
+    DISP_CMD_IMAGE,      // Status and battery icons
+    DISP_CMD_BYEBYE,     // notify: task to wake when the animation is done
+} disp_cmd_type_t;
+
+typedef struct
 {
-    if (s_recv_queue == NULL || recv_data == NULL)
+    disp_cmd_type_t type;
+    int value;
+    spi_oled_animation_t *anim;
+    TaskHandle_t notify;
+    uint8_t x, y, width, height;
+    const uint8_t *image;
+    char text[DISP_TEXT_MAX];
+} disp_cmd_t;
+
+static QueueHandle_t s_disp_queue = NULL;
+static uint32_t disp_dropped = 0; // Under display_stats_lock, posted from any task
+
+// Never blocks: a full queue drops the command
+static bool display_post(const disp_cmd_t *cmd)
+{
+    if (s_disp_queue == NULL || xQueueSend(s_disp_queue, cmd, 0) != pdTRUE)
     {
+        taskENTER_CRITICAL(&display_stats_lock);
+        disp_dropped++;
+        taskEXIT_CRITICAL(&display_stats_lock);
         return false;
     }
+    return true;
+}
+
+static void display_post_text(disp_cmd_type_t type, const char *text)
+{
+    disp_cmd_t cmd = {.type = type};
+    strncpy(cmd.text, text, sizeof(cmd.text) - 1);
+    display_post(&cmd);
+}
+
+static void display_post_image(uint8_t x, uint8_t y, uint8_t width, uint8_t height, const uint8_t *image)
+{
+    disp_cmd_t cmd = {.type = DISP_CMD_IMAGE, .x = x, .y = y, .width = width, .height = height, .image = image};
+    display_post(&cmd);
+}
 
-    return (xQueueReceive(s_recv_queue, recv_data, 0) == pdTRUE);
+// State below is touched by the display task only
+static spi_oled_animation_t *disp_anims[DISP_MAX_ANIMS];
+static int disp_scene = -1;
+static bool disp_first_idle = true;
+static char disp_count_text[4];
+static int disp_count_step = DISP_FADE_STEPS; // DISP_FADE_STEPS: not fading
+static uint32_t disp_count_next_ms;
+static char disp_bubble_text[DISP_TEXT_MAX];
+static int disp_bubble_y = 0;                 // Slides from -6 to -1, 0: not sliding
+static uint32_t disp_bubble_next_ms;
+static int disp_byebye_frame = -1;            // Counts over three loops, -1: not playing
+static uint32_t disp_byebye_next_ms;
+static TaskHandle_t disp_byebye_notify;
+
+// Due if the deadline falls within half a display tick
+static bool display_due(uint32_t now_ms, uint32_t due_ms)
+{
+    return (int32_t)(now_ms - due_ms) >= -(DISPLAY_TICK_MS / 2);
 }
 
-// Fade in drawText
-void fade_in_drawCount(void *arg)
+static void display_start(spi_oled_animation_t *a, uint32_t now_ms)
 {
-    const char *input_text = (const char *)arg;
-    if (input_text == NULL || strlen(input_text) == 0)
+    int slot = -1;
+    for (int i = 0; i < DISP_MAX_ANIMS; i++)
     {
-        printf("Invalid text\n");
-        vTaskDelete(NULL);
+        if (disp_anims[i] == a)
+        {
+            slot = i; // Still running on to its stop frame, restart it
+            break;
+        }
+        if (disp_anims[i] == NULL && slot < 0)
+        {
+            slot = i;
+        }
+    }
+    if (slot < 0)
+    {
+        ESP_LOGW(TAG, "No timeline slot for animation");
         return;
     }
-    for (int i = 0; i < 15; i++)
+    disp_anims[slot] = a;
+    a->is_playing = true;
+    a->current_frame = 0;
+    a->next_ms = now_ms;
+}
+
+// Stop every animation. Ones with a stop frame run on to it unless forced.
+static void display_stop_all(bool force)
+{
+    for (int i = 0; i < DISP_MAX_ANIMS; i++)
     {
-        if (state == 0)
+        spi_oled_animation_t *a = disp_anims[i];
+        if (a == NULL)
         {
-            spi_oled_drawText(&spi_ssd1327, 86, 46, &font_30, i / 2, input_text, 0);
-            spi_oled_drawText(&spi_ssd1327, 85, 45, &font_30, i, input_text, 0);
+            continue;
         }
-        else
+        a->is_playing = false;
+        if (force || a->stop_frame == -1)
         {
-            vTaskDelete(NULL);
+            disp_anims[i] = NULL;
         }
-        vTaskDelay(pdMS_TO_TICKS(1000 / 15));
     }
-    vTaskDelete(NULL);
 }
 
-// Animation task function
-static void animation_task(void *pvParameters)
+// MultiNet 返回拼音，气泡里显示对应的汉字
+static const char *display_phrase(const char *text)
 {
-    spi_oled_animation_t *anim = (spi_oled_animation_t *)pvParameters;
-    if (anim == NULL)
+    for (size_t i = 0; i < sizeof(font_cjk_10_phrases) / sizeof(font_cjk_10_phrases[0]); i++)
     {
-        // Handle error - invalid key
-        printf("Invalid animation parameters\n");
-        vTaskDelete(NULL);
-        return;
+        if (strcmp(text, font_cjk_10_phrases[i][0]) == 0)
+        {
+            return font_cjk_10_phrases[i][1];
+        }
+    }
+    return text;
+}
+
+static void display_set_scene(int scene, spi_oled_animation_t *cmd_anim, uint32_t now_ms)
+{
+    display_stop_all(scene == 3);
+    spi_oled_draw_square(&spi_ssd1327, 0, 14, 128, 80, SSD1327_GS_0);
+    disp_scene = scene;
+    if (scene != 0)
+    {
+        disp_count_step = DISP_FADE_STEPS;
     }
-    int current_frame = 0;
-    uint8_t bytes_per_row = (anim->width + 1) / 2; // 4bpp packing
-    while ((anim->stop_frame == -1 && anim->is_playing == true) ||
-           (anim->stop_frame != -1 && (anim->is_playing == true || current_frame != anim->stop_frame)))
+    switch (scene)
     {
-        if (anim->stop_frame == -1 && anim->is_playing == false)
+    case 0: // Idle
+        display_start(&anim, now_ms);
+        display_start(disp_first_idle ? &anim_idleBar : &anim_idleWaveBar, now_ms);
+        printf("Idle job create\n");
+        break;
+    case 1: // Speaking
+        anim_waveBar.reverse = false;
+        display_start(&anim_podcast, now_ms);
+        display_start(&anim_waveBar, now_ms);
+        display_start(&anim_speaking, now_ms);
+        break;
+    case 2: // Receiving
+        anim_waveBar.reverse = true;
+        display_start(&anim_speaker, now_ms);
+        display_start(&anim_waveBar, now_ms);
+        display_start(&anim_receiving, now_ms);
+        break;
+    case 3: // Command
+        spi_oled_draw_square(&spi_ssd1327, 0, 14, 128, 114, SSD1327_GS_0);
+        if (cmd_anim != NULL)
         {
-            break;
+            display_start(cmd_anim, now_ms);
         }
-        if (anim->stop_frame != -1 && anim->is_playing == false && (state == 3 || current_frame == anim->stop_frame))
-            break; // Force break when state is 3
-        // Calculate frame data offset
-        const uint8_t *frame_data = anim->animation_data +
-                                    (current_frame * anim->height * bytes_per_row);
-
-        // Lock SPI access
-        xSemaphoreTake(spi_mutex, portMAX_DELAY);
+        break;
+    }
+    disp_first_idle = false;
+}
 
-        // Draw current frame
-        spi_oled_drawImage(&spi_ssd1327,
-                           anim->x, anim->y,
-                           anim->width, anim->height,
-                           frame_data, SSD1327_GS_15);
+static void display_handle(const disp_cmd_t *cmd, uint32_t now_ms)
+{
+    if (disp_byebye_frame >= 0)
+    {
+        return; // Shutting down, nothing else gets drawn
+    }
+    switch (cmd->type)
+    {
+    case DISP_CMD_SCENE:
+        display_set_scene(cmd->value, cmd->anim, now_ms);
+        break;
+    case DISP_CMD_PEER_COUNT:
+        memcpy(disp_count_text, cmd->text, sizeof(disp_count_text) - 1);
+        disp_count_text[sizeof(disp_count_text) - 1] = '\0';
+        spi_oled_draw_square(&spi_ssd1327, 74, 38, 36, 36, SSD1327_GS_0);
+        disp_count_step = 0;
+        disp_count_next_ms = now_ms;
+        break;
+    case DISP_CMD_BUBBLE:
+        strncpy(disp_bubble_text, display_phrase(cmd->text), sizeof(disp_bubble_text) - 1);
+        disp_bubble_y = -6;
+        disp_bubble_next_ms = now_ms;
+        break;
+    case DISP_CMD_IMAGE:
+        spi_oled_drawImage(&spi_ssd1327, cmd->x, cmd->y, cmd->width, cmd->height, cmd->image, SSD1327_GS_15);
+        break;
+    case DISP_CMD_BYEBYE:
+        display_stop_all(true);
+        disp_count_step = DISP_FADE_STEPS;
+        disp_bubble_y = 0;
+        disp_byebye_frame = 0;
+        disp_byebye_next_ms = now_ms;
+        disp_byebye_notify = cmd->notify;
+        break;
+    }
+}
 
-        // Release SPI access
-        xSemaphoreGive(spi_mutex);
+static void display_tick_anims(uint32_t now_ms)
+{
+    for (int i = 0; i < DISP_MAX_ANIMS; i++)
+    {
+        spi_oled_animation_t *a = disp_anims[i];
+        if (a == NULL || !display_due(now_ms, a->next_ms))
+        {
+            continue;
+        }
+        if (!a->is_playing && a->current_frame == a->stop_frame)
+        {
+            disp_anims[i] = NULL;
+            continue;
+        }
+        uint8_t bytes_per_row = (a->width + 1) / 2; // 4bpp packing
+        const uint8_t *frame_data = a->animation_data + (a->current_frame * a->height * bytes_per_row);
+        spi_oled_drawImage(&spi_ssd1327, a->x, a->y, a->width, a->height, frame_data, SSD1327_GS_15);
 
-        // Move to next frame
-        if (anim->reverse == true)
+        a->current_frame += a->reverse ? -1 : 1;
+        if (a->current_frame >= a->frame_count)
         {
-            current_frame--;
+            a->current_frame = 0;
         }
-        else
-            current_frame++;
-        if (current_frame >= anim->frame_count)
+        else if (a->current_frame < 0)
         {
-            current_frame = 0;
+            a->current_frame = a->frame_count - 1;
         }
-        else if (current_frame < 0)
+        // Keep the average rate; after a stall start over rather than catch up
+        a->next_ms += a->frame_delay_ms;
+        if ((int32_t)(now_ms - a->next_ms) > (int32_t)a->frame_delay_ms)
         {
-            current_frame = anim->frame_count - 1;
+            a->next_ms = now_ms + a->frame_delay_ms;
         }
-
-        vTaskDelay(pdMS_TO_TICKS(anim->frame_delay_ms));
     }
-    vTaskDelete(NULL);
 }
 
-void stopAllAnimation()
+static void display_tick_overlays(uint32_t now_ms)
 {
-    anim_waveBar.is_playing = false;
-    anim.is_playing = false;
-    anim_speaking.is_playing = false;
-    anim_receiving.is_playing = false;
-    anim_idleWaveBar.is_playing = false;
-    anim_idleBar.is_playing = false;
-    anim_podcast.is_playing = false;
-    anim_speaker.is_playing = false;
-     if (anim_currentCommand != NULL)
-                anim_currentCommand->is_playing = false;
+    if (disp_count_step < DISP_FADE_STEPS && display_due(now_ms, disp_count_next_ms))
+    {
+        spi_oled_drawText(&spi_ssd1327, 86, 46, &font_30, disp_count_step / 2, disp_count_text, 0);
+        spi_oled_drawText(&spi_ssd1327, 85, 45, &font_30, disp_count_step, disp_count_text, 0);
+        disp_count_step++;
+        disp_count_next_ms += DISP_STEP_MS;
+    }
+    if (disp_bubble_y < 0 && display_due(now_ms, disp_bubble_next_ms))
+    {
+        spi_oled_drawImage(&spi_ssd1327, 17, disp_bubble_y, 93, 11, (const uint8_t *)text_bubble, SSD1327_GS_15);
+        spi_oled_drawText(&spi_ssd1327, 18, disp_bubble_y, &font_10, SSD1327_GS_1, disp_bubble_text, 86);
+        disp_bubble_y++;
+        disp_bubble_next_ms += DISP_STEP_MS;
+    }
 }
 
-void bubble_text_task(void *arg)
+// Three loops, the last one fading out
+static void display_tick_byebye(uint32_t now_ms)
 {
-    const char *input_text = (const char *)arg;
-    if (input_text == NULL || strlen(input_text) == 0)
+    spi_oled_animation_t *a = &anim_byebye;
+    if (disp_byebye_frame < 0 || !display_due(now_ms, disp_byebye_next_ms))
+    {
+        return;
+    }
+    if (disp_byebye_frame >= 3 * a->frame_count)
     {
-        printf("Invalid text for bubble task\n");
-        vTaskDelete(NULL);
+        if (disp_byebye_notify != NULL)
+        {
+            xTaskNotifyGive(disp_byebye_notify);
+            disp_byebye_notify = NULL;
+        }
         return;
     }
+    int frame = disp_byebye_frame % a->frame_count;
+    uint8_t gray = SSD1327_GS_15;
+    if (disp_byebye_frame >= 2 * a->frame_count)
+    {
+        int fade_progress = a->frame_count - frame - 1;
+        gray = (fade_progress * 15) / (a->frame_count - 1);
+    }
+    uint8_t bytes_per_row = (a->width + 1) / 2;
+    spi_oled_drawImage(&spi_ssd1327, a->x, a->y, a->width, a->height,
+                       a->animation_data + frame * a->height * bytes_per_row, gray);
+    disp_byebye_frame++;
+    disp_byebye_next_ms += a->frame_delay_ms;
+}
+
+// Drain commands, tick timelines, then flush the compositor once per display
+// tick; render and SPI time are charged to the current UI state
+void display_task(void *arg)
+{
+    TickType_t wake = xTaskGetTickCount();
+    int64_t last_us = esp_timer_get_time();
+    ssd1327_stats_t before, after;
+    spi_oled_get_stats(&spi_ssd1327, &before);
+    while (1)
+    {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(DISPLAY_TICK_MS));
+        int64_t start_us = esp_timer_get_time();
+        uint32_t now_ms = start_us / 1000;
+        disp_cmd_t cmd;
+        while (xQueueReceive(s_disp_queue, &cmd, 0) == pdTRUE)
+        {
+            display_handle(&cmd, now_ms);
+        }
+        display_tick_anims(now_ms);
+        display_tick_overlays(now_ms);
+        display_tick_byebye(now_ms);
+        uint32_t render_us = esp_timer_get_time() - start_us;
+
+        uint32_t sent = spi_oled_flush(&spi_ssd1327);
+        spi_oled_get_stats(&spi_ssd1327, &after);
+        int64_t now_us = esp_timer_get_time();
+        int ui = (disp_scene >= 0 && disp_scene < UI_STATE_COUNT) ? disp_scene : 0;
+        taskENTER_CRITICAL(&display_stats_lock);
+        display_stats_t *ds = &display_stats[ui];
+        ds->us += now_us - last_us;
+        ds->ticks++;
+        ds->frames += sent > 0;
+        ds->bytes += after.bytes - before.bytes;
+        ds->windows += after.windows - before.windows;
+        ds->bus_us += after.bus_us - before.bus_us;
+        ds->queue_us += after.queue_us - before.queue_us;
+        ds->render_us += render_us;
+        if (render_us > ds->render_max_us)
+        {
+            ds->render_max_us = render_us;
+        }
+        taskEXIT_CRITICAL(&display_stats_lock);
+        before = after;
+        last_us = now_us;
+    }
+}
 
-    // Create a local copy to prevent corruption
-    char text[64]; // Adjust size as needed
-    strncpy(text, input_text, sizeof(text) - 1);
-    text[sizeof(text) - 1] = '\0';
+// Units on the channel, counting ourselves
+int peer_online_count(void)
+{
+    taskENTER_CRITICAL(&peer_lock);
+    int count = peers.count + 1;
+    taskEXIT_CRITICAL(&peer_lock);
+    return count;
+}
 
-    for (int i = -6; i < 0; i++)
+void rx_event_post(rx_event_type_t type, const uint8_t *mac, int16_t value, const uint8_t *text, size_t text_len)
+{
+    rx_event_t ev;
+    ev.type = type;
+    memcpy(ev.mac, mac != NULL ? mac : broadcast_mac, ESP_NOW_ETH_ALEN);
+    ev.value = value;
+    if (text_len > RX_EVENT_TEXT_MAX - 1)
     {
-        spi_oled_drawImage(&spi_ssd1327, 17, i, 93, 11, (const uint8_t *)text_bubble, SSD1327_GS_15);
-        spi_oled_drawText(&spi_ssd1327, 18, i, &font_10, SSD1327_GS_1, text, 86);
-        vTaskDelay(pdMS_TO_TICKS(1000 / 15));
+        text_len = RX_EVENT_TEXT_MAX - 1;
+    }
+    if (text_len > 0)
+    {
+        memcpy(ev.text, text, text_len);
+    }
+    ev.text[text_len] = '\0';
+    if (s_rx_event_queue == NULL || xQueueSend(s_rx_event_queue, &ev, 0) != pdTRUE)
+    {
+        rx_event_dropped++;
     }
-    vTaskDelete(NULL);
 }
 
-// ESP-NOW receive callback
-static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int data_len)
+// ESP-NOW receive callback body: classify, update cheap state, enqueue
+static void esp_now_recv_handle(const esp_now_recv_info_t *recv_info, const uint8_t *data, int data_len)
 {
     if (recv_info == NULL || data == NULL || data_len <= 0)
     {
         return;
     }
 
-    // Log reception
-    
-    ESP_ERROR_CHECK(esp_wifi_connectionless_module_set_wake_interval(0));
-    ESP_LOGI(TAG, "Received %d bytes, RSSI: %d dBm", data_len, recv_info->rx_ctrl->rssi);
+    rx_packets++;
+    rx_last_rssi = recv_info->rx_ctrl->rssi;
+
+    bb_pkt_t pkt;
+    if (!bb_pkt_parse(data, data_len, &pkt))
+    {
+        rx_invalid_count++;
+        return;
+    }
 
-    if (data_len == PING_MAGIC_LEN && memcmp(data, PING_MAGIC, PING_MAGIC_LEN) == 0) // PING MSG
+    // Per-peer link quality from every frame we hear
+    uint32_t now_ms = esp_timer_get_time() / 1000;
+    bool added;
+    taskENTER_CRITICAL(&peer_lock);
+    peer_t *peer = peer_touch(&peers, recv_info->src_addr, now_ms, &added);
+    if (peer != NULL)
     {
-        int64_t now = esp_timer_get_time() / 1000; // ms
-        bool found = false;
-        ESP_LOGI(TAG, "Received PING from %02x:%02x:%02x:%02x:%02x:%02x",
-                 recv_info->src_addr[0], recv_info->src_addr[1],
-                 recv_info->src_addr[2], recv_info->src_addr[3],
-                 recv_info->src_addr[4], recv_info->src_addr[5]);
-        for (int i = 0; i < MAX_MAC_TRACK; ++i)
+        link_update_rssi(&peer->link, recv_info->rx_ctrl->rssi);
+        if (pkt.type == BB_PKT_AUDIO)
         {
-            if (mac_track_list[i].valid &&
-                memcmp(mac_track_list[i].mac, recv_info->src_addr, ESP_NOW_ETH_ALEN) == 0)
-            {
-                mac_track_list[i].last_seen_ms = now;
-                found = true;
-                break;
-            }
+            link_update_seq(&peer->link, pkt.stream_id, pkt.seq);
+            peer_update_transit(peer, pkt.timestamp, now_ms);
         }
+    }
+    taskEXIT_CRITICAL(&peer_lock);
+    if (added)
+    {
+        rx_event_post(RX_EV_NEW_PEER, recv_info->src_addr, recv_info->rx_ctrl->rssi, NULL, 0);
+    }
 
-        if (!found)
+    switch (pkt.type)
+    {
+    case BB_PKT_PING:
+    {
+        rx_event_post(RX_EV_PING, recv_info->src_addr, recv_info->rx_ctrl->rssi, NULL, 0);
+        break;
+    }
+    case BB_PKT_CMD:
+    {
+        if (pkt.payload_len < 2)
         {
-            for (int i = 0; i < MAX_MAC_TRACK; ++i)
-            {
-                if (!mac_track_list[i].valid)
-                {
-                    memcpy(mac_track_list[i].mac, recv_info->src_addr, ESP_NOW_ETH_ALEN);
-                    mac_track_list[i].last_seen_ms = now;
-                    mac_track_list[i].valid = true;
-                    ESP_LOGI(TAG, "Added MAC");
-                    macCount += 1;
-                    break;
-                }
-            }
+            rx_invalid_count++;
+            break;
         }
+        rx_event_post(RX_EV_CMD, recv_info->src_addr, (int16_t)bb_rd16(pkt.payload), NULL, 0);
+        break;
     }
-    // CMD: prefix handling
-    else if (data_len >= 4 && memcmp(data, "CMD:", 4) == 0)
+    case BB_PKT_MSG:
     {
-        if (data_len >= 5)
+        if (pkt.payload_len == 0)
         {
-            // Extract the command parameter after "CMD:"
-            char cmd_param[32]; // Adjust size as needed
-            int param_len = data_len - 4;
-            if (param_len >= sizeof(cmd_param))
-            {
-                param_len = sizeof(cmd_param) - 1;
-            }
-            memcpy(cmd_param, data + 4, param_len);
-            cmd_param[param_len] = '\0';
+            break;
+        }
+        rx_event_post(RX_EV_MSG, recv_info->src_addr, 0, pkt.payload, pkt.payload_len);
+        break;
+    }
+    case BB_PKT_FLOOR:
+    {
+        if (pkt.payload_len < 2)
+        {
+            rx_invalid_count++;
+            break;
+        }
+        uint32_t now = esp_timer_get_time() / 1000;
+        taskENTER_CRITICAL(&floor_lock);
+        floor_op_t reply = floor_on_op(&floor_ctl, recv_info->src_addr, (floor_op_t)pkt.payload[0], pkt.payload[1], now);
+        uint8_t prio = floor_ctl.prio;
+        taskEXIT_CRITICAL(&floor_lock);
+        send_floor_op(reply, prio);
+        break;
+    }
+    case BB_PKT_AUDIO:
+    {
+        // Store in queue if available
+        if (s_recv_queue == NULL || s_rx_free == NULL || (pkt.codec != BB_CODEC_ADPCM && pkt.codec != BB_CODEC_ADPCM_RED))
+        {
+            break;
+        }
+        // Payload larger than any packet we send: not ours to play, and not a floor claim
+        if (pkt.payload_len > sizeof(((esp_now_recv_data_t *)0)->data))
+        {
+            rx_invalid_count++;
+            break;
+        }
+        taskENTER_CRITICAL(&floor_lock);
+        floor_on_audio(&floor_ctl, recv_info->src_addr, esp_timer_get_time() / 1000);
+        taskEXIT_CRITICAL(&floor_lock);
+        is_receiving = true;
 
-            // Convert to integer and handle animation
-            int cmd_value = atoi(cmd_param);
-            ESP_LOGI(TAG, "Processed CMD: %d", cmd_value);
+        // Only a talker keeps the radio awake; pings and control frames
+        // leave it at the power-saving interval, decode_Task sends it back
+        if (!radio_awake)
+        {
+            radio_awake = true;
+            rx_event_post(RX_EV_RADIO_WAKE, NULL, 0, NULL, 0);
+        }
 
-            // Handle animation for received command
-            printf("Playing animation for received command_id: %d\n", cmd_value);
-            if (anim_currentCommand != NULL)
-                anim_currentCommand->is_playing = false;
-            anim_currentCommand = get_animation_by_key(cmd_value);
-            lastState = -1;
-            is_command = true;
+        esp_now_recv_data_t *recv_data = NULL;
+        if (xQueueReceive(s_rx_free, &recv_data, 0) != pdTRUE)
+        {
+            rx_pool_exhausted++;
+            break;
+        }
+        uint32_t free_left = uxQueueMessagesWaiting(s_rx_free);
+        if (free_left < rx_pool_min_free)
+        {
+            rx_pool_min_free = free_left;
         }
+
+        memcpy(recv_data->src_addr, recv_info->src_addr, ESP_NOW_ETH_ALEN);
+        recv_data->codec = pkt.codec;
+        recv_data->stream_id = pkt.stream_id;
+        recv_data->seq = pkt.seq;
+        recv_data->timestamp = pkt.timestamp;
+        recv_data->rx_us = esp_timer_get_time();
+        memcpy(recv_data->data, pkt.payload, pkt.payload_len);
+        recv_data->data_len = pkt.payload_len;
+
+        // Send to queue, don't block if full
+        if (xQueueSend(s_recv_queue, &recv_data, 0) != pdTRUE)
+        {
+            rx_queue_full++;
+            rx_packet_release(recv_data);
+        }
+        else if (s_decode_task != NULL)
+        {
+            xTaskNotifyGive(s_decode_task);
+        }
+        break;
+    }
     }
-    // MSG: prefix handling
-    else if (data_len >= 4 && memcmp(data, "MSG:", 4) == 0)
+}
+
+static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int data_len)
+{
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    esp_now_recv_handle(recv_info, data, data_len);
+    uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+    rx_cb_cycles += cycles;
+    if (cycles > rx_cb_cycles_max)
+    {
+        rx_cb_cycles_max = cycles;
+    }
+}
+
+// Deferred receive work, in arrival order. Log lines share one rate limit.
+void rx_event_task(void *arg)
+{
+    log_rl_init(&rx_log_rl, esp_timer_get_time() / 1000);
+    rx_event_t ev;
+    while (1)
     {
-        if (data_len >= 5)
+        if (xQueueReceive(s_rx_event_queue, &ev, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+        bool log = log_rl_allow(&rx_log_rl, esp_timer_get_time() / 1000);
+        switch (ev.type)
         {
-            // Extract the message content after "MSG:"
-            char msg_content[ESP_NOW_MAX_DATA_LEN_V2]; // Adjust size as needed
-            int content_len = data_len - 4;
-            if (content_len >= sizeof(msg_content))
+        case RX_EV_PING:
+            if (log)
             {
-                content_len = sizeof(msg_content) - 1;
+                ESP_LOGI(TAG, "Received PING from %02x:%02x:%02x:%02x:%02x:%02x, RSSI: %d dBm",
+                         ev.mac[0], ev.mac[1], ev.mac[2], ev.mac[3], ev.mac[4], ev.mac[5], ev.value);
             }
-            memcpy(msg_content, data + 4, content_len);
-            msg_content[content_len] = '\0';
-            ESP_LOGI(TAG, "Processed MSG: %s", msg_content);
-
-            // Create bubble text task for received message
-            char *msg_copy = malloc(strlen(msg_content) + 1);
-            if (msg_copy != NULL)
+            break;
+        case RX_EV_NEW_PEER:
+            ESP_LOGI(TAG, "Added MAC %02x:%02x:%02x:%02x:%02x:%02x", ev.mac[0], ev.mac[1], ev.mac[2], ev.mac[3], ev.mac[4], ev.mac[5]);
+            break;
+        case RX_EV_CMD:
+            if (log)
             {
-                strcpy(msg_copy, msg_content);
-                xTaskCreate(bubble_text_task, "bubbleText", 4096, msg_copy, 5, NULL);
-                ESP_LOGI(TAG, "Created bubble_text_task for received message: %s", msg_content);
+                ESP_LOGI(TAG, "Processed CMD: %d", ev.value);
             }
-            else
+            // Handle animation for received command
+            anim_currentCommand = get_animation_by_key(ev.value);
+            lastState = -1;
+            is_command = true;
+            break;
+        case RX_EV_MSG:
+        {
+            if (log)
             {
-                ESP_LOGE(TAG, "Failed to allocate memory for bubble text message");
+                ESP_LOGI(TAG, "Processed MSG: %s", ev.text);
             }
+            // Bubble text for received message
+            display_post_text(DISP_CMD_BUBBLE, ev.text);
+            break;
+        }
+        case RX_EV_RADIO_WAKE:
+            ESP_ERROR_CHECK(esp_wifi_connectionless_module_set_wake_interval(0));
+            break;
+        case RX_EV_RADIO_SLEEP:
+            ESP_ERROR_CHECK(esp_now_set_wake_window(25));
+            ESP_ERROR_CHECK(esp_wifi_connectionless_module_set_wake_interval(100));
+            break;
         }
-    }
-    // Others MSG, Store in queue if available
-    else if (s_recv_queue != NULL)
-    {
-        is_receiving = true;
-        esp_now_recv_data_t recv_data;
-
-        // Copy data (with size check)
-        size_t copy_len = (data_len > ESP_NOW_MAX_DATA_LEN_V2) ? ESP_NOW_MAX_DATA_LEN_V2 : data_len;
-        memcpy(recv_data.data, data, copy_len);
-        recv_data.data_len = copy_len;
-
-        // Send to queue, don't block if full
-        xQueueSend(s_recv_queue, &recv_data, 0);
     }
 }
 
@@ -548,6 +1177,15 @@ bool init_esp_now()
         return false;
     }
 
+    // Floor control tie-breaks on the station MAC, set it up before anything arrives
+    uint8_t self_mac[ESP_NOW_ETH_ALEN];
+    ESP_ERROR_CHECK(esp_wifi_get_mac(WIFI_IF_STA, self_mac));
+    floor_init(&floor_ctl, self_mac);
+
+    // Deferred receive work runs below the audio tasks
+    s_rx_event_queue = xQueueCreate(RX_EVENT_QUEUE_LEN, sizeof(rx_event_t));
+    xTaskCreatePinnedToCore(rx_event_task, "espnowRxEv", 4 * 1024, NULL, 4, NULL, 0);
+
     // Register callbacks
     esp_now_register_send_cb(esp_now_send_cb);
     esp_now_register_recv_cb(esp_now_recv_cb);
@@ -565,208 +1203,895 @@ bool init_esp_now()
         return false;
     }
 
-    ESP_ERROR_CHECK(esp_now_set_wake_window(25));
-    ESP_ERROR_CHECK(esp_wifi_connectionless_module_set_wake_interval(100));
-
-    // Create receive queue (holds up to 10 messages)
-    s_recv_queue = xQueueCreate(10, sizeof(esp_now_recv_data_t));
+    ESP_ERROR_CHECK(esp_now_set_wake_window(25));
+    ESP_ERROR_CHECK(esp_wifi_connectionless_module_set_wake_interval(100));
+
+    // Receive queue and its buffer pool
+    s_recv_queue = xQueueCreate(ESP_NOW_RX_QUEUE_LEN, sizeof(esp_now_recv_data_t *));
+    s_rx_free = xQueueCreate(ESP_NOW_RX_POOL, sizeof(esp_now_recv_data_t *));
+    for (int i = 0; i < ESP_NOW_RX_POOL; ++i)
+    {
+        esp_now_recv_data_t *recv_data = &rx_pool[i];
+        xQueueSend(s_rx_free, &recv_data, 0);
+    }
+
+    // TX queue and token bucket (tokens are returned by esp_now_send_cb)
+    s_tx_queue = xQueueCreate(ESP_NOW_TX_QUEUE_LEN, sizeof(esp_now_tx_packet_t *));
+    s_tx_free = xQueueCreate(ESP_NOW_TX_POOL, sizeof(esp_now_tx_packet_t *));
+    for (int i = 0; i < ESP_NOW_TX_POOL; ++i)
+    {
+        esp_now_tx_packet_t *pkt = &tx_pool[i];
+        xQueueSend(s_tx_free, &pkt, 0);
+    }
+    s_tx_tokens = xSemaphoreCreateCounting(ESP_NOW_TX_TOKENS, ESP_NOW_TX_TOKENS);
+    xTaskCreatePinnedToCore(esp_now_tx_task, "espnowTx", 3 * 1024, NULL, 6, NULL, 0);
+
+    ESP_LOGI(TAG, "ESP-NOW initialized successfully");
+    return true;
+}
+
+// Mean square of every stride-th sample
+static uint32_t pcm_mean_square(const int16_t *pcm, size_t samples, size_t stride)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < samples; i++)
+    {
+        int32_t s = pcm[i * stride];
+        sum += (uint32_t)(s * s);
+    }
+    return samples ? (uint32_t)(sum / samples) : 0;
+}
+
+void feed_Task(void *arg)
+{
+    esp_afe_sr_data_t *afe_data = arg;
+    int audio_chunksize = afe_handle->get_feed_chunksize(afe_data);
+    int nch = afe_handle->get_feed_channel_num(afe_data);
+    int feed_channel = esp_get_feed_channel();
+    printf("feed chunksize:%d, channel:%d\n", audio_chunksize, nch);
+    assert(nch == feed_channel);
+    int16_t *i2s_buff = malloc(audio_chunksize * sizeof(int16_t) * feed_channel);
+    assert(i2s_buff);
+
+    while (1)
+    {
+        esp_get_feed_data(true, i2s_buff, audio_chunksize * sizeof(int16_t) * feed_channel);
+        if (aec_ref_channel >= 0)
+        {
+            aec_ref_power = pcm_mean_square(i2s_buff + aec_ref_channel, audio_chunksize, feed_channel);
+        }
+        afe_handle->feed(afe_data, i2s_buff);
+    }
+    if (i2s_buff)
+    {
+        free(i2s_buff);
+        i2s_buff = NULL;
+    }
+    vTaskDelete(NULL);
+}
+
+// Redundancy level for the next packet: fixed by tx_red_level, or picked
+// from the worst link among peers heard recently (we broadcast to all of
+// them). The peer scan runs at most every TX_RED_RECHECK_MS, or when
+// tx_red_stale is set (burst start, peers expired), and takes peer_lock
+// one slot at a time so interrupts stay on across the table.
+uint8_t choose_tx_red_level(void)
+{
+    if (tx_red_level != ADPCM_RED_LEVEL_AUTO)
+    {
+        return tx_red_level > BB_RED_MAX ? BB_RED_MAX : tx_red_level;
+    }
+
+    uint32_t now = esp_timer_get_time() / 1000;
+    if (!tx_red_stale && now - tx_red_checked_ms < TX_RED_RECHECK_MS)
+    {
+        return tx_red_auto;
+    }
+    tx_red_stale = false;
+    tx_red_checked_ms = now;
+
+    bool have_peer = false;
+    int worst_rssi = 0;
+    uint32_t worst_loss = 0;
+    for (int i = 0; i < PEER_SLOTS; ++i)
+    {
+        taskENTER_CRITICAL(&peer_lock);
+        const peer_t *entry = &peers.slots[i];
+        bool live = entry->used && entry->link.have_rssi && now - entry->last_seen_ms <= MAC_TIMEOUT_MS;
+        int rssi = live ? link_rssi(&entry->link) : 0;
+        uint32_t loss = entry->link.loss_q16;
+        taskEXIT_CRITICAL(&peer_lock);
+        if (!live)
+        {
+            continue;
+        }
+        if (!have_peer || rssi < worst_rssi)
+        {
+            worst_rssi = rssi;
+        }
+        if (loss > worst_loss)
+        {
+            worst_loss = loss;
+        }
+        have_peer = true;
+    }
+    tx_red_auto = have_peer ? link_choose_red_level(worst_rssi, worst_loss, ADPCM_ENC_MAX_BYTES, BB_PKT_HEADER_SIZE,
+                                                    ESP_NOW_PACKET_SIZE, BB_RED_MAX, (float)ADPCM_FRAME_MS,
+                                                    (float)JB_MIN_DELAY_MS, (float)JB_MAX_DELAY_MS)
+                            : 0;
+    return tx_red_auto;
+}
+
+// Open the burst-long encoder session (no-op if already open)
+bool open_adpcm_encoder(adpcm_encode_buffer_t *enc_buf)
+{
+    if (enc_buf->encoder != NULL)
+    {
+        return true;
+    }
+
+    esp_adpcm_enc_config_t adpcm_cfg = {
+        .sample_rate = SAMPLE_RATE,
+        .bits_per_sample = BIT_DEPTH,
+        .channel = 1};
+
+    esp_audio_enc_config_t enc_cfg = {
+        .type = ESP_AUDIO_TYPE_ADPCM,
+        .cfg = &adpcm_cfg,
+        .cfg_sz = sizeof(adpcm_cfg)};
+
+    enc_buf->heap_at_open = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    enc_buf->stream_id++;
+    enc_buf->seq = 0;
+    tx_red_stale = true; // A new burst starts from current link stats
+    enc_buf->red_level = choose_tx_red_level();
+    enc_buf->red_count = 0;
+    enc_buf->red_head = 0;
+    enc_buf->frames = 0;
+    enc_buf->cycles = 0;
+
+    esp_audio_err_t ret = esp_audio_enc_open(&enc_cfg, &enc_buf->encoder);
+    if (ret != ESP_AUDIO_ERR_OK)
+    {
+        ESP_LOGE(TAG, "ADPCM encoder open failed: %d", ret);
+        enc_buf->encoder = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Close the encoder session at burst end and report cycles/frame and heap delta
+void close_adpcm_encoder(adpcm_encode_buffer_t *enc_buf)
+{
+    if (enc_buf->encoder == NULL)
+    {
+        return;
+    }
+    esp_audio_enc_close(enc_buf->encoder);
+    enc_buf->encoder = NULL;
+
+    int heap_delta = enc_buf->heap_at_open - (int)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "Encoder burst: %" PRIu32 " frames, %" PRIu64 " cycles/frame, heap delta %d bytes",
+             enc_buf->frames, enc_buf->frames ? enc_buf->cycles / enc_buf->frames : 0, heap_delta);
+}
+
+// Encode one ADPCM_FRAME_SIZE frame from pcm straight into a packet at adpcm_output
+void encode_adpcm(adpcm_encode_buffer_t *enc_buf, const int16_t *pcm, uint8_t *adpcm_output, size_t *adpcm_len)
+{
+    *adpcm_len = 0;
+    if (!open_adpcm_encoder(enc_buf))
+    {
+        return;
+    }
+
+    // Prepare I/O frames with aligned length
+    esp_audio_enc_in_frame_t in_frame = {
+        .buffer = (uint8_t *)pcm,
+        .len = ADPCM_FRAME_BYTES};
+
+    // Follow the link; a new level takes effect on this packet
+    uint8_t level = choose_tx_red_level();
+    if (level != enc_buf->red_level)
+    {
+        ESP_LOGI(TAG, "Redundancy level %u -> %u at seq %u", enc_buf->red_level, level, enc_buf->seq);
+        enc_buf->red_level = level;
+        tx_link_switches++;
+    }
+
+    // Leave room for the packet header and redundant frames in front of the encoded frame.
+    // Always send `level` copies so the receiver sizes its delay from the first packet;
+    // frames from before the burst started go out empty.
+    const uint8_t *red[BB_RED_MAX];
+    uint16_t red_len[BB_RED_MAX];
+    for (int i = 0; i < level; i++)
+    {
+        int idx = (enc_buf->red_head + BB_RED_MAX - i) % BB_RED_MAX;
+        red[i] = enc_buf->red_frames[idx];
+        red_len[i] = i < enc_buf->red_count ? enc_buf->red_len[idx] : 0;
+    }
+    size_t red_size = level ? bb_red_block_size(level, red_len) : 0;
+    uint8_t *primary = adpcm_output + BB_PKT_HEADER_SIZE + red_size;
+    esp_audio_enc_out_frame_t out_frame = {
+        .buffer = primary,
+        .len = ADPCM_ENC_MAX_BYTES};
+
+    // Capture time of the first sample in this frame
+    uint32_t timestamp = (uint32_t)(esp_timer_get_time() / 1000) - ADPCM_FRAME_MS;
+
+    // Encode
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    esp_audio_err_t ret = esp_audio_enc_process(enc_buf->encoder, &in_frame, &out_frame);
+    enc_buf->cycles += esp_cpu_get_cycle_count() - c0;
+    enc_buf->frames++;
+
+    if (ret != ESP_AUDIO_ERR_OK || out_frame.encoded_bytes == 0)
+    {
+        return;
+    }
+
+    bb_codec_t codec = BB_CODEC_ADPCM;
+    size_t payload_len = out_frame.encoded_bytes;
+    if (level)
+    {
+        bb_red_write(adpcm_output + BB_PKT_HEADER_SIZE, level, red, red_len);
+        codec = BB_CODEC_ADPCM_RED;
+        payload_len += red_size;
+        tx_bytes_copied += red_size;
+    }
+
+    // Keep full history regardless of level so it can be raised mid-burst;
+    // the packet buffer goes back to the pool, so the frame is kept by copy
+    enc_buf->red_head = (enc_buf->red_head + 1) % BB_RED_MAX;
+    memcpy(enc_buf->red_frames[enc_buf->red_head], primary, out_frame.encoded_bytes);
+    enc_buf->red_len[enc_buf->red_head] = out_frame.encoded_bytes;
+    tx_bytes_copied += out_frame.encoded_bytes;
+    if (enc_buf->red_count < BB_RED_MAX)
+    {
+        enc_buf->red_count++;
+    }
+
+    *adpcm_len = bb_pkt_write_header(adpcm_output, BB_PKT_AUDIO, codec,
+                                     enc_buf->stream_id, enc_buf->seq++, timestamp,
+                                     payload_len);
+}
+
+// Boot-time encoder benchmark, off unless ENCODE_BENCH_SECONDS is set: one
+// burst of `seconds` of speech through encode_adpcm, then the same frames
+// the way the baseline encoded them (register, open and process per frame,
+// never closed). The baseline leaks a handle per frame, so it stops early
+// once 64 KB of heap is gone and reports the leak per frame.
+void encode_bench(uint32_t seconds)
+{
+    static int16_t pcm[ADPCM_FRAME_SIZE];
+    static uint8_t out[ESP_NOW_PACKET_SIZE];
+    static adpcm_encode_buffer_t enc;
+    uint32_t frames = seconds * SAMPLE_RATE / ADPCM_FRAME_SIZE;
+    for (int i = 0; i < ADPCM_FRAME_SIZE; i++)
+    {
+        // 440 Hz at -12 dBFS with a little noise, so the encoder has work to do
+        pcm[i] = (int16_t)(8192.0f * sinf(2.0f * (float)M_PI * 440.0f * i / SAMPLE_RATE) + (rand() % 512) - 256);
+    }
+
+    esp_audio_enc_register_default();
+    memset(&enc, 0, sizeof(enc));
+    int heap0 = (int)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    uint64_t cycles = 0;
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        size_t len;
+        encode_adpcm(&enc, pcm, out, &len);
+        uint32_t c1 = esp_cpu_get_cycle_count();
+        cycles += c1 - c0;
+        c0 = c1;
+        if ((f & 255) == 0)
+        {
+            vTaskDelay(1); // Let the idle task feed the watchdog
+            c0 = esp_cpu_get_cycle_count();
+        }
+    }
+    close_adpcm_encoder(&enc);
+    int heap_delta = heap0 - (int)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "Encode bench, one encoder: %" PRIu32 " frames, %" PRIu64 " cycles/frame (packet included), heap delta %d bytes",
+             frames, frames ? cycles / frames : 0, heap_delta);
+
+    esp_adpcm_enc_config_t adpcm_cfg = {
+        .sample_rate = SAMPLE_RATE,
+        .bits_per_sample = BIT_DEPTH,
+        .channel = 1};
+    esp_audio_enc_config_t enc_cfg = {
+        .type = ESP_AUDIO_TYPE_ADPCM,
+        .cfg = &adpcm_cfg,
+        .cfg_sz = sizeof(adpcm_cfg)};
+    heap0 = (int)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    cycles = 0;
+    uint32_t f = 0;
+    for (; f < frames && heap0 - (int)heap_caps_get_free_size(MALLOC_CAP_8BIT) < 64 * 1024; f++)
+    {
+        c0 = esp_cpu_get_cycle_count();
+        esp_audio_enc_register_default();
+        esp_audio_enc_handle_t encoder = NULL;
+        esp_audio_enc_open(&enc_cfg, &encoder);
+        esp_audio_enc_in_frame_t in_frame = {.buffer = (uint8_t *)pcm, .len = ADPCM_FRAME_BYTES};
+        esp_audio_enc_out_frame_t out_frame = {.buffer = out, .len = ADPCM_ENC_MAX_BYTES};
+        esp_audio_enc_process(encoder, &in_frame, &out_frame);
+        cycles += esp_cpu_get_cycle_count() - c0;
+        if ((f & 255) == 0)
+        {
+            vTaskDelay(1);
+        }
+    }
+    heap_delta = heap0 - (int)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "Encode bench, baseline: %" PRIu32 " frames%s, %" PRIu64 " cycles/frame, heap delta %d bytes (%d per frame)",
+             f, f < frames ? " (stopped, heap)" : "", f ? cycles / f : 0, heap_delta, f ? heap_delta / (int)f : 0);
+    tx_bytes_copied = 0;
+    tx_speech_samples = 0;
+    tx_link_switches = 0;
+}
+
+void decode_adpcm(esp_audio_dec_handle_t decoder, const uint8_t *adpcm_data, size_t adpcm_len, uint8_t *pcm_output, size_t *pcm_len)
+{
+    // Prepare I/O frames with aligned length
+    esp_audio_dec_in_raw_t raw = {
+        .buffer = (uint8_t *)adpcm_data,
+        .len = adpcm_len};
+
+    esp_audio_dec_out_frame_t out_frame = {
+        .buffer = (uint8_t *)pcm_output,
+        .len = adpcm_len * 4}; // Assuming 16-bit PCM
+
+    // Decode
+    *pcm_len = 0;
+    if (esp_audio_dec_process(decoder, &raw, &out_frame) == ESP_AUDIO_ERR_OK)
+    {
+        *pcm_len = out_frame.decoded_size;
+    }
+}
+
+void rx_stream_close(rx_stream_t *rx)
+{
+    if (!rx->valid)
+    {
+        return;
+    }
+    esp_audio_dec_close(rx->decoder);
+    rx->valid = false;
+}
+
+bool rx_stream_open(rx_stream_t *rx, const uint8_t *mac)
+{
+    esp_adpcm_dec_cfg_t adpcm_cfg = {
+        .sample_rate = SAMPLE_RATE,
+        .bits_per_sample = BIT_DEPTH / 4,
+        .channel = 1};
+
+    esp_audio_dec_cfg_t dec_cfg = {
+        .type = ESP_AUDIO_TYPE_ADPCM,
+        .cfg = &adpcm_cfg,
+        .cfg_sz = sizeof(adpcm_cfg)};
+
+    if (esp_audio_dec_open(&dec_cfg, &rx->decoder) != ESP_AUDIO_ERR_OK)
+    {
+        ESP_LOGE(TAG, "ADPCM decoder open failed");
+        return false;
+    }
+    memcpy(rx->mac, mac, ESP_NOW_ETH_ALEN);
+    rx->last_recv = xTaskGetTickCount();
+    jb_init(&rx->jb, ADPCM_FRAME_MS, JB_MIN_DELAY_MS, JB_MAX_DELAY_MS);
+    plc_init(&rx->plc);
+    rx->agc = agc_custom;
+    limiter_init(&rx->lim);
+    rx->fifo_head = 0;
+    rx->fifo_count = 0;
+    rx->joined = false;
+    rx->valid = true;
+    return true;
+}
+
+// Find the stream for a sender, opening one (or recycling the least recently heard) if needed
+rx_stream_t *get_rx_stream(const uint8_t *mac)
+{
+    rx_stream_t *lru = &rx_streams[0];
+    for (int i = 0; i < MAX_RX_STREAMS; ++i)
+    {
+        rx_stream_t *rx = &rx_streams[i];
+        if (rx->valid && memcmp(rx->mac, mac, ESP_NOW_ETH_ALEN) == 0)
+        {
+            return rx;
+        }
+        if (!rx->valid)
+        {
+            lru = rx;
+        }
+        else if (lru->valid && rx->last_recv < lru->last_recv)
+        {
+            lru = rx;
+        }
+    }
+
+    rx_stream_close(lru);
+    return rx_stream_open(lru, mac) ? lru : NULL;
+}
+
+void rx_stream_push(rx_stream_t *rx, const int16_t *pcm, size_t samples)
+{
+    if (samples > RX_STREAM_FIFO - rx->fifo_count)
+    {
+        rx_fifo_overflow += samples - (RX_STREAM_FIFO - rx->fifo_count);
+        samples = RX_STREAM_FIFO - rx->fifo_count;
+    }
+    size_t tail = (rx->fifo_head + rx->fifo_count) % RX_STREAM_FIFO;
+    size_t first = RX_STREAM_FIFO - tail < samples ? RX_STREAM_FIFO - tail : samples;
+    memcpy(&rx->fifo[tail], pcm, first * sizeof(int16_t));
+    memcpy(&rx->fifo[0], pcm + first, (samples - first) * sizeof(int16_t));
+    rx->fifo_count += samples;
+    rx->joined = true;
+}
+
+void rx_stream_pull(rx_stream_t *rx, int16_t *out, size_t samples)
+{
+    size_t first = RX_STREAM_FIFO - rx->fifo_head < samples ? RX_STREAM_FIFO - rx->fifo_head : samples;
+    memcpy(out, &rx->fifo[rx->fifo_head], first * sizeof(int16_t));
+    memcpy(out + first, &rx->fifo[0], (samples - first) * sizeof(int16_t));
+    rx->fifo_head = (rx->fifo_head + samples) % RX_STREAM_FIFO;
+    rx->fifo_count -= samples;
+}
+
+// A stream takes part in mixing from its first decoded frame while it is
+// playing or still has samples queued; a talker that is still buffering
+// its first frames doesn't hold up the others
+bool rx_stream_mixing(const rx_stream_t *rx)
+{
+    return rx->valid && (rx->fifo_count > 0 || (rx->joined && !jb_idle(&rx->jb)));
+}
+
+// Sum the sources that all have samples ready into play_stream_buf
+void mix_rx_streams(void)
+{
+    static int16_t mix_buf[MIX_CHUNK_SAMPLES] __attribute__((aligned(MIXER_ALIGN)));
+    static int16_t src_buf[MIX_CHUNK_SAMPLES] __attribute__((aligned(MIXER_ALIGN)));
+
+    while (1)
+    {
+        // Only mix what every participating source can supply, so none gets gaps
+        size_t n = MIX_CHUNK_SAMPLES;
+        int sources = 0;
+        for (int i = 0; i < MAX_RX_STREAMS; ++i)
+        {
+            if (rx_stream_mixing(&rx_streams[i]))
+            {
+                if (rx_streams[i].fifo_count < n)
+                {
+                    n = rx_streams[i].fifo_count;
+                }
+                sources++;
+            }
+        }
+        // Leave in the FIFOs whatever i2s_writer_task has no room for yet
+        size_t space = xStreamBufferSpacesAvailable(play_stream_buf) / sizeof(int16_t);
+        if (space < n)
+        {
+            n = space;
+        }
+        if (sources == 0 || n == 0)
+        {
+            return;
+        }
+
+        bool first = true;
+        for (int i = 0; i < MAX_RX_STREAMS; ++i)
+        {
+            if (!rx_stream_mixing(&rx_streams[i]))
+            {
+                continue;
+            }
+            if (first)
+            {
+                rx_stream_pull(&rx_streams[i], mix_buf, n);
+                first = false;
+            }
+            else
+            {
+                rx_stream_pull(&rx_streams[i], src_buf, n);
+                mixer_add_s16(mix_buf, src_buf, n);
+            }
+        }
+        size_t sent = xStreamBufferSend(play_stream_buf, mix_buf, n * sizeof(int16_t), 0);
+        if (sent < n * sizeof(int16_t))
+        {
+            mix_dropped += n - sent / sizeof(int16_t);
+            return;
+        }
+    }
+}
+
+// Play out one stream's due frames into its FIFO: decode, conceal losses, level with its own AGC
+// and limiter (the limiter delays the stream by LIMITER_LOOKAHEAD samples, drained on underrun)
+void rx_stream_play(rx_stream_t *rx, uint32_t now_ms, uint8_t *frame, uint8_t *pcm_buffer)
+{
+    size_t frame_len = 0;
+    size_t pcm_len = 0;
+    jb_result_t jb_ret;
+    while ((jb_ret = jb_get(&rx->jb, now_ms, frame, &frame_len)) != JB_EMPTY)
+    {
+        pcm_len = 0;
+        if (jb_ret == JB_FRAME)
+        {
+            decode_adpcm(rx->decoder, frame, frame_len, pcm_buffer, &pcm_len);
+        }
+        uint32_t c0 = esp_cpu_get_cycle_count();
+        if (jb_ret == JB_FRAME)
+        {
+            lat_hist_add(&rx_playout_hist, now_ms - rx->jb.played_arrival_ms);
+        }
+        if (pcm_len > 0)
+        {
+            plc_good_frame(&rx->plc, (int16_t *)pcm_buffer, pcm_len / sizeof(int16_t));
+            rx_frames_played++;
+        }
+        else
+        {
+            // Lost, undecodable or late frame: fill the gap (fades out on underrun)
+            plc_conceal(&rx->plc, (int16_t *)pcm_buffer, ADPCM_FRAME_SIZE);
+            pcm_len = ADPCM_FRAME_BYTES;
+            rx_frames_concealed++;
+        }
+        plc_cycles += esp_cpu_get_cycle_count() - c0;
+
+        c0 = esp_cpu_get_cycle_count();
+        int32_t g0 = agc_update(&rx->agc, (const int16_t *)pcm_buffer, pcm_len / sizeof(int16_t));
+        uint32_t limited = rx->lim.limited;
+        limiter_process(&rx->lim, (int16_t *)pcm_buffer, pcm_len / sizeof(int16_t), g0, rx->agc.gain_q15);
+        lim_samples += rx->lim.limited - limited;
+        if (rx->lim.min_gain < lim_min_gain)
+        {
+            lim_min_gain = rx->lim.min_gain;
+        }
+        rx->lim.min_gain = LIMITER_UNITY;
+        agc_cycles += esp_cpu_get_cycle_count() - c0;
+        agc_samples += pcm_len / sizeof(int16_t);
+        rx_stream_push(rx, (const int16_t *)pcm_buffer, pcm_len / sizeof(int16_t));
 
-    ESP_LOGI(TAG, "ESP-NOW initialized successfully");
-    return true;
+        if (jb_ret == JB_UNDERRUN)
+        {
+            // Stream ran dry: play the limiter's look-ahead tail before the output fades out
+            size_t tail = limiter_drain(&rx->lim, (int16_t *)pcm_buffer);
+            rx_stream_push(rx, (const int16_t *)pcm_buffer, tail);
+            break;
+        }
+    }
 }
 
-void feed_Task(void *arg)
+// Route one received packet to its sender's jitter buffer
+void rx_route_packet(const esp_now_recv_data_t *recv_data, TickType_t now_ticks)
 {
-    esp_afe_sr_data_t *afe_data = arg;
-    int audio_chunksize = afe_handle->get_feed_chunksize(afe_data);
-    int nch = afe_handle->get_feed_channel_num(afe_data);
-    int feed_channel = esp_get_feed_channel();
-    printf("feed chunksize:%d, channel:%d\n", audio_chunksize, nch);
-    assert(nch == feed_channel);
-    int16_t *i2s_buff = malloc(audio_chunksize * sizeof(int16_t) * feed_channel);
-    assert(i2s_buff);
+    rx_stream_t *rx = get_rx_stream(recv_data->src_addr);
+    if (rx == NULL)
+    {
+        return;
+    }
+    rx->last_recv = now_ticks;
 
-    while (1)
+    bb_red_t red = {0};
+    red.primary = recv_data->data;
+    red.primary_len = recv_data->data_len;
+    if (recv_data->codec == BB_CODEC_ADPCM_RED && !bb_red_parse(recv_data->data, recv_data->data_len, &red))
     {
-        esp_get_feed_data(true, i2s_buff, audio_chunksize * sizeof(int16_t) * feed_channel);
-        afe_handle->feed(afe_data, i2s_buff);
+        rx_invalid_count++;
+        return;
     }
-    if (i2s_buff)
+    uint32_t arrival_ms = (uint32_t)(recv_data->rx_us / 1000);
+    // Hold playout long enough for the last redundant copy of each frame to arrive
+    jb_set_redundancy(&rx->jb, red.count);
+    jb_put(&rx->jb, recv_data->stream_id, recv_data->seq, recv_data->timestamp,
+           red.primary, red.primary_len, arrival_ms);
+
+    // Redundant copies fill holes left by lost packets
+    for (int i = 0; i < red.count; i++)
     {
-        free(i2s_buff);
-        i2s_buff = NULL;
+        if (red.red_len[i] > 0 && jb_put_redundant(&rx->jb, recv_data->stream_id, recv_data->seq - (i + 1),
+                             recv_data->timestamp - (i + 1) * ADPCM_FRAME_MS, red.red[i], red.red_len[i]))
+        {
+            red_recovered++;
+        }
     }
-    vTaskDelete(NULL);
 }
 
-void encode_adpcm(const int16_t *pcm_data, size_t pcm_len_bytes, uint8_t *adpcm_output, size_t *adpcm_len)
+static void decode_timer_cb(void *arg)
 {
-    // Register adpcm encoder
-    esp_audio_enc_register_default();
-    // Config
-    esp_adpcm_enc_config_t adpcm_cfg = {
-        .sample_rate = SAMPLE_RATE,
-        .bits_per_sample = BIT_DEPTH,
-        .channel = 1};
-
-    esp_audio_enc_config_t enc_cfg = {
-        .type = ESP_AUDIO_TYPE_ADPCM,
-        .cfg = &adpcm_cfg,
-        .cfg_sz = sizeof(adpcm_cfg)};
-
-    esp_audio_enc_handle_t encoder;
-    esp_audio_enc_open(&enc_cfg, &encoder);
-
-    // Prepare I/O frames with aligned length
-    esp_audio_enc_in_frame_t in_frame = {
-        .buffer = (uint8_t *)pcm_data,
-        .len = pcm_len_bytes};
-
-    esp_audio_enc_out_frame_t out_frame = {
-        .buffer = adpcm_output,
-        .len = (pcm_len_bytes / 4) + 7};
-
-    // Encode
-    esp_audio_enc_process(encoder, &in_frame, &out_frame);
-    *adpcm_len = out_frame.encoded_bytes;
+    xTaskNotifyGive(s_decode_task);
 }
 
-void decode_adpcm(const uint8_t *adpcm_data, size_t adpcm_len, uint8_t *pcm_output, size_t *pcm_len)
+// Arm the wake-up for the earliest playout deadline. Returns how long the
+// task may otherwise sleep: long enough to notice a burst ending while any
+// stream is live, forever when there is nothing at all.
+TickType_t decode_schedule(uint32_t now_ms, bool any_stream)
 {
-    // Register adpcm decoder
-    esp_audio_dec_register_default();
-    // Config
-    esp_adpcm_dec_cfg_t adpcm_cfg = {
-        .sample_rate = SAMPLE_RATE,
-        .bits_per_sample = BIT_DEPTH / 4,
-        .channel = 1};
-
-    esp_audio_dec_cfg_t dec_cfg = {
-        .type = ESP_AUDIO_TYPE_ADPCM,
-        .cfg = &adpcm_cfg,
-        .cfg_sz = sizeof(adpcm_cfg)};
-
-    esp_audio_dec_handle_t decoder;
-    esp_audio_dec_open(&dec_cfg, &decoder);
-
-    // Prepare I/O frames with aligned length
-    esp_audio_dec_in_raw_t raw = {
-        .buffer = adpcm_data,
-        .len = adpcm_len};
-
-    esp_audio_dec_out_frame_t out_frame = {
-        .buffer = (uint8_t *)pcm_output,
-        .len = adpcm_len * 4}; // Assuming 16-bit PCM
-
-    // Decode
-    esp_audio_dec_process(decoder, &raw, &out_frame);
-    *pcm_len = ADPCM_FRAME_SIZE * 2;//out_frame.len;
+    uint32_t due_ms = UINT32_MAX;
+    for (int i = 0; i < MAX_RX_STREAMS; ++i)
+    {
+        uint32_t due;
+        if (rx_streams[i].valid && jb_next_due(&rx_streams[i].jb, now_ms, &due) && due < due_ms)
+        {
+            due_ms = due;
+        }
+    }
+    esp_timer_stop(s_decode_timer);
+    if (due_ms != UINT32_MAX)
+    {
+        esp_timer_start_once(s_decode_timer, (uint64_t)(due_ms > 0 ? due_ms : 1) * 1000);
+    }
+    return (any_stream || is_receiving) ? pdMS_TO_TICKS(DECODE_CHECK_MS) : portMAX_DELAY;
 }
 
 void decode_Task(void *arg)
 {
-    uint8_t *pcm_buffer = malloc(ENCODED_BUF_SIZE);
-    size_t pcm_len = 0;
+    uint8_t *pcm_buffer = heap_caps_aligned_alloc(16, ENCODED_BUF_SIZE, MALLOC_CAP_8BIT); // Aligned for the SIMD kernels
+    esp_audio_dec_register_default();
+    rx_streams = heap_caps_calloc(MAX_RX_STREAMS, sizeof(rx_stream_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    assert(rx_streams);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = decode_timer_cb,
+        .name = "decode"};
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_decode_timer));
+    s_decode_task = xTaskGetCurrentTaskHandle();
 
+    static uint8_t frame[JB_MAX_PAYLOAD]; // Off the 4 KB stack
     TickType_t last_recv_time = xTaskGetTickCount();
+    TickType_t wait = 0;
 
     while (1)
     {
-        esp_now_recv_data_t recv_data;
-        if (get_esp_now_data(&recv_data))
+        // Sleep until a packet is queued or a playout deadline passes
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        // Route everything that arrived to its sender's jitter buffer
+        esp_now_recv_data_t *recv_data;
+        while ((recv_data = get_esp_now_data()) != NULL)
         {
             is_receiving = true;
             last_recv_time = xTaskGetTickCount();
-
-            //printf("Received %d bytes\n", recv_data.data_len);
-            decode_adpcm(recv_data.data, recv_data.data_len, pcm_buffer, &pcm_len);
-            size_t sent = xStreamBufferSend(play_stream_buf, pcm_buffer, pcm_len, 0);
+            rx_route_packet(recv_data, last_recv_time);
+            rx_packet_release(recv_data);
         }
-        else if (xTaskGetTickCount() - last_recv_time > pdMS_TO_TICKS(128))
-        {
-            is_receiving = false;
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
 
-            ESP_ERROR_CHECK(esp_now_set_wake_window(25));
-            ESP_ERROR_CHECK(esp_wifi_connectionless_module_set_wake_interval(100));
-
-            const int silence_samples = 512;                                        // Adjust this number as needed
-            int16_t *silence_buffer = calloc(silence_samples * 2, sizeof(int16_t)); // Already all zeros
+        // Play out what has reached its deadline, then mix all talkers
+        bool any_stream = false;
+        for (int i = 0; i < MAX_RX_STREAMS; ++i)
+        {
+            rx_stream_t *rx = &rx_streams[i];
+            if (!rx->valid)
+            {
+                continue;
+            }
+            rx_stream_play(rx, now_ms, frame, pcm_buffer);
 
-            if (silence_buffer != NULL)
+            // A talker's stream ends once drained and silent for a while
+            TickType_t burst_timeout = pdMS_TO_TICKS(rx->jb.target_delay_ms + 2 * ADPCM_FRAME_MS);
+            if (burst_timeout < pdMS_TO_TICKS(128))
             {
-                esp_err_t ret = esp_audio_play(silence_buffer, silence_samples, portMAX_DELAY);
-                if (ret != ESP_OK)
-                {
-                    printf("Failed to end audio: %s", esp_err_to_name(ret));
-                }
-                free(silence_buffer);
+                burst_timeout = pdMS_TO_TICKS(128);
+            }
+            if (jb_idle(&rx->jb) && rx->fifo_count == 0 && xTaskGetTickCount() - rx->last_recv > burst_timeout)
+            {
+                rx_stream_close(rx);
+                continue;
             }
+            any_stream = true;
+        }
+        mix_rx_streams();
+
+        // Burst over: back to the power-saving wake interval, once.
+        // The output shuts itself down (i2s_writer_task).
+        if (is_receiving && !any_stream && xTaskGetTickCount() - last_recv_time > pdMS_TO_TICKS(128))
+        {
+            is_receiving = false;
+            rx_event_post(RX_EV_RADIO_SLEEP, NULL, 0, NULL, 0);
+            // Cleared after the post, so a WAKE for the next talker queues behind it
+            radio_awake = false;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(16));
+        wait = decode_schedule(now_ms, any_stream);
     }
 }
 
 // 初始化编码缓冲区（在 detect_Task 开始时调用）
 void init_encode_buffer(adpcm_encode_buffer_t *enc_buf) {
-    enc_buf->current_samples = 0;
+    enc_buf->encoder = NULL;
+    // 编码器只需注册一次
+    esp_audio_enc_register_default();
 }
 
-// 编码并发送数据，自动处理缓冲
-void encode_and_send(adpcm_encode_buffer_t *enc_buf, 
-                     const int16_t *pcm_data, 
-                     size_t pcm_samples,
-                     uint8_t *adpcm_output) {
-    size_t samples_processed = 0;
-    
-    while (samples_processed < pcm_samples) {
-        // 计算本次可以复制多少样本
-        size_t samples_to_copy = ADPCM_FRAME_SIZE - enc_buf->current_samples;
-        size_t samples_available = pcm_samples - samples_processed;
-        
-        if (samples_to_copy > samples_available) {
-            samples_to_copy = samples_available;
-        }
-        
-        // 复制数据到缓冲区
-        memcpy(&enc_buf->buffer[enc_buf->current_samples],
-               &pcm_data[samples_processed],
-               samples_to_copy * sizeof(int16_t));
-        
-        enc_buf->current_samples += samples_to_copy;
-        samples_processed += samples_to_copy;
-        
-        // 如果缓冲区满了，进行编码并发送
-        if (enc_buf->current_samples == ADPCM_FRAME_SIZE) {
-            size_t adpcm_len = 0;
-            encode_adpcm(enc_buf->buffer, ADPCM_FRAME_BYTES, adpcm_output, &adpcm_len);
-            
-            if (adpcm_len > 0) {
-                send_data_esp_now(adpcm_output, adpcm_len);
+// 编码一帧并直接写入发送池中的包
+void send_adpcm_frame(adpcm_encode_buffer_t *enc_buf, const int16_t *pcm)
+{
+    esp_now_tx_packet_t *pkt = tx_packet_get();
+    if (pkt == NULL)
+    {
+        return;
+    }
+    size_t adpcm_len = 0;
+    encode_adpcm(enc_buf, pcm, pkt->data, &adpcm_len);
+    tx_speech_samples += ADPCM_FRAME_SIZE;
+    if (adpcm_len == 0)
+    {
+        xQueueSend(s_tx_free, &pkt, 0);
+        return;
+    }
+    pkt->len = adpcm_len;
+    tx_packet_submit(pkt, false);
+}
+
+// Keep speech until we may send it; the one copy of the PCM on the send
+// side, skipped by frames tx_speech_push encodes in place. On overflow the oldest whole frames are dropped, which keeps
+// hold_head frame aligned.
+void hold_push(const int16_t *pcm, size_t samples)
+{
+    if (samples > FLOOR_HOLD_SAMPLES)
+    {
+        hold_dropped += samples - FLOOR_HOLD_SAMPLES;
+        pcm += samples - FLOOR_HOLD_SAMPLES;
+        samples = FLOOR_HOLD_SAMPLES;
+    }
+    if (samples > FLOOR_HOLD_SAMPLES - hold_count)
+    {
+        size_t drop = samples - (FLOOR_HOLD_SAMPLES - hold_count);
+        drop = (drop + ADPCM_FRAME_SIZE - 1) / ADPCM_FRAME_SIZE * ADPCM_FRAME_SIZE;
+        if (drop >= hold_count)
+        {
+            drop = hold_count;
+            hold_head = 0;
+        }
+        else
+        {
+            hold_head = (hold_head + drop) % FLOOR_HOLD_SAMPLES;
+        }
+        hold_count -= drop;
+        hold_dropped += drop;
+    }
+    size_t tail = (hold_head + hold_count) % FLOOR_HOLD_SAMPLES;
+    size_t first = FLOOR_HOLD_SAMPLES - tail < samples ? FLOOR_HOLD_SAMPLES - tail : samples;
+    memcpy(&hold_buf[tail], pcm, first * sizeof(int16_t));
+    memcpy(&hold_buf[0], pcm + first, (samples - first) * sizeof(int16_t));
+    hold_count += samples;
+    tx_bytes_copied += samples * sizeof(int16_t);
+    if (hold_count > hold_max)
+    {
+        hold_max = hold_count;
+    }
+}
+
+// Speech on its way out. While we hold the floor and no whole frame is held,
+// frames are encoded straight from the AFE buffer: a partial frame left by
+// the previous chunk is completed in the ring first, and only the new
+// remainder (under one frame) is copied. Otherwise everything is held.
+void tx_speech_push(const int16_t *pcm, size_t samples)
+{
+    taskENTER_CRITICAL(&floor_lock);
+    bool may_send = floor_may_send(&floor_ctl);
+    taskEXIT_CRITICAL(&floor_lock);
+
+    if (may_send && hold_count < ADPCM_FRAME_SIZE)
+    {
+        if (hold_count > 0)
+        {
+            size_t fill = ADPCM_FRAME_SIZE - hold_count;
+            if (fill > samples)
+            {
+                fill = samples;
             }
-            
-            // 重置缓冲区
-            enc_buf->current_samples = 0;
+            hold_push(pcm, fill);
+            pcm += fill;
+            samples -= fill;
+            if (hold_count == ADPCM_FRAME_SIZE)
+            {
+                // hold_head is frame aligned, so the frame is contiguous
+                send_adpcm_frame(&encode_buffer, &hold_buf[hold_head]);
+                hold_head = (hold_head + ADPCM_FRAME_SIZE) % FLOOR_HOLD_SAMPLES;
+                hold_count = 0;
+                tx_frames_held++;
+                tx_sent_direct += ADPCM_FRAME_SIZE;
+            }
+        }
+        while (hold_count == 0 && samples >= ADPCM_FRAME_SIZE)
+        {
+            send_adpcm_frame(&encode_buffer, pcm);
+            pcm += ADPCM_FRAME_SIZE;
+            samples -= ADPCM_FRAME_SIZE;
+            tx_frames_direct++;
+            tx_sent_direct += ADPCM_FRAME_SIZE;
         }
     }
+    if (samples > 0)
+    {
+        hold_push(pcm, samples);
+    }
 }
 
-// 刷新缓冲区（在语音结束时调用）
-void flush_encode_buffer(adpcm_encode_buffer_t *enc_buf, uint8_t *adpcm_output) {
-    if (enc_buf->current_samples > 0) {
-        // 用静音填充剩余部分
-        memset(&enc_buf->buffer[enc_buf->current_samples], 0, 
-               (ADPCM_FRAME_SIZE - enc_buf->current_samples) * sizeof(int16_t));
-        
-        size_t adpcm_len = 0;
-        encode_adpcm(enc_buf->buffer, ADPCM_FRAME_BYTES, adpcm_output, &adpcm_len);
-        
-        if (adpcm_len > 0) {
-            send_data_esp_now(adpcm_output, adpcm_len);
+// Called once per AFE chunk: negotiate the floor and, while we hold it,
+// encode held speech at capture rate. Releases the floor once drained.
+void floor_tx_service(size_t chunk_samples)
+{
+    uint32_t now_ms = esp_timer_get_time() / 1000;
+    bool pending = is_capturing || hold_count > 0;
+
+    taskENTER_CRITICAL(&floor_lock);
+    floor_op_t tick_op = floor_tick(&floor_ctl, now_ms);
+    floor_op_t want_op = pending ? floor_want_talk(&floor_ctl, now_ms) : FLOOR_OP_NONE;
+    bool may_send = floor_may_send(&floor_ctl);
+    uint8_t prio = floor_ctl.prio;
+    taskEXIT_CRITICAL(&floor_lock);
+    send_floor_op(tick_op, prio);
+    send_floor_op(want_op, prio);
+
+    if (!may_send)
+    {
+        // Lost the floor mid-burst: end our stream, the rest stays held
+        if (encode_buffer.encoder != NULL)
+        {
+            close_adpcm_encoder(&encode_buffer);
+        }
+        tx_credit = 0;
+        tx_sent_direct = 0;
+        is_speaking = false;
+        return;
+    }
+    is_speaking = pending;
+
+    // Held frames are encoded in place from the ring, less what this chunk
+    // already sent from the AFE buffer
+    tx_credit += chunk_samples;
+    tx_credit = tx_credit > tx_sent_direct ? tx_credit - tx_sent_direct : 0;
+    tx_sent_direct = 0;
+    while (tx_credit >= ADPCM_FRAME_SIZE && hold_count >= ADPCM_FRAME_SIZE)
+    {
+        send_adpcm_frame(&encode_buffer, &hold_buf[hold_head]);
+        hold_head = (hold_head + ADPCM_FRAME_SIZE) % FLOOR_HOLD_SAMPLES;
+        hold_count -= ADPCM_FRAME_SIZE;
+        tx_credit -= ADPCM_FRAME_SIZE;
+        tx_frames_held++;
+    }
+    if (tx_credit > ADPCM_FRAME_SIZE + chunk_samples)
+    {
+        tx_credit = ADPCM_FRAME_SIZE + chunk_samples; // Don't bank credit while the ring is short
+    }
+
+    if (!is_capturing && hold_count < ADPCM_FRAME_SIZE)
+    {
+        // 讲话结束：不满一帧的尾巴补零后发出，然后交出发言权
+        if (hold_count > 0)
+        {
+            memcpy(encode_buffer.buffer, &hold_buf[hold_head], hold_count * sizeof(int16_t));
+            memset(&encode_buffer.buffer[hold_count], 0, (ADPCM_FRAME_SIZE - hold_count) * sizeof(int16_t));
+            tx_bytes_copied += hold_count * sizeof(int16_t);
+            send_adpcm_frame(&encode_buffer, encode_buffer.buffer);
+            tx_frames_held++;
         }
-        
-        enc_buf->current_samples = 0;
+        hold_head = 0;
+        hold_count = 0;
+        tx_credit = 0;
+        is_speaking = false;
+        close_adpcm_encoder(&encode_buffer);
+        taskENTER_CRITICAL(&floor_lock);
+        floor_op_t op = floor_release(&floor_ctl);
+        taskEXIT_CRITICAL(&floor_lock);
+        send_floor_op(op, prio);
+    }
+}
+
+// While playing out, capture only if the AEC has a live far-end reference
+// to cancel and the near end is clearly above it (talking over someone);
+// otherwise the VAD is most likely firing on our own speaker.
+static bool double_talk(const int16_t *pcm, size_t samples)
+{
+    uint32_t ref = aec_ref_power;
+    if (!aec_active || ref < DOUBLE_TALK_REF_MIN)
+    {
+        return false;
     }
+    return (uint64_t)pcm_mean_square(pcm, samples, 1) >= (uint64_t)ref * DOUBLE_TALK_MARGIN;
 }
 
 void detect_Task(void *arg)
@@ -784,7 +2109,8 @@ void detect_Task(void *arg)
     printf("------------detect start------------\n");
     printf("------------vad start------------\n");
 
-    uint8_t *adpcm_output = malloc(ENCODED_BUF_SIZE);
+    hold_buf = heap_caps_malloc(FLOOR_HOLD_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    assert(hold_buf);
     
     // 初始化编码缓冲区
     printf("detect_Task init_encode_buffer\n");
@@ -801,22 +2127,21 @@ void detect_Task(void *arg)
             break;
         }
 
-        // save speech data
-        if (res->vad_state != VAD_SILENCE && !is_receiving && !isMicOff)
+        // save speech data; it is held until we have the floor, so talking over someone isn't lost
+        bool speech = res->vad_state != VAD_SILENCE && !isMicOff;
+        if (speech && is_receiving)
         {
-            is_speaking = true;
-
-            if (adpcm_output == NULL)
-            {
-                printf("Failed to allocate adpcm buffer\n");
-                return;
-            }
+            speech = double_talk(res->data, res->data_size / sizeof(int16_t));
+        }
+        if (speech)
+        {
+            is_capturing = true;
 
             // 处理 VAD cache
             if (res->vad_cache_size > 0)
             {
                 size_t cache_samples = res->vad_cache_size / sizeof(int16_t);
-                encode_and_send(&encode_buffer, res->vad_cache, cache_samples, adpcm_output);
+                tx_speech_push(res->vad_cache, cache_samples);
                 
                 // MultiNet 检测
                 size_t num_chunks = cache_samples / mu_chunksize;
@@ -831,16 +2156,11 @@ void detect_Task(void *arg)
             if (res->vad_state == VAD_SPEECH)
             {
                 size_t data_samples = res->data_size / sizeof(int16_t);
-                encode_and_send(&encode_buffer, res->data, data_samples, adpcm_output);
+                tx_speech_push(res->data, data_samples);
                 mn_state = multinet->detect(model_data, res->data);
             }
             
             // MultiNet words detect
-            if (mn_state == ESP_MN_STATE_DETECTING)
-            {
-                continue;
-            }
-
             if (mn_state == ESP_MN_STATE_DETECTED)
             {
                 esp_mn_results_t *mn_result = multinet->get_results(model_data);
@@ -851,66 +2171,186 @@ void detect_Task(void *arg)
                            mn_result->string, mn_result->prob[i]);
                 }
                 printf("Playing animation for command_id: %d\n", mn_result->command_id[0]);
-                if (anim_currentCommand != NULL)
-                    anim_currentCommand->is_playing = false;
                 anim_currentCommand = get_animation_by_key(mn_result->command_id[0]);
                 lastState = -1;
                 is_command = true;
 
                 // Send CMD via ESP-NOW
-                char cmd_buffer[32];
-                int cmd_len = snprintf(cmd_buffer, sizeof(cmd_buffer), "CMD:%d", mn_result->command_id[0]);
-                if (cmd_len > 0 && cmd_len < sizeof(cmd_buffer))
-                {
-                    send_data_esp_now((const uint8_t *)cmd_buffer, cmd_len);
-                    ESP_LOGI(TAG, "Sent CMD via ESP-NOW: %d", mn_result->command_id[0]);
-                }
+                uint8_t cmd_buffer[BB_PKT_HEADER_SIZE + 2];
+                uint8_t cmd_id[2];
+                bb_wr16(cmd_id, (uint16_t)mn_result->command_id[0]);
+                size_t cmd_len = build_control_packet(cmd_buffer, BB_PKT_CMD, cmd_id, sizeof(cmd_id));
+                send_data_esp_now(cmd_buffer, cmd_len, true);
+                ESP_LOGI(TAG, "Sent CMD via ESP-NOW: %d", mn_result->command_id[0]);
             }
             if (mn_state == ESP_MN_STATE_TIMEOUT)
             {
                 esp_mn_results_t *mn_result = multinet->get_results(model_data);
                 printf("timeout, string:%s\n", mn_result->string);
-                xTaskCreate(bubble_text_task, "bubbleText", 4096, mn_result->string, 5, NULL);
+                display_post_text(DISP_CMD_BUBBLE, mn_result->string);
 
                 // Send MSG via ESP-NOW
-                char msg_buffer[ESP_NOW_MAX_DATA_LEN_V2];
-                int msg_len = snprintf(msg_buffer, sizeof(msg_buffer), "MSG:%s", mn_result->string);
-                if (msg_len > 0 && msg_len < sizeof(msg_buffer))
+                uint8_t msg_buffer[ESP_NOW_PACKET_SIZE];
+                size_t text_len = strlen(mn_result->string);
+                if (text_len > 0)
                 {
-                    send_data_esp_now((const uint8_t *)msg_buffer, msg_len);
+                    size_t msg_len = build_control_packet(msg_buffer, BB_PKT_MSG, mn_result->string, text_len);
+                    send_data_esp_now(msg_buffer, msg_len, true);
                     ESP_LOGI(TAG, "Sent timeout MSG via ESP-NOW: %s", mn_result->string);
                 }
-                continue;
             }
         }
         else
         {
-            if (is_speaking == true)
-            { 
-                // 刷新缓冲区中剩余的数据
-                flush_encode_buffer(&encode_buffer, adpcm_output);
+            if (is_capturing)
+            {
                 printf("clean\n");
                 multinet->clean(model_data);
             }
-            is_speaking = false;
+            is_capturing = false;
         }
+
+        floor_tx_service(afe_chunksize);
     }
     
-    if (adpcm_output)
-    {
-        free(adpcm_output);
-    }
     vTaskDelete(NULL);
 }
 
 void ping_task(void *arg)
 {
-    send_data_esp_now((const uint8_t *)PING_MAGIC, PING_MAGIC_LEN);
+    uint8_t ping[BB_PKT_HEADER_SIZE];
+    size_t ping_len = build_control_packet(ping, BB_PKT_PING, NULL, 0);
+    send_data_esp_now(ping, ping_len, true);
     // ping every 10 seconds
     while (1)
     {
         vTaskDelay(pdMS_TO_TICKS(10000)); // 10 seconds
-        send_data_esp_now((const uint8_t *)PING_MAGIC, PING_MAGIC_LEN);
+        ping_len = build_control_packet(ping, BB_PKT_PING, NULL, 0);
+        send_data_esp_now(ping, ping_len, true);
+        taskENTER_CRITICAL(&tx_stats_lock);
+        esp_now_tx_stats_t tx = tx_stats;
+        taskEXIT_CRITICAL(&tx_stats_lock);
+        ESP_LOGI(TAG, "TX stats: queued %" PRIu32 ", sent %" PRIu32 ", dropped %" PRIu32 ", failed %" PRIu32 ", token timeouts %" PRIu32 ", depth %u (max %" PRIu32 ")",
+                 tx.queued, tx.sent, tx.dropped, tx.send_failed, tx.token_timeouts,
+                 (unsigned)uxQueueMessagesWaiting(s_tx_queue), tx.max_depth);
+        ESP_LOGI(TAG, "TX copy: %" PRIu64 " bytes per second of speech (%" PRIu64 " bytes, %" PRIu64 " samples), frames direct %" PRIu32 ", held %" PRIu32 ", pool free %u",
+                 tx_speech_samples ? tx_bytes_copied * SAMPLE_RATE / tx_speech_samples : 0,
+                 tx_bytes_copied, tx_speech_samples, tx_frames_direct, tx_frames_held,
+                 (unsigned)uxQueueMessagesWaiting(s_tx_free));
+        ESP_LOGI(TAG, "RX stats: invalid %" PRIu32 ", queue full %" PRIu32 ", pool free %u/%d (low %" PRIu32 "), pool exhausted %" PRIu32,
+                 rx_invalid_count, rx_queue_full, (unsigned)uxQueueMessagesWaiting(s_rx_free), ESP_NOW_RX_POOL,
+                 rx_pool_min_free, rx_pool_exhausted);
+        rx_pool_min_free = ESP_NOW_RX_POOL;
+        ESP_LOGI(TAG, "RX callback: %" PRIu32 " packets, last RSSI %d dBm, avg %" PRIu64 " / max %" PRIu32 " cycles, events dropped %" PRIu32 ", log lines suppressed %" PRIu32,
+                 rx_packets, rx_last_rssi, rx_packets ? rx_cb_cycles / rx_packets : 0, rx_cb_cycles_max, rx_event_dropped,
+                 rx_log_rl.suppressed);
+        rx_cb_cycles_max = 0;
+        ESP_LOGI(TAG, "RX latency: queue p50 %.1f / p99 %.1f / max %.1f ms, to playout p50 %" PRIu32 " / p90 %" PRIu32 " / p99 %" PRIu32 " / max %" PRIu32 " ms",
+                 lat_hist_percentile(&rx_queue_hist, 50) / 10.0f, lat_hist_percentile(&rx_queue_hist, 99) / 10.0f,
+                 rx_queue_hist.max / 10.0f, lat_hist_percentile(&rx_playout_hist, 50),
+                 lat_hist_percentile(&rx_playout_hist, 90), lat_hist_percentile(&rx_playout_hist, 99), rx_playout_hist.max);
+        lat_hist_reset(&rx_queue_hist);
+        lat_hist_reset(&rx_playout_hist);
+        ESP_LOGI(TAG, "Floor: state %d, requests %" PRIu32 ", granted %" PRIu32 ", yielded %" PRIu32 ", collisions %" PRIu32 ", held max %u ms, dropped %" PRIu32 " ms",
+                 floor_ctl.state, floor_ctl.stats.requests, floor_ctl.stats.granted,
+                 floor_ctl.stats.yielded, floor_ctl.stats.collisions,
+                 (unsigned)(hold_max * 1000 / SAMPLE_RATE), hold_dropped * 1000 / SAMPLE_RATE);
+        uint32_t now_ms = esp_timer_get_time() / 1000;
+        taskENTER_CRITICAL(&peer_lock);
+        int expired = peer_expire(&peers, now_ms, MAC_TIMEOUT_MS);
+        uint32_t peers_full = peers.full;
+        taskEXIT_CRITICAL(&peer_lock);
+        if (expired > 0)
+        {
+            tx_red_stale = true;
+        }
+        ESP_LOGI(TAG, "Peers: %d online, %d expired, %" PRIu32 " refused (registry full)", peer_online_count() - 1, expired, peers_full);
+        for (int i = 0; i < PEER_SLOTS; ++i)
+        {
+            taskENTER_CRITICAL(&peer_lock);
+            peer_t p = peers.slots[i];
+            taskEXIT_CRITICAL(&peer_lock);
+            if (p.used)
+            {
+                ESP_LOGI(TAG, "Link %02x:%02x:%02x: RSSI %d dBm, loss %" PRIu32 "%%, jitter %u ms, seen %" PRIu32 " ms ago",
+                         p.mac[3], p.mac[4], p.mac[5], link_rssi(&p.link), p.link.loss_q16 * 100 / 65536,
+                         peer_jitter_ms(&p), now_ms - p.last_seen_ms);
+            }
+        }
+        ESP_LOGI(TAG, "TX redundancy level %u, %" PRIu32 " link switches", encode_buffer.red_level, tx_link_switches);
+        for (int i = 0; rx_streams != NULL && i < MAX_RX_STREAMS; ++i)
+        {
+            rx_stream_t *rx = &rx_streams[i];
+            if (rx->valid)
+            {
+                ESP_LOGI(TAG, "Stream %02x:%02x:%02x: played %" PRIu32 ", missing %" PRIu32 ", late %" PRIu32 ", underrun %" PRIu32 ", overrun %" PRIu32 ", jitter %u ms, target %u ms, gain %.2f",
+                         rx->mac[3], rx->mac[4], rx->mac[5],
+                         rx->jb.stats.played, rx->jb.stats.missing, rx->jb.stats.late,
+                         rx->jb.stats.underrun, rx->jb.stats.overrun,
+                         jb_jitter_ms(&rx->jb), rx->jb.target_delay_ms, rx->agc.current_gain);
+            }
+        }
+        uint32_t plc_frames = rx_frames_concealed + rx_frames_played;
+        ESP_LOGI(TAG, "Loss: %" PRIu32 " frames rebuilt from redundancy, %" PRIu32 " concealed", red_recovered, rx_frames_concealed);
+        ESP_LOGI(TAG, "PLC: concealed %" PRIu32 "%%, %" PRIu64 " cycles/frame, mixer overflow %" PRIu32 " samples, dropped %" PRIu32 " samples",
+                 plc_frames ? rx_frames_concealed * 100 / plc_frames : 0,
+                 plc_frames ? plc_cycles / plc_frames : 0, rx_fifo_overflow, mix_dropped);
+        ESP_LOGI(TAG, "AGC+limiter: %" PRIu64 ".%02" PRIu64 " cycles/sample, limited %" PRIu32 " samples, deepest %.1f dB",
+                 agc_samples ? agc_cycles / agc_samples : 0,
+                 agc_samples ? agc_cycles * 100 / agc_samples % 100 : 0,
+                 lim_samples, 20.0f * log10f((float)lim_min_gain / LIMITER_UNITY));
+        lim_min_gain = LIMITER_UNITY;
+
+        // Stack high-water marks of the tasks whose sizes were set by estimate; trim them from these
+        static const char *const stack_tasks[] = {"feed", "decode", "display", "ping"};
+        unsigned stack_free[sizeof(stack_tasks) / sizeof(stack_tasks[0])];
+        for (size_t i = 0; i < sizeof(stack_tasks) / sizeof(stack_tasks[0]); ++i)
+        {
+            TaskHandle_t task = xTaskGetHandle(stack_tasks[i]);
+            stack_free[i] = task != NULL ? (unsigned)uxTaskGetStackHighWaterMark(task) : 0;
+        }
+        ESP_LOGI(TAG, "Stack free (bytes, low-water): feed %u, decode %u, display %u, ping %u",
+                 stack_free[0], stack_free[1], stack_free[2], stack_free[3]);
+
+        uint64_t out_us[OUT_STATE_COUNT];
+        memcpy(out_us, out_state_us, sizeof(out_us));
+        out_us[out_state] += esp_timer_get_time() - out_state_since;
+        ESP_LOGI(TAG, "Output: %s, active %" PRIu64 " ms, stopping %" PRIu64 " ms, idle %" PRIu64 " ms, %" PRIu32 " wakeups",
+                 out_state_names[out_state], out_us[OUT_ACTIVE] / 1000, out_us[OUT_STOPPING] / 1000,
+                 out_us[OUT_IDLE] / 1000, out_wakeups);
+
+        bsp_play_stats_t play;
+        esp_audio_play_get_stats(&play, true);
+        ESP_LOGI(TAG, "Play: %" PRIu32 " calls, avg %" PRIu64 " us, max %" PRIu32 " us, widen %" PRIu64 " cycles/sample (%s), DMA ring %" PRIu32 " ms",
+                 play.calls, play.calls ? play.total_us / play.calls : 0, play.max_us,
+                 play.samples ? play.widen_cycles / play.samples : 0, play.pie ? "PIE" : "scalar", play.dma_ms);
+
+        display_stats_t ds[UI_STATE_COUNT];
+        taskENTER_CRITICAL(&display_stats_lock);
+        memcpy(ds, display_stats, sizeof(ds));
+        memset(display_stats, 0, sizeof(display_stats));
+        uint32_t dropped = disp_dropped;
+        taskEXIT_CRITICAL(&display_stats_lock);
+        for (int i = 0; i < UI_STATE_COUNT; ++i)
+        {
+            if (ds[i].us >= 1000000)
+            {
+                ESP_LOGI(TAG, "Display %s: %" PRIu32 " ms, %.1f fps, %" PRIu64 " SPI bytes/s, %.1f windows/frame, render %" PRIu32 " (max %" PRIu32 ") / bus %" PRIu32 " / queue %" PRIu32 " us/frame (%" PRIu32 " idle ticks)",
+                         ui_state_names[i], (uint32_t)(ds[i].us / 1000), ds[i].frames * 1e6f / ds[i].us,
+                         (uint64_t)ds[i].bytes * 1000000 / ds[i].us,
+                         ds[i].frames ? (float)ds[i].windows / ds[i].frames : 0.0f,
+                         ds[i].render_us / ds[i].ticks, ds[i].render_max_us,
+                         ds[i].frames ? ds[i].bus_us / ds[i].frames : 0, ds[i].frames ? ds[i].queue_us / ds[i].frames : 0,
+                         ds[i].ticks - ds[i].frames);
+            }
+        }
+        ssd1327_stats_t oled;
+        spi_oled_get_stats(&spi_ssd1327, &oled);
+        ESP_LOGI(TAG, "Display bus: longest frame %" PRIu32 " us, %" PRIu32 " stalls, %" PRIu32 " commands dropped",
+                 oled.bus_max_us, oled.stalls, dropped);
+        uint32_t glyphs = oled.glyph_hits + oled.glyph_misses;
+        ESP_LOGI(TAG, "Display text: %" PRIu32 " glyphs, %" PRIu32 "%% from the span cache",
+                 glyphs, glyphs ? (uint32_t)((uint64_t)oled.glyph_hits * 100 / glyphs) : 0);
     }
 }
 
@@ -918,47 +2358,11 @@ void byebye_anim(void *pvParameters)
 {
     printf("byebye_anim\n");
     spi_oled_animation_t *anim = &anim_byebye;
-    int current_frame = 0;
-    uint8_t bytes_per_row = (anim->width + 1) / 2; // 4bpp packing
-    int loop_count = 0;                            // Track which loop we're on
-
-    for (int i = 0; i < 3 * anim->frame_count; i++) // Changed to 4 loops
+    disp_cmd_t cmd = {.type = DISP_CMD_BYEBYE, .notify = xTaskGetCurrentTaskHandle()};
+    if (display_post(&cmd))
     {
-        const uint8_t *frame_data = anim->animation_data +
-                                    (current_frame * anim->height * bytes_per_row);
-
-        // Determine gray scale based on loop count
-        uint8_t gray_scale;
-        if (loop_count < 2)
-        {
-            gray_scale = SSD1327_GS_15; // Full brightness for first 3 loops
-        }
-        else
-        {
-            // Gradual fade during 4th loop: from 15 down to 0
-            int fade_progress = anim->frame_count - current_frame - 1;
-            gray_scale = (fade_progress * 15) / (anim->frame_count - 1);
-            printf("Fade progress: %d, Gray scale: %d\n", fade_progress, gray_scale);
-        }
-
-        // Lock SPI access
-        xSemaphoreTake(spi_mutex, portMAX_DELAY);
-        // Draw current frame
-        spi_oled_drawImage(&spi_ssd1327,
-                           anim->x, anim->y,
-                           anim->width, anim->height,
-                           frame_data, gray_scale);
-        // Release SPI access
-        xSemaphoreGive(spi_mutex);
-
-        // Move to next frame
-        current_frame++;
-        if (current_frame >= anim->frame_count)
-        {
-            current_frame = 0;
-            loop_count++; // Increment loop counter when we complete a full animation cycle
-        }
-        vTaskDelay(pdMS_TO_TICKS(anim->frame_delay_ms));
+        // Three loops of the animation, with a second to spare
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(3 * anim->frame_count * anim->frame_delay_ms + 1000));
     }
     // spi_oled_deinit(&spi_ssd1327);
     gpio_set_level(GPIO_NUM_3, 0);
@@ -988,20 +2392,77 @@ void byebye_sound(void *pvParameters)
     vTaskDelete(NULL);
 }
 
+void out_set_state(out_state_t state)
+{
+    int64_t now = esp_timer_get_time();
+    out_state_us[out_state] += now - out_state_since;
+    out_state_since = now;
+    out_state = state;
+}
+
+// Ramp from the last sample played to zero, then play silence until the DMA
+// ring holds nothing else, so the last audio drains and a restart plays no
+// stale data. Then stop the output (a no-op while capture shares its clock).
+void out_stop(int16_t *buf, int16_t last)
+{
+    bsp_play_stats_t play;
+    esp_audio_play_get_stats(&play, false);
+    size_t remaining = OUT_FADE_SAMPLES + play.dma_ms * SAMPLE_RATE / 1000;
+    size_t faded = 0;
+    while (remaining > 0)
+    {
+        size_t n = remaining < PLAY_CHUNK_SIZE / sizeof(int16_t) ? remaining : PLAY_CHUNK_SIZE / sizeof(int16_t);
+        for (size_t i = 0; i < n; i++, faded++)
+        {
+            buf[i] = faded < OUT_FADE_SAMPLES ? (int16_t)(last * (int32_t)(OUT_FADE_SAMPLES - 1 - faded) / OUT_FADE_SAMPLES) : 0;
+        }
+        esp_audio_play(buf, n, portMAX_DELAY);
+        remaining -= n;
+    }
+    esp_err_t ret = esp_audio_set_output(false);
+    if (ret != ESP_OK)
+    {
+        printf("Failed to stop audio: %s", esp_err_to_name(ret));
+    }
+}
+
 void i2s_writer_task(void *arg)
 {
-    uint8_t i2s_buf[PLAY_CHUNK_SIZE];
+    uint8_t i2s_buf[PLAY_CHUNK_SIZE] __attribute__((aligned(16))); // Aligned for the PIE widening in bsp_audio_play
+    int16_t *pcm = (int16_t *)i2s_buf;
+    int16_t last = 0;
+    out_state_since = esp_timer_get_time();
     while (1)
     {
-        // Block until enough PCM bytes are available
-        size_t received = xStreamBufferReceive(play_stream_buf, i2s_buf, PLAY_CHUNK_SIZE, portMAX_DELAY);
-        if (received > 0 && !isMute)
+        // Block until enough PCM bytes are available; once idle, wait without timeout
+        TickType_t wait = (out_state == OUT_IDLE) ? portMAX_DELAY : pdMS_TO_TICKS(OUT_IDLE_MS);
+        size_t received = xStreamBufferReceive(play_stream_buf, i2s_buf, PLAY_CHUNK_SIZE, wait);
+        if (received == 0)
         {
-            // Apply AGC to the audio buffer
-            apply_agc((int16_t*)i2s_buf, received / 2, &agc_custom);
-            
-            //printf("Write %zu bytes to I2S (gain: %.2f)\n", received, agc_custom.current_gain);
-            esp_err_t ret = esp_audio_play((const int16_t *)i2s_buf, received / 2, portMAX_DELAY);
+            out_set_state(OUT_STOPPING);
+            out_stop(pcm, last);
+            last = 0;
+            out_set_state(OUT_IDLE);
+            continue;
+        }
+
+        size_t n = received / sizeof(int16_t);
+        if (out_state == OUT_IDLE)
+        {
+            // First chunk of a burst: the TX channel restarts in esp_audio_play, fade in
+            for (size_t i = 0; i < n && i < OUT_FADE_SAMPLES; i++)
+            {
+                pcm[i] = (int16_t)(pcm[i] * (int32_t)i / OUT_FADE_SAMPLES);
+            }
+            out_wakeups++;
+            out_set_state(OUT_ACTIVE);
+        }
+        last = pcm[n - 1];
+
+        if (!isMute)
+        {
+            // AGC and limiter are applied per talker before mixing (rx_stream_play)
+            esp_err_t ret = esp_audio_play(pcm, n, portMAX_DELAY);
             if (ret != ESP_OK)
             {
                 printf("Failed to play audio: %s", esp_err_to_name(ret));
@@ -1020,31 +2481,31 @@ void draw_status()
 {
     if (!isMicOff)
     {
-        spi_oled_drawImage(&spi_ssd1327, 0, 0, 5, 10, (const uint8_t *)mic_high, SSD1327_GS_15);
+        display_post_image(0, 0, 5, 10, (const uint8_t *)mic_high);
     }
     else
     {
-        spi_oled_drawImage(&spi_ssd1327, 0, 0, 5, 10, (const uint8_t *)mic_off, SSD1327_GS_15);
+        display_post_image(0, 0, 5, 10, (const uint8_t *)mic_off);
     }
     if (!isMute)
     {
-        spi_oled_drawImage(&spi_ssd1327, 6, 0, 9, 10, (const uint8_t *)volume_on, SSD1327_GS_15);
+        display_post_image(6, 0, 9, 10, (const uint8_t *)volume_on);
     }
     else
     {
-        spi_oled_drawImage(&spi_ssd1327, 6, 0, 9, 10, (const uint8_t *)volume_off, SSD1327_GS_15);
+        display_post_image(6, 0, 9, 10, (const uint8_t *)volume_off);
     }
 }
 
 void setup_oled(){
         // This task is responsible for handling the OLED display
-    spi_mutex = xSemaphoreCreateMutex();
     spi_bus_config_t spi_bus_cfg = {
         .miso_io_num = -1,
         .mosi_io_num = SPI_MOSI_PIN_NUM,
         .sclk_io_num = SPI_SCK_PIN_NUM,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
+        .max_transfer_sz = SSD1327_BUFFER_SIZE, // A full frame in one DMA transfer
     };
 
     ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &spi_bus_cfg, SPI_DMA_CH_AUTO));
@@ -1054,7 +2515,9 @@ void setup_oled(){
         .clock_speed_hz = 10 * 1000 * 1000, // Clock out at 10 MHz
         .mode = 0,                          // SPI mode 0
         .spics_io_num = SPI_CS_PIN_NUM,     // CS pin
-        .queue_size = 7,                    // We want to be able to queue 7 transactions at a time
+        .queue_size = SSD1327_QUEUE_DEPTH,  // Command and data transaction for every dirty window
+        .pre_cb = spi_oled_pre_transfer_cb, // Drives DC for queued transfers
+        .post_cb = spi_oled_post_transfer_cb,
     };
 
     ESP_ERROR_CHECK(spi_bus_add_device(SPI_HOST_TAG, &dev_cfg, &oled_dev_handle));
@@ -1129,7 +2592,7 @@ void batteryLevel_Task(void *pvParameters)
             // Charge full
             if (need_update)
             {
-                spi_oled_drawImage(&spi_ssd1327, 112, 0, 16, 10, (const uint8_t *)battery_full, SSD1327_GS_15);
+                display_post_image(112, 0, 16, 10, (const uint8_t *)battery_full);
             }
         }
         else if (gpio4 == 0)
@@ -1139,7 +2602,7 @@ void batteryLevel_Task(void *pvParameters)
             {
                 blink_state = !blink_state;
                 int show_level = (blink_state) ? battery_level -1 : battery_level - 2;
-                spi_oled_drawImage(&spi_ssd1327, 112, 0, 16, 10, (const uint8_t *)icons[show_level], SSD1327_GS_15);
+                display_post_image(112, 0, 16, 10, icons[show_level]);
                 last_blink = now;
             }
         }
@@ -1148,7 +2611,7 @@ void batteryLevel_Task(void *pvParameters)
             // Not charging
             if (need_update)
             {
-                spi_oled_drawImage(&spi_ssd1327, 112, 0, 16, 10, (const uint8_t *)icons[battery_level - 1], SSD1327_GS_15);
+                display_post_image(112, 0, 16, 10, icons[battery_level - 1]);
             }
         }
 
@@ -1163,12 +2626,15 @@ void batteryLevel_Task(void *pvParameters)
 
 void oled_task(void *arg)
 {
+    s_disp_queue = xQueueCreate(DISP_QUEUE_LEN, sizeof(disp_cmd_t));
     setup_oled();
+    spi_oled_set_compose(&spi_ssd1327, true);
     printf("screen is on\n");
     spi_oled_framebuffer_clear(&spi_ssd1327, SSD1327_GS_0);
     for (size_t i = 32; i > 0; i--)
     {
         spi_oled_drawImage(&spi_ssd1327, 0, i, 128, 128, (const uint8_t *)logo, (32 - i) / 2);
+        spi_oled_flush(&spi_ssd1327);
         vTaskDelay(pdMS_TO_TICKS(1000 / 60));
     }
     printf("logo is painted\n");
@@ -1176,11 +2642,11 @@ void oled_task(void *arg)
     spi_oled_framebuffer_clear(&spi_ssd1327, SSD1327_GS_0);
     spi_oled_drawText(&spi_ssd1327, 43, 0, &font_10, SSD1327_GS_5, "bbTalkie", 0);
     spi_oled_drawText(&spi_ssd1327, 44, 0, &font_10, SSD1327_GS_15, "bbTalkie", 0);
+    // From here on the display task owns the frame buffer
+    xTaskCreatePinnedToCore(display_task, "display", 4 * 1024, NULL, 5, NULL, 0); // Text, LUT blits and the command copy
     draw_status();
     xTaskCreate(batteryLevel_Task, "battery", 4 * 1024, NULL, 5, NULL);
 
-    bool isFirstBoot = true;
-
     while (!isShutdown)
     {
         if (is_command)
@@ -1199,71 +2665,32 @@ void oled_task(void *arg)
         {
             state = 0; // Idle
         }
+        int macCount = peer_online_count();
         if (state == 0 && macCount != lastMacCount)
         {
             lastMacCount = macCount;
-            // convert macCount from int to string
-            char macCountStr[2]; // Enough space for int range + null terminator
-            sprintf(macCountStr, "%d", macCount);
-            spi_oled_draw_square(&spi_ssd1327, 74, 38, 36, 36, SSD1327_GS_0);
-            xTaskCreate(fade_in_drawCount, "drawCount", 2048, macCountStr, 5, NULL);
+            disp_cmd_t cmd = {.type = DISP_CMD_PEER_COUNT};
+            snprintf(cmd.text, sizeof(cmd.text), "%d", macCount);
+            display_post(&cmd);
         }
         if (state != lastState)
         {
-            stopAllAnimation();
-            spi_oled_draw_square(&spi_ssd1327, 0, 14, 128, 80, SSD1327_GS_0);
             lastState = state;
-            switch (state)
+            disp_cmd_t cmd = {.type = DISP_CMD_SCENE, .value = state, .anim = anim_currentCommand};
+            if (state == 0)
             {
-            case 0: // Idle
-                anim.is_playing = true;
                 lastMacCount = 0;
-                xTaskCreate(animation_task, "idleSingleAnim", 2048, &anim, 5, &anim.task_handle);
-                if (isFirstBoot)
-                {
-                    anim_idleBar.is_playing = true;
-                    xTaskCreate(animation_task, "idleBarAnim", 2048, &anim_idleBar, 5, &anim_idleBar.task_handle);
-                    isFirstBoot = false;
-                }
-                else
+            }
+            else if (state == 3)
+            {
+                printf("Command scene\n");
+                if (anim_currentCommand == NULL)
                 {
-                    anim_idleWaveBar.is_playing = true;
-                    xTaskCreate(animation_task, "idleWaveBarAnim", 2048, &anim_idleWaveBar, 5, &anim_idleWaveBar.task_handle);
-                }
-                printf("Idle job create\n");
-                break;
-            case 1: // Speaking
-                anim_waveBar.reverse = false;
-                anim_waveBar.is_playing = true;
-                anim_podcast.is_playing = true;
-                anim_speaking.is_playing = true;
-                xTaskCreate(animation_task, "podcastAnim", 2048, &anim_podcast, 5, &anim_podcast.task_handle);
-                xTaskCreate(animation_task, "waveBarAnim", 2048, &anim_waveBar, 5, &anim_waveBar.task_handle);
-                xTaskCreate(animation_task, "speakingAnim", 2048, &anim_speaking, 5, &anim_speaking.task_handle);
-                break;
-            case 2: // Receiving
-                anim_waveBar.reverse = true;
-                anim_waveBar.is_playing = true;
-                anim_speaker.is_playing = true;
-                anim_receiving.is_playing = true;
-                xTaskCreate(animation_task, "speakerAnim", 2048, &anim_speaker, 5, &anim_speaker.task_handle);
-                xTaskCreate(animation_task, "waveBarAnim", 2048, &anim_waveBar, 5, &anim_waveBar.task_handle);
-                xTaskCreate(animation_task, "receivingAnim", 2048, &anim_receiving, 5, &anim_receiving.task_handle);
-                break;
-            case 3: // Command
-                // stop idleBarAnim
-                printf("Create command anim task\n");
-                spi_oled_draw_square(&spi_ssd1327, 0, 14, 128, 114, SSD1327_GS_0);
-                if(anim_currentCommand == NULL){
                     printf("No animation for this command\n");
                     is_command = false;
-                    break;
                 }
-                anim_currentCommand->is_playing = true;
-                xTaskCreate(animation_task, "customAnim", 2048, anim_currentCommand, 5, &anim_currentCommand->task_handle);
-                break;
             }
-            isFirstBoot = false;
+            display_post(&cmd);
         }
         vTaskDelay(50 / portTICK_PERIOD_MS);
     }
@@ -1575,7 +3002,6 @@ static void button_long_press_cb(void *arg, void *usr_data)
     
     
     isShutdown = true;
-    stopAllAnimation();
     vTaskDelay(pdMS_TO_TICKS(100));
     
     xTaskCreate(byebye_sound, "byebyeSound", 4 * 1024, NULL, 5, NULL);
@@ -1672,16 +3098,26 @@ void app_main()
 
     init_esp_now();
 
+    if (ENCODE_BENCH_SECONDS > 0)
+    {
+        encode_bench(ENCODE_BENCH_SECONDS);
+    }
+
     ESP_ERROR_CHECK(esp_board_init(SAMPLE_RATE, 1, BIT_DEPTH));
 
     models = esp_srmodel_init("model");
-    afe_config_t *afe_config = afe_config_init(esp_get_input_format(), models, AFE_TYPE_SR, AFE_MODE_LOW_COST);
+    const char *input_format = esp_get_input_format();
+    afe_config_t *afe_config = afe_config_init(input_format, models, AFE_TYPE_SR, AFE_MODE_LOW_COST);
     
     afe_config->vad_min_noise_ms = 800;
     afe_config->vad_min_speech_ms = 128;
     afe_config->vad_mode = VAD_MODE_1;  // The larger the mode, the higher the speech trigger probability.
     afe_config->afe_linear_gain = 2.0;
 
+    const char *ref = strchr(input_format, 'R');
+    aec_ref_channel = ref ? (int)(ref - input_format) : -1;
+    aec_active = afe_config->aec_init && aec_ref_channel >= 0;
+
     afe_handle = esp_afe_handle_from_config(afe_config);
     esp_afe_sr_data_t *afe_data = afe_handle->create_from_config(afe_config);
     afe_config_free(afe_config);
@@ -1765,6 +3201,6 @@ void app_main()
     xTaskCreatePinnedToCore(&detect_Task, "detect", 4 * 1024, (void *)afe_data, 5, NULL, 1);
     xTaskCreatePinnedToCore(decode_Task, "decode", 4 * 1024, NULL, 5, NULL, 0);
     xTaskCreatePinnedToCore(i2s_writer_task, "i2sWriter", 4 * 1024, NULL, 5, NULL, 0);
-    xTaskCreate(ping_task, "ping", 3 * 1024, NULL, 5, NULL);
+    xTaskCreate(ping_task, "ping", 4 * 1024, NULL, 5, NULL); // ESP_LOGI with %f needs ~1.5 KB on its own
     xTaskCreate(led_control_task, "led_control", 3 * 1024, NULL, 5, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+// agc.h against the float AGC it replaced: cost per sample, gain tracking and
+// the gain step at chunk boundaries
+#include <math.h>
+#include "test_util.h"
+#include "agc.h"
+
+#define CHUNK 1024
+#define SECONDS 60
+#define SAMPLES (16000 * SECONDS / CHUNK * CHUNK)
+
+// The float per-chunk AGC as it was before agc.h
+static void ref_apply_agc(int16_t *buffer, size_t samples, agc_t *agc)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < samples; i++)
+    {
+        float sample = (float)buffer[i];
+        sum += sample * sample;
+    }
+    float current_rms = sqrtf(sum / samples);
+    if (current_rms < 1.0f)
+        current_rms = 1.0f;
+    float desired_gain = agc->target_rms / current_rms;
+    float rate = (desired_gain < agc->current_gain) ? agc->attack_rate : agc->release_rate;
+    agc->current_gain += rate * (desired_gain - agc->current_gain);
+    if (agc->current_gain < MIN_GAIN)
+        agc->current_gain = MIN_GAIN;
+    if (agc->current_gain > MAX_GAIN)
+        agc->current_gain = MAX_GAIN;
+    for (size_t i = 0; i < samples; i++)
+    {
+        float sample = (float)buffer[i] * agc->current_gain;
+        if (sample > 32767.0f)
+            sample = 32767.0f;
+        if (sample < -32768.0f)
+            sample = -32768.0f;
+        buffer[i] = (int16_t)sample;
+    }
+}
+
+// Speech stand-in with talker level changes every 5 s (quiet, normal, loud)
+static void make_signal(int16_t *x)
+{
+    const double levels[] = {0.08, 0.5, 1.0, 0.2};
+    double phase = 0.0;
+    for (int n = 0; n < SAMPLES; n++)
+    {
+        double t = n / 16000.0;
+        double f0 = 130.0 + 25.0 * sin(2 * M_PI * 0.5 * t);
+        phase += 2 * M_PI * f0 / 16000.0;
+        double v = 0.0;
+        for (int h = 1; h <= 8; h++)
+        {
+            v += sin(h * phase) / h;
+        }
+        double env = 0.5 + 0.5 * sin(2 * M_PI * 4.0 * t);
+        double level = levels[(n / (5 * 16000)) % 4];
+        x[n] = (int16_t)(9000.0 * level * env * v + (int)(test_rand() % 64) - 32);
+    }
+}
+
+static agc_t agc_new(void)
+{
+    agc_t agc = {.current_gain = 1.0f, .target_rms = TARGET_RMS,
+                 .attack_rate = AGC_ATTACK, .release_rate = AGC_RELEASE};
+    return agc;
+}
+
+static void test_energy(void)
+{
+    // Full scale must not wrap the accumulator
+    static int16_t buf[CHUNK];
+    for (int i = 0; i < CHUNK; i++)
+    {
+        buf[i] = (i & 1) ? -32768 : 32767;
+    }
+    uint64_t expect = 0;
+    for (int i = 0; i < CHUNK; i++)
+    {
+        expect += (uint64_t)((int64_t)buf[i] * buf[i]);
+    }
+    CHECK_EQ(agc_energy(buf, CHUNK), expect);
+    CHECK_EQ(agc_isqrt(0xFFFFFFFFu), 65535);
+    CHECK_EQ(agc_isqrt(1073741824u), 32768);
+}
+
+int main(void)
+{
+    static int16_t in[SAMPLES], out_ref[SAMPLES], out_fix[SAMPLES];
+    make_signal(in);
+    RUN(test_energy);
+
+    double best_ref = 1e30, best_fix = 1e30;
+    float gain_ref = 0, gain_fix = 0;
+    double jump_ref = 0, jump_fix = 0;
+    for (int run = 0; run < 7; run++)
+    {
+        memcpy(out_ref, in, sizeof(in));
+        memcpy(out_fix, in, sizeof(in));
+        agc_t ref = agc_new(), fix = agc_new();
+
+        double t0 = now_ns();
+        for (int n = 0; n < SAMPLES; n += CHUNK)
+        {
+            ref_apply_agc(&out_ref[n], CHUNK, &ref);
+        }
+        double t1 = now_ns();
+        for (int n = 0; n < SAMPLES; n += CHUNK)
+        {
+            agc_apply(&fix, &out_fix[n], CHUNK);
+        }
+        double t2 = now_ns();
+        if (t1 - t0 < best_ref)
+            best_ref = t1 - t0;
+        if (t2 - t1 < best_fix)
+            best_fix = t2 - t1;
+        gain_ref = ref.current_gain;
+        gain_fix = fix.current_gain;
+    }
+
+    // Applied gain just before and after each boundary, from the output/input ratio
+    // over a few samples either side (skipping near-silent stretches)
+    int boundaries = 0;
+    for (int n = CHUNK; n < SAMPLES; n += CHUNK)
+    {
+        double in_a = 0, in_b = 0, ra = 0, rb = 0, fa = 0, fb = 0;
+        for (int k = 1; k <= 16; k++)
+        {
+            in_a += fabs(in[n - k]);
+            in_b += fabs(in[n + k - 1]);
+            ra += fabs(out_ref[n - k]);
+            rb += fabs(out_ref[n + k - 1]);
+            fa += fabs(out_fix[n - k]);
+            fb += fabs(out_fix[n + k - 1]);
+        }
+        if (in_a < 16 * 200 || in_b < 16 * 200)
+        {
+            continue;
+        }
+        jump_ref += fabs(rb / in_b - ra / in_a);
+        jump_fix += fabs(fb / in_b - fa / in_a);
+        boundaries++;
+    }
+
+    double sig = 0, err = 0;
+    for (int n = 0; n < SAMPLES; n++)
+    {
+        double d = (double)out_fix[n] - out_ref[n];
+        sig += (double)out_ref[n] * out_ref[n];
+        err += d * d;
+    }
+
+    printf("float AGC: %.2f ns/sample, final gain %.3f, mean boundary gain jump %.3f\n",
+           best_ref / SAMPLES, gain_ref, jump_ref / boundaries);
+    printf("fixed AGC: %.2f ns/sample, final gain %.3f, mean boundary gain jump %.3f\n",
+           best_fix / SAMPLES, gain_fix, jump_fix / boundaries);
+    printf("fixed vs float output SNR %.1f dB (best of 7, %d s, %d-sample chunks)\n",
+           10.0 * log10(sig / (err + 1e-9)), SECONDS, CHUNK);
+    CHECK(fabsf(gain_ref - gain_fix) < 0.05f * gain_ref);
+    return test_result();
+}
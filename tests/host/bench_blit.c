@@ -0,0 +1,56 @@
+// drawImage over the images/home.h assets: row blitter against the
+// per-pixel loop it replaced, at both destination alignments
+#include "test_util.h"
+#include "ssd1327_host.h"
+
+#define PIXELS_PER_RUN 5000000
+
+int main(void)
+{
+    static struct spi_ssd1327 dev;
+    static uint8_t ref_fb[SSD1327_BUFFER_SIZE];
+    host_display_init(&dev);
+
+    printf("%-16s %-4s %3s %6s %10s %10s %7s\n", "asset", "x", "op", "pixels", "blit ns", "pixel ns", "speedup");
+    double total_blit = 0, total_ref = 0;
+    for (size_t i = 0; i < HOST_ASSET_COUNT; i++)
+    {
+        const host_asset_t *a = &host_assets[i];
+        int reps = PIXELS_PER_RUN / (a->width * a->height);
+        for (int odd = 0; odd <= 1; odd++)
+        {
+            for (int opacity = 15; opacity >= 8; opacity -= 7)
+            {
+                int x = (a->width < SSD1327_WIDTH ? 10 : 0) + odd;
+                double best_blit = 1e30, best_ref = 1e30;
+                for (int run = 0; run < 3; run++)
+                {
+                    double t0 = now_ns();
+                    for (int r = 0; r < reps; r++)
+                    {
+                        spi_oled_drawImage(&dev, x, 0, a->width, a->height, host_asset_frame(a, r), opacity);
+                    }
+                    double t1 = now_ns();
+                    for (int r = 0; r < reps; r++)
+                    {
+                        ref_draw_image(ref_fb, x, 0, a->width, a->height, host_asset_frame(a, r), opacity, -1);
+                    }
+                    double t2 = now_ns();
+                    if (t1 - t0 < best_blit)
+                        best_blit = t1 - t0;
+                    if (t2 - t1 < best_ref)
+                        best_ref = t2 - t1;
+                }
+                best_blit /= reps;
+                best_ref /= reps;
+                total_blit += best_blit;
+                total_ref += best_ref;
+                printf("%-16s %-4s %3d %6d %10.0f %10.0f %6.1fx\n", a->name, odd ? "odd" : "even", opacity,
+                       a->width * a->height, best_blit, best_ref, best_ref / best_blit);
+            }
+        }
+    }
+    printf("all assets: %.1fx (best of 3)\n", total_ref / total_blit);
+    spi_oled_framebuffer_free(&dev);
+    return ref_fb[0] == 0x5A; // Keeps the reference from being optimised out
+}
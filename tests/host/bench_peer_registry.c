@@ -0,0 +1,82 @@
+// peer_find with PEER_MAX peers against the linear scan it replaced
+#include "test_util.h"
+#include "peer_registry.h"
+
+#define LOOKUPS 4000000
+
+int main(void)
+{
+    static peer_registry_t reg;
+    static uint8_t macs[PEER_MAX][PEER_MAC_LEN];
+    static peer_t list[PEER_MAX]; // The old array, scanned front to back
+    peer_reg_init(&reg);
+    for (int i = 0; i < PEER_MAX; i++)
+    {
+        uint32_t r = test_rand();
+        uint8_t mac[PEER_MAC_LEN] = {0x48, 0x27, 0xE2, (uint8_t)(r >> 16), (uint8_t)(r >> 8), (uint8_t)r};
+        memcpy(macs[i], mac, PEER_MAC_LEN);
+        bool added;
+        peer_touch(&reg, mac, 0, &added);
+        list[i].used = true;
+        memcpy(list[i].mac, mac, PEER_MAC_LEN);
+    }
+
+    // Probe statistics
+    int total = 0, max = 0;
+    for (int i = 0; i < PEER_MAX; i++)
+    {
+        uint32_t j = peer_hash(macs[i]) & (PEER_SLOTS - 1);
+        int probes = 1;
+        while (memcmp(reg.slots[j].mac, macs[i], PEER_MAC_LEN) != 0)
+        {
+            j = (j + 1) & (PEER_SLOTS - 1);
+            probes++;
+        }
+        total += probes;
+        if (probes > max)
+        {
+            max = probes;
+        }
+    }
+
+    static uint16_t order[LOOKUPS];
+    for (int i = 0; i < LOOKUPS; i++)
+    {
+        order[i] = (uint16_t)(test_rand() % PEER_MAX);
+    }
+
+    double best_hash = 1e30, best_scan = 1e30;
+    volatile uintptr_t sink = 0;
+    for (int run = 0; run < 7; run++)
+    {
+        uintptr_t acc = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < LOOKUPS; i++)
+        {
+            acc += (uintptr_t)peer_find(&reg, macs[order[i]]);
+        }
+        double t1 = now_ns();
+        for (int i = 0; i < LOOKUPS; i++)
+        {
+            const uint8_t *mac = macs[order[i]];
+            for (int k = 0; k < PEER_MAX; k++)
+            {
+                if (list[k].used && memcmp(list[k].mac, mac, PEER_MAC_LEN) == 0)
+                {
+                    acc += (uintptr_t)&list[k];
+                    break;
+                }
+            }
+        }
+        double t2 = now_ns();
+        sink += acc;
+        if (t1 - t0 < best_hash)
+            best_hash = t1 - t0;
+        if (t2 - t1 < best_scan)
+            best_scan = t2 - t1;
+    }
+
+    printf("%d peers: hash %.1f ns/lookup (%.2f probes avg, max %d), linear scan %.1f ns/lookup (best of 7)\n",
+           PEER_MAX, best_hash / LOOKUPS, (double)total / PEER_MAX, max, best_scan / LOOKUPS);
+    return 0;
+}
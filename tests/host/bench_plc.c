@@ -0,0 +1,104 @@
+// plc.h: cost per concealed frame, and output SNR against zero fill at several loss rates
+#include <math.h>
+#include "test_util.h"
+#include "plc.h"
+
+#define FRAME 505            // ADPCM_FRAME_SIZE
+#define FRAMES 2000          // About 63 s of audio
+#define SAMPLES (FRAME * FRAMES)
+
+// Voiced-speech stand-in: a 140 Hz harmonic series with a slow pitch glide and
+// a syllable-rate amplitude envelope
+static void make_signal(int16_t *x)
+{
+    double phase = 0.0;
+    for (int n = 0; n < SAMPLES; n++)
+    {
+        double t = n / 16000.0;
+        double f0 = 140.0 + 20.0 * sin(2 * M_PI * 0.7 * t);
+        phase += 2 * M_PI * f0 / 16000.0;
+        double v = 0.0;
+        for (int h = 1; h <= 6; h++)
+        {
+            v += sin(h * phase) / h;
+        }
+        double env = 0.55 + 0.45 * sin(2 * M_PI * 3.0 * t);
+        x[n] = (int16_t)(6000.0 * env * v);
+    }
+}
+
+static double snr_db(const int16_t *ref, const int16_t *out)
+{
+    double sig = 0.0, err = 0.0;
+    for (int n = 0; n < SAMPLES; n++)
+    {
+        double d = (double)out[n] - ref[n];
+        sig += (double)ref[n] * ref[n];
+        err += d * d;
+    }
+    return 10.0 * log10(sig / (err + 1e-9));
+}
+
+int main(void)
+{
+    static int16_t ref[SAMPLES], out[SAMPLES], zero[SAMPLES];
+    static bool lost[FRAMES];
+    make_signal(ref);
+
+    const int rates[] = {0, 2, 5, 10, 20};
+    printf("loss  concealed  snr_plc  snr_zero  first_ns  cont_ns  good_ns\n");
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+    {
+        // Gilbert-style bursts: a loss is followed by another with 30% chance
+        test_rand_state = 12345;
+        for (int f = 0; f < FRAMES; f++)
+        {
+            uint32_t p = test_rand() % 1000;
+            lost[f] = f > 0 && lost[f - 1] ? p < 300 : p < (uint32_t)rates[r] * 10;
+        }
+
+        double best_first = 1e30, best_cont = 1e30, best_good = 1e30;
+        plc_t plc;
+        for (int run = 0; run < 5; run++)
+        {
+            plc_init(&plc);
+            double t_first = 0, t_cont = 0, t_good = 0;
+            int n_first = 0, n_cont = 0, n_good = 0;
+            for (int f = 0; f < FRAMES; f++)
+            {
+                int16_t *o = &out[f * FRAME];
+                double t0 = now_ns();
+                if (lost[f])
+                {
+                    bool first = plc.lost_samples == 0;
+                    plc_conceal(&plc, o, FRAME);
+                    double dt = now_ns() - t0;
+                    if (first)
+                        t_first += dt, n_first++;
+                    else
+                        t_cont += dt, n_cont++;
+                    memset(&zero[f * FRAME], 0, FRAME * sizeof(int16_t));
+                }
+                else
+                {
+                    memcpy(o, &ref[f * FRAME], FRAME * sizeof(int16_t));
+                    plc_good_frame(&plc, o, FRAME);
+                    t_good += now_ns() - t0;
+                    n_good++;
+                    memcpy(&zero[f * FRAME], &ref[f * FRAME], FRAME * sizeof(int16_t));
+                }
+            }
+            if (n_first && t_first / n_first < best_first)
+                best_first = t_first / n_first;
+            if (n_cont && t_cont / n_cont < best_cont)
+                best_cont = t_cont / n_cont;
+            if (n_good && t_good / n_good < best_good)
+                best_good = t_good / n_good;
+        }
+
+        printf("%3d%%  %9u  %7.1f  %8.1f  %8.0f  %7.0f  %7.0f\n", rates[r], (unsigned)plc.concealed_frames,
+               snr_db(ref, out), snr_db(ref, zero),
+               best_first < 1e30 ? best_first : 0.0, best_cont < 1e30 ? best_cont : 0.0, best_good);
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// drawText throughput in glyphs/ms for what the display task draws: the
+// font_10 bubble (ASCII and CJK command phrases), the font_30 count and the
+// title, with the glyph span cache warm as in use and cleared before every
+// draw (each glyph expanded from the font bitmap)
+#include "test_util.h"
+#include "ssd1327_host.h"
+#include "fonts/fusion_pixel.h"
+#include "fonts/fusion_pixel_30.h"
+#include "fonts/fusion_pixel_cjk.h"
+
+#define DRAWS 50000
+#define HOLD 30 // Frames a bubble or count stays on screen
+
+static const packed_font_t font_cjk_10 = {
+    .count = sizeof(font_cjk_10_glyphs) / sizeof(font_cjk_10_glyphs[0]),
+    .glyphs = font_cjk_10_glyphs,
+    .data = font_cjk_10_data};
+
+static const variable_font_t font_10 = {
+    .height = 10,
+    .widths = font_10_widths,
+    .offsets = font_10_offsets,
+    .data = font_10_data,
+    .extra = &font_cjk_10};
+
+static const variable_font_t font_30 = {
+    .height = 30,
+    .widths = font_30_widths,
+    .offsets = font_30_offsets,
+    .data = font_30_data};
+
+typedef struct
+{
+    const char *name;
+    const variable_font_t *font;
+    int16_t x, y;
+    uint8_t max_width;
+    const char *text[24];
+} text_case_t;
+
+static struct spi_ssd1327 dev;
+
+static size_t glyph_count(const char *s)
+{
+    size_t n = 0;
+    for (; *s; s++)
+    {
+        n += (*s & 0xC0) != 0x80; // UTF-8 lead and ASCII bytes
+    }
+    return n;
+}
+
+static size_t text_count(const text_case_t *c)
+{
+    size_t n = 0;
+    while (n < sizeof(c->text) / sizeof(c->text[0]) && c->text[n])
+    {
+        n++;
+    }
+    return n;
+}
+
+// Best of 5 in glyphs/ms; hit_rate is the glyph cache hit ratio of the last run
+static double run(const text_case_t *c, bool cold, double *hit_rate)
+{
+    size_t n = text_count(c);
+    double best = 0;
+    for (int rep = 0; rep < 5; rep++)
+    {
+        ssd1327_stats_t before, after;
+        memset(dev.glyphs, 0, sizeof(dev.glyphs));
+        spi_oled_get_stats(&dev, &before);
+        size_t glyphs = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < DRAWS; i++)
+        {
+            const char *s = c->text[(i / HOLD) % n];
+            if (cold)
+            {
+                memset(dev.glyphs, 0, sizeof(dev.glyphs));
+            }
+            spi_oled_drawText(&dev, c->x, c->y, c->font, (ssd1327_gs_t)(i & 15), s, c->max_width);
+            glyphs += glyph_count(s);
+        }
+        double rate = glyphs / ((now_ns() - t0) / 1e6);
+        spi_oled_get_stats(&dev, &after);
+        uint32_t hits = after.glyph_hits - before.glyph_hits;
+        uint32_t misses = after.glyph_misses - before.glyph_misses;
+        *hit_rate = hits + misses ? (double)hits / (hits + misses) : 0;
+        if (rate > best)
+        {
+            best = rate;
+        }
+    }
+    return best;
+}
+
+// A cached glyph must draw exactly what expanding it again draws
+static bool cache_consistent(const text_case_t *c)
+{
+    static uint8_t cold_fb[SSD1327_BUFFER_SIZE];
+    for (size_t i = 0; i < text_count(c); i++)
+    {
+        memset(dev.glyphs, 0, sizeof(dev.glyphs));
+        spi_oled_framebuffer_clear(&dev, SSD1327_GS_0);
+        spi_oled_drawText(&dev, c->x, c->y, c->font, SSD1327_GS_15, c->text[i], c->max_width);
+        memcpy(cold_fb, dev.framebuffer, SSD1327_BUFFER_SIZE);
+        spi_oled_framebuffer_clear(&dev, SSD1327_GS_0);
+        spi_oled_drawText(&dev, c->x, c->y, c->font, SSD1327_GS_15, c->text[i], c->max_width);
+        if (memcmp(cold_fb, dev.framebuffer, SSD1327_BUFFER_SIZE) != 0)
+        {
+            printf("  '%s' differs once cached\n", c->text[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    static const text_case_t cases[] = {
+        {"bubble, ASCII", &font_10, 18, 40, 86,
+         {"Hello", "On my way", "Wait for me", "Stop here", "Turn left ahead", "Battery low", "Copy that"}},
+        {"bubble, CJK", &font_10, 18, 40, 86,
+         {"前面左转", "前面右转", "保持直行", "停车休息", "等等我", "有人在吗", "收到请回答", "请求支援",
+          "注意安全", "减速慢行"}},
+        {"count, font_30", &font_30, 85, 45, 0,
+         {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12"}},
+        {"title", &font_10, 44, 0, 0, {"bbTalkie"}},
+    };
+
+    host_display_init(&dev);
+    int failed = 0;
+    printf("%-16s %14s %9s %14s %8s\n", "text", "cached g/ms", "hit rate", "uncached g/ms", "speedup");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        const text_case_t *c = &cases[i];
+        if (!cache_consistent(c))
+        {
+            failed = 1;
+        }
+        double hit_warm, hit_cold;
+        double warm = run(c, false, &hit_warm);
+        double cold = run(c, true, &hit_cold);
+        printf("%-16s %14.1f %8.1f%% %14.1f %7.1fx\n", c->name, warm, 100 * hit_warm, cold, warm / cold);
+    }
+    spi_oled_framebuffer_free(&dev);
+    return failed;
+}
@@ -0,0 +1,98 @@
+// SSD1327 driver on the host: a display with no bus behind it, the
+// images/home.h assets and a per-pixel reference for the blitter
+#pragma once
+#include <stdlib.h>
+#include "esp32-spi-ssd1327.h"
+#include "images/home.h"
+
+typedef struct
+{
+    const char *name;
+    const uint8_t *data;
+    int frames, width, height;
+} host_asset_t;
+
+static const host_asset_t host_assets[] = {
+    {"idle_single", &idle_single[0][0][0], 14, 54, 41},
+    {"speaking_single", &speaking_single[0][0][0], 7, 54, 41},
+    {"receiving_single", &receiving_single[0][0][0], 6, 54, 41},
+    {"idle_bar", &idle_bar[0][0][0], 14, 101, 12},
+    {"wave_bar", &wave_bar[0][0][0], 29, 126, 40},
+    {"idle_wave_bar", &idle_wave_bar[0][0][0], 36, 126, 40},
+    {"podcast", &podcast[0][0][0], 24, 36, 36},
+    {"speaker", &speaker[0][0][0], 46, 36, 36},
+    {"text_bubble", &text_bubble[0][0], 1, 93, 11},
+    {"byebye_image", &byebye_image[0][0][0], 7, 128, 128},
+};
+#define HOST_ASSET_COUNT (sizeof(host_assets) / sizeof(host_assets[0]))
+
+static inline const uint8_t *host_asset_frame(const host_asset_t *a, int frame)
+{
+    return a->data + (size_t)(frame % a->frames) * a->height * ((a->width + 1) / 2);
+}
+
+static inline void host_display_init(struct spi_ssd1327 *dev)
+{
+    static spi_device_handle_t handle;
+    memset(dev, 0, sizeof(*dev));
+    dev->spi_handle = &handle;
+    spi_oled_framebuffer_init(dev);
+}
+
+// Full spi_oled_init on the fake bus, transfer engine included. Queued
+// transactions finish as soon as the driver polls for them.
+#define HOST_DC_PIN 9
+static inline void host_display_start(struct spi_ssd1327 *dev)
+{
+    static spi_device_handle_t handle;
+    memset(dev, 0, sizeof(*dev));
+    dev->spi_handle = &handle;
+    dev->dc_pin_num = HOST_DC_PIN;
+    host_spi_reset();
+    host_spi.pre_cb = spi_oled_pre_transfer_cb;
+    host_spi.post_cb = spi_oled_post_transfer_cb;
+    host_spi.instant = UINT32_MAX;
+    host_spi.queue_size = SSD1327_QUEUE_DEPTH; // As the device must be added
+    spi_oled_init(dev);
+}
+
+static inline void host_display_stop(struct spi_ssd1327 *dev)
+{
+    spi_oled_wait_idle(dev);
+    spi_oled_framebuffer_free(dev);
+    heap_caps_free(dev->staging);
+    dev->staging = NULL;
+}
+
+// The drawImage loop before the row blitter: one pixel at a time, source
+// value checked against key (-1 for none), then scaled by opacity
+static inline void ref_draw_image(uint8_t *fb, int x, int y, int width, int height,
+                           const uint8_t *image, int opacity, int key)
+{
+    int pitch = (width + 1) / 2;
+    for (int row = 0; row < height; row++)
+    {
+        int sy = y + row;
+        if (sy < 0 || sy >= SSD1327_HEIGHT)
+        {
+            continue;
+        }
+        for (int col = 0; col < width; col++)
+        {
+            int sx = x + col;
+            if (sx < 0 || sx >= SSD1327_WIDTH)
+            {
+                continue;
+            }
+            uint8_t b = image[row * pitch + col / 2];
+            int v = (col & 1) ? b & 0x0F : b >> 4;
+            if (v == key)
+            {
+                continue;
+            }
+            v = v * opacity / 15;
+            uint8_t *d = &fb[sy * (SSD1327_WIDTH / 2) + sx / 2];
+            *d = (sx & 1) ? (uint8_t)((*d & 0xF0) | v) : (uint8_t)((*d & 0x0F) | (v << 4));
+        }
+    }
+}
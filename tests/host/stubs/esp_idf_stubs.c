@@ -0,0 +1,154 @@
+// No-op bus and RTOS calls behind esp_idf_stubs.h
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_idf_stubs.h"
+
+gpio_dev_t GPIO;
+host_spi_t host_spi;
+
+static spi_transaction_t *pending[HOST_SPI_MAX_QUEUED];
+static uint8_t *pending_copy[HOST_SPI_MAX_QUEUED];
+static uint32_t pending_head, pending_count;
+
+void host_esp_error_check_failed(esp_err_t err, const char *expr, const char *file, int line)
+{
+    fprintf(stderr, "%s:%d: ESP_ERROR_CHECK failed: %s = 0x%x\n", file, line, expr, err);
+    abort();
+}
+
+void host_spi_reset(void)
+{
+    for (uint32_t i = 0; i < pending_count; i++)
+    {
+        free(pending_copy[(pending_head + i) % HOST_SPI_MAX_QUEUED]);
+    }
+    memset(&host_spi, 0, sizeof(host_spi));
+    pending_head = pending_count = 0;
+}
+
+uint32_t host_spi_pending(void)
+{
+    return pending_count;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    host_spi.transmitted++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t wait)
+{
+    uint32_t depth = host_spi.queue_size ? host_spi.queue_size : HOST_SPI_MAX_QUEUED;
+    if (pending_count >= depth || pending_count == HOST_SPI_MAX_QUEUED)
+    {
+        host_spi.overflows++;
+        return ESP_ERR_TIMEOUT;
+    }
+    size_t len = trans->length / 8;
+    uint8_t *copy = malloc(len ? len : 1);
+    memcpy(copy, trans->tx_buffer, len);
+    uint32_t slot = (pending_head + pending_count++) % HOST_SPI_MAX_QUEUED;
+    pending[slot] = trans;
+    pending_copy[slot] = copy;
+    host_spi.queued++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t wait)
+{
+    *trans = NULL;
+    if (pending_count == 0)
+    {
+        if (wait != 0)
+        {
+            host_spi.stuck++;
+        }
+        return ESP_ERR_TIMEOUT;
+    }
+    if (wait == 0)
+    {
+        if (host_spi.instant == 0)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (host_spi.instant != UINT32_MAX)
+        {
+            host_spi.instant--;
+        }
+    }
+    spi_transaction_t *t = pending[pending_head];
+    uint8_t *copy = pending_copy[pending_head];
+    pending_head = (pending_head + 1) % HOST_SPI_MAX_QUEUED;
+    pending_count--;
+    if (memcmp(copy, t->tx_buffer, t->length / 8) != 0)
+    {
+        host_spi.overwritten++;
+    }
+    free(copy);
+    if (host_spi.pre_cb)
+    {
+        host_spi.pre_cb(t);
+    }
+    if (host_spi.on_transfer)
+    {
+        host_spi.on_transfer(t, t->tx_buffer, t->length / 8);
+    }
+    if (host_spi.post_cb)
+    {
+        host_spi.post_cb(t);
+    }
+    host_spi.completed++;
+    *trans = t;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait)
+{
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle)
+{
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    return ESP_OK;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static int mutex;
+    return &mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return pdTRUE;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return 0;
+}
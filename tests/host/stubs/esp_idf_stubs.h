@@ -0,0 +1,120 @@
+// Just enough of the ESP-IDF and FreeRTOS API to build the SSD1327 driver
+// on the host. Blocking transfers are only counted; queued transactions go
+// to a fake bus (host_spi) that finishes them in order and shows each one
+// to the test as it goes out.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define IRAM_ATTR
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_ERR_TIMEOUT 0x107
+void host_esp_error_check_failed(esp_err_t err, const char *expr, const char *file, int line);
+#define ESP_ERROR_CHECK(x)                                             \
+    do                                                                 \
+    {                                                                  \
+        esp_err_t err_rc_ = (x);                                       \
+        if (err_rc_ != ESP_OK)                                         \
+            host_esp_error_check_failed(err_rc_, #x, __FILE__, __LINE__); \
+    } while (0)
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void *SemaphoreHandle_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+
+typedef struct
+{
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portMUX_INITIALIZE(m) (void)(m)
+#define taskENTER_CRITICAL(m) (void)(m)
+#define taskEXIT_CRITICAL(m) (void)(m)
+
+void vTaskDelay(TickType_t ticks);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+
+int64_t esp_timer_get_time(void);
+
+typedef int gpio_num_t;
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+
+// Output levels set through the low-level API (the transfer callbacks)
+typedef struct
+{
+    uint8_t level[64];
+} gpio_dev_t;
+extern gpio_dev_t GPIO;
+static inline void gpio_ll_set_level(gpio_dev_t *hw, uint32_t gpio_num, uint32_t level)
+{
+    hw->level[gpio_num & 63] = (uint8_t)(level != 0);
+}
+
+typedef void *spi_device_handle_t;
+typedef struct spi_transaction_t
+{
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;
+    size_t rxlength;
+    void *user;
+    union
+    {
+        const void *tx_buffer;
+        uint8_t tx_data[4];
+    };
+    union
+    {
+        void *rx_buffer;
+        uint8_t rx_data[4];
+    };
+} spi_transaction_t;
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t wait);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait);
+void spi_device_release_bus(spi_device_handle_t handle);
+
+// Fake bus behind spi_device_queue_trans. Transactions finish in the order
+// queued: pre_cb, on_transfer with the bytes as they are now, post_cb.
+// Polling without a wait finishes one only while instant is non-zero (each
+// use counts it down, UINT32_MAX never runs out); waiting always does.
+// Each transaction's bytes are copied when it is queued; if they differ when
+// it goes out, the driver reused a buffer the DMA had not read yet.
+#define HOST_SPI_MAX_QUEUED 64
+
+typedef struct
+{
+    void (*pre_cb)(spi_transaction_t *trans);
+    void (*post_cb)(spi_transaction_t *trans);
+    void (*on_transfer)(spi_transaction_t *trans, const uint8_t *bytes, size_t len);
+    uint32_t instant;
+    uint32_t queue_size;  // Device queue depth, 0 for HOST_SPI_MAX_QUEUED
+    uint32_t transmitted; // Blocking spi_device_transmit calls
+    uint32_t queued;
+    uint32_t completed;
+    uint32_t stuck;       // Waits on an empty queue, which never return on the target
+    uint32_t overflows;   // Queued past queue_size, which blocks forever here
+    uint32_t overwritten; // Went out with bytes other than those queued
+} host_spi_t;
+
+extern host_spi_t host_spi;
+void host_spi_reset(void);
+uint32_t host_spi_pending(void);
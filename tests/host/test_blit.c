@@ -0,0 +1,126 @@
+// esp32-spi-ssd1327.c: row blitter against the per-pixel drawImage loop
+#include "test_util.h"
+#include "ssd1327_host.h"
+
+static struct spi_ssd1327 dev;
+static uint8_t expect[SSD1327_BUFFER_SIZE];
+
+static void fill_random(void)
+{
+    for (size_t i = 0; i < SSD1327_BUFFER_SIZE; i++)
+    {
+        expect[i] = dev.framebuffer[i] = (uint8_t)test_rand();
+    }
+}
+
+static bool blit_matches(int x, int y, int width, int height, const uint8_t *image, int opacity, int key)
+{
+    fill_random();
+    if (key < 0)
+    {
+        spi_oled_drawImage(&dev, x, y, width, height, image, opacity);
+    }
+    else
+    {
+        spi_oled_drawImage_keyed(&dev, x, y, width, height, image, opacity, key);
+    }
+    ref_draw_image(expect, x, y, width, height, image, opacity, key);
+    if (memcmp(expect, dev.framebuffer, SSD1327_BUFFER_SIZE) != 0)
+    {
+        printf("  %dx%d at (%d, %d) opacity %d key %d differs\n", width, height, x, y, opacity, key);
+        return false;
+    }
+    return true;
+}
+
+static void test_every_opacity_and_key(void)
+{
+    // Both nibble alignments of the destination, unkeyed and every key
+    const host_asset_t *a = &host_assets[0];
+    for (int opacity = 0; opacity <= 15; opacity++)
+    {
+        for (int key = -1; key <= 15; key++)
+        {
+            for (int x = 10; x <= 11; x++)
+            {
+                CHECK(blit_matches(x, 20, a->width, a->height, host_asset_frame(a, key + 1), opacity, key));
+            }
+        }
+    }
+}
+
+static void test_odd_widths(void)
+{
+    // text_bubble is 93 wide: the last source byte carries one pixel
+    const host_asset_t *a = &host_assets[8];
+    for (int x = -3; x <= 3; x++)
+    {
+        CHECK(blit_matches(x, 0, a->width, a->height, a->data, 15, -1));
+        CHECK(blit_matches(x, 0, a->width, a->height, a->data, 9, 0));
+    }
+    // Every width on a synthetic image, including one pixel
+    uint8_t image[64 * 4];
+    for (size_t i = 0; i < sizeof(image); i++)
+    {
+        image[i] = (uint8_t)test_rand();
+    }
+    for (int width = 1; width <= 128; width++)
+    {
+        CHECK(blit_matches(127 - width / 2, 5, width, 4, image, 15, -1));
+        CHECK(blit_matches(width & 7, 5, width, 4, image, 7, 3));
+    }
+}
+
+static void test_clipping(void)
+{
+    // Off every edge, partly and wholly, the full-screen image included
+    for (size_t i = 0; i < HOST_ASSET_COUNT; i++)
+    {
+        const host_asset_t *a = &host_assets[i];
+        const int pos[] = {-200, -a->width, -a->width + 1, -7, -1, 0, 1, 64,
+                           127, 128 - a->width, 129 - a->width, 128, 300};
+        for (size_t px = 0; px < sizeof(pos) / sizeof(pos[0]); px++)
+        {
+            for (size_t py = 0; py < sizeof(pos) / sizeof(pos[0]); py++)
+            {
+                CHECK(blit_matches(pos[px], pos[py], a->width, a->height, a->data, 15, -1));
+                CHECK(blit_matches(pos[px], pos[py], a->width, a->height, a->data, 11, 0));
+            }
+        }
+    }
+}
+
+static void test_random(void)
+{
+    for (int it = 0; it < 20000; it++)
+    {
+        const host_asset_t *a = &host_assets[test_rand() % HOST_ASSET_COUNT];
+        int x = (int)(test_rand() % 200) - 100;
+        int y = (int)(test_rand() % 200) - 100;
+        int opacity = test_rand() % 16;
+        int key = (it & 1) ? (int)(test_rand() % 16) : -1;
+        CHECK(blit_matches(x, y, a->width, a->height, host_asset_frame(a, test_rand()), opacity, key));
+    }
+}
+
+static void test_opacity_clamped(void)
+{
+    // Opacity above 15 draws like 15
+    const host_asset_t *a = &host_assets[6];
+    fill_random();
+    spi_oled_drawImage(&dev, 3, 3, a->width, a->height, a->data, 200);
+    ref_draw_image(expect, 3, 3, a->width, a->height, a->data, 15, -1);
+    CHECK(memcmp(expect, dev.framebuffer, SSD1327_BUFFER_SIZE) == 0);
+}
+
+int main(void)
+{
+    host_display_init(&dev);
+    RUN(test_every_opacity_and_key);
+    RUN(test_odd_widths);
+    RUN(test_clipping);
+    RUN(test_random);
+    RUN(test_opacity_clamped);
+    spi_oled_framebuffer_free(&dev);
+    return test_result();
+}
@@ -0,0 +1,244 @@
+// esp32-spi-ssd1327.c: dirty rectangles, merging and the windows a flush sends
+#include "test_util.h"
+#include "ssd1327_host.h"
+
+static struct spi_ssd1327 dev;
+
+// Panel writes seen on the fake bus: every pixel a data transaction covered,
+// checked against the frame buffer as it goes
+static bool flushed[SSD1327_HEIGHT][SSD1327_WIDTH];
+static uint8_t win_c0, win_c1, win_r0, win_r1;
+static bool have_window;
+static int bad_transfers;
+
+static void on_transfer(spi_transaction_t *t, const uint8_t *bytes, size_t len)
+{
+    if (GPIO.level[HOST_DC_PIN] == 0)
+    {
+        if (len != SSD1327_CMD_BYTES || bytes[0] != 0x15 || bytes[3] != 0x75)
+        {
+            bad_transfers++;
+            return;
+        }
+        win_c0 = bytes[1];
+        win_c1 = bytes[2];
+        win_r0 = bytes[4];
+        win_r1 = bytes[5];
+        have_window = true;
+        return;
+    }
+    size_t width = win_c1 - win_c0 + 1;
+    if (!have_window || len != width * (win_r1 - win_r0 + 1))
+    {
+        bad_transfers++;
+        return;
+    }
+    for (int r = win_r0; r <= win_r1; r++)
+    {
+        if (memcmp(&bytes[(r - win_r0) * width], &dev.framebuffer[r * (SSD1327_WIDTH / 2) + win_c0], width) != 0)
+        {
+            bad_transfers++;
+        }
+        for (int c = win_c0 * 2; c <= win_c1 * 2 + 1; c++)
+        {
+            flushed[r][c] = true;
+        }
+    }
+    have_window = false;
+}
+
+static void start(void)
+{
+    host_display_start(&dev);
+    host_spi.on_transfer = on_transfer;
+    spi_oled_set_compose(&dev, true);
+    memset(flushed, 0, sizeof(flushed));
+    bad_transfers = 0;
+}
+
+static bool covers(const ssd1327_rect_t *r, int x0, int y0, int x1, int y1)
+{
+    return r->x0 <= x0 && r->y0 <= y0 && r->x1 >= x1 && r->y1 >= y1;
+}
+
+static bool any_covers(const ssd1327_rect_t *rects, int n, int x0, int y0, int x1, int y1)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (covers(&rects[i], x0, y0, x1, y1))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_pair_widening(void)
+{
+    start();
+    // Odd x and odd width widen out to whole column pairs
+    spi_oled_mark_dirty(&dev, 3, 5, 4, 2);
+    CHECK_EQ(dev.dirty_count, 1);
+    CHECK_EQ(dev.dirty[0].x0, 2);
+    CHECK_EQ(dev.dirty[0].x1, 7);
+    CHECK_EQ(dev.dirty[0].y0, 5);
+    CHECK_EQ(dev.dirty[0].y1, 6);
+
+    // One pixel, either half of a pair
+    const int xs[] = {40, 41};
+    for (int i = 0; i < 2; i++)
+    {
+        dev.dirty_count = 0;
+        spi_oled_mark_dirty(&dev, xs[i], 100, 1, 1);
+        CHECK_EQ(dev.dirty_count, 1);
+        CHECK_EQ(dev.dirty[0].x0, 40);
+        CHECK_EQ(dev.dirty[0].x1, 41);
+        CHECK_EQ(dev.dirty[0].y0, 100);
+        CHECK_EQ(dev.dirty[0].y1, 100);
+    }
+
+    // Clipped to the screen before widening; nothing on screen, nothing marked
+    dev.dirty_count = 0;
+    spi_oled_mark_dirty(&dev, -3, -2, 6, 4);
+    CHECK_EQ(dev.dirty_count, 1);
+    CHECK(covers(&dev.dirty[0], 0, 0, 3, 1));
+    CHECK_EQ(dev.dirty[0].x1, 3);
+    CHECK_EQ(dev.dirty[0].y0, 0);
+    dev.dirty_count = 0;
+    spi_oled_mark_dirty(&dev, 127, 126, 10, 10);
+    CHECK_EQ(dev.dirty_count, 1);
+    CHECK_EQ(dev.dirty[0].x0, 126);
+    CHECK_EQ(dev.dirty[0].x1, 127);
+    CHECK_EQ(dev.dirty[0].y1, 127);
+    dev.dirty_count = 0;
+    spi_oled_mark_dirty(&dev, 128, 0, 5, 5);
+    spi_oled_mark_dirty(&dev, -5, 0, 5, 5);
+    spi_oled_mark_dirty(&dev, 10, 10, 0, 5);
+    CHECK_EQ(dev.dirty_count, 0);
+    host_display_stop(&dev);
+}
+
+static void test_covered_fast_path(void)
+{
+    start();
+    spi_oled_mark_dirty(&dev, 10, 20, 54, 41);
+    ssd1327_rect_t first = dev.dirty[0];
+    // The same animation area again, and anything inside it, adds nothing
+    for (int i = 0; i < 50; i++)
+    {
+        spi_oled_mark_dirty(&dev, 10 + i % 7, 20 + i % 5, 54 - i % 7 - 1, 41 - i % 5);
+    }
+    CHECK_EQ(dev.dirty_count, 1);
+    CHECK(memcmp(&dev.dirty[0], &first, sizeof(first)) == 0);
+    ssd1327_stats_t stats;
+    spi_oled_get_stats(&dev, &stats);
+    CHECK_EQ(stats.marks, 51);
+
+    // Past the edge by one column pair is no longer covered
+    spi_oled_mark_dirty(&dev, 64, 20, 1, 1);
+    CHECK_EQ(dev.dirty_count, 2);
+    host_display_stop(&dev);
+}
+
+static void test_full_list(void)
+{
+    start();
+    // Narrow strips far enough apart that merging any two costs more, so the
+    // list fills; past that each mark must grow a rectangle, not be dropped
+    ssd1327_rect_t marked[SSD1327_DIRTY_MAX + 3];
+    for (int i = 0; i < SSD1327_DIRTY_MAX + 3; i++)
+    {
+        int x = (i % 4) * 32, y = (i / 4) * 40;
+        spi_oled_mark_dirty(&dev, x, y, 4, 16);
+        marked[i] = (ssd1327_rect_t){(uint8_t)x, (uint8_t)y, (uint8_t)(x + 3), (uint8_t)(y + 15)};
+        CHECK(dev.dirty_count <= SSD1327_DIRTY_MAX);
+        CHECK_EQ(dev.dirty_count, i < SSD1327_DIRTY_MAX ? i + 1 : SSD1327_DIRTY_MAX);
+        // Nothing marked so far is lost
+        for (int j = 0; j <= i; j++)
+        {
+            CHECK(any_covers(dev.dirty, dev.dirty_count, marked[j].x0, marked[j].y0, marked[j].x1, marked[j].y1));
+        }
+    }
+    host_display_stop(&dev);
+}
+
+static void test_merge_rects(void)
+{
+    // Overlapping copies collapse to one
+    ssd1327_rect_t same[3] = {{10, 10, 41, 50}, {10, 10, 41, 50}, {12, 12, 39, 40}};
+    CHECK_EQ(spi_oled_merge_rects(same, 3), 1);
+    CHECK(covers(&same[0], 10, 10, 41, 50));
+
+    // Far apart: merging would send the empty space between them
+    ssd1327_rect_t apart[2] = {{0, 0, 3, 1}, {124, 126, 127, 127}};
+    CHECK_EQ(spi_oled_merge_rects(apart, 2), 2);
+
+    // Neighbours on the same rows share a window when that saves the overhead
+    ssd1327_rect_t near[2] = {{0, 60, 7, 69}, {10, 60, 17, 69}};
+    CHECK_EQ(spi_oled_merge_rects(near, 2), 1);
+    CHECK(covers(&near[0], 0, 60, 17, 69));
+
+    CHECK_EQ(spi_oled_merge_rects(apart, 1), 1);
+    CHECK_EQ(spi_oled_merge_rects(apart, 0), 0);
+}
+
+static void test_flush_covers_marks(void)
+{
+    static bool marked[SSD1327_HEIGHT][SSD1327_WIDTH];
+    for (int it = 0; it < 2000; it++)
+    {
+        start();
+        for (size_t i = 0; i < SSD1327_BUFFER_SIZE; i++)
+        {
+            dev.framebuffer[i] = (uint8_t)test_rand();
+        }
+        memset(marked, 0, sizeof(marked));
+        int marks = 1 + test_rand() % 24;
+        for (int m = 0; m < marks; m++)
+        {
+            int x = (int)(test_rand() % 150) - 10, y = (int)(test_rand() % 150) - 10;
+            int w = 1 + test_rand() % ((it & 1) ? 8 : 70), h = 1 + test_rand() % ((it & 2) ? 6 : 50);
+            spi_oled_mark_dirty(&dev, x, y, w, h);
+            for (int r = y; r < y + h; r++)
+            {
+                for (int c = x; c < x + w; c++)
+                {
+                    if (r >= 0 && r < SSD1327_HEIGHT && c >= 0 && c < SSD1327_WIDTH)
+                    {
+                        marked[r][c] = true;
+                    }
+                }
+            }
+        }
+        uint32_t sent = spi_oled_flush(&dev);
+        spi_oled_wait_idle(&dev);
+        CHECK_EQ(bad_transfers, 0);
+        CHECK_EQ(dev.dirty_count, 0);
+        ssd1327_stats_t stats;
+        spi_oled_get_stats(&dev, &stats);
+        CHECK_EQ(sent, stats.bytes);
+        CHECK(stats.windows <= SSD1327_DIRTY_MAX);
+        int missed = 0;
+        for (int r = 0; r < SSD1327_HEIGHT; r++)
+        {
+            for (int c = 0; c < SSD1327_WIDTH; c++)
+            {
+                missed += marked[r][c] && !flushed[r][c];
+            }
+        }
+        CHECK_EQ(missed, 0);
+        // Nothing left over for the next tick
+        CHECK_EQ(spi_oled_flush(&dev), 0);
+        host_display_stop(&dev);
+    }
+}
+
+int main(void)
+{
+    RUN(test_pair_widening);
+    RUN(test_covered_fast_path);
+    RUN(test_full_list);
+    RUN(test_merge_rects);
+    RUN(test_flush_covers_marks);
+    return test_result();
+}
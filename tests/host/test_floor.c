@@ -0,0 +1,224 @@
+// floor.h: floor control exchanges between units, with messages delivered by hand
+#include "test_util.h"
+#include "floor.h"
+
+static const uint8_t MAC_A[FLOOR_MAC_LEN] = {0x10, 0, 0, 0, 0, 1};
+static const uint8_t MAC_B[FLOOR_MAC_LEN] = {0x10, 0, 0, 0, 0, 2};
+static const uint8_t MAC_C[FLOOR_MAC_LEN] = {0x10, 0, 0, 0, 0, 3};
+
+static floor_ctl_t a, b, c;
+
+static void init_all(void)
+{
+    floor_init(&a, MAC_A);
+    floor_init(&b, MAC_B);
+    floor_init(&c, MAC_C);
+}
+
+static void test_uncontested(void)
+{
+    init_all();
+    uint32_t t = 1000;
+    CHECK_EQ(floor_want_talk(&a, t), FLOOR_OP_REQUEST);
+    CHECK_EQ(floor_want_talk(&a, t + 1), FLOOR_OP_NONE);
+    CHECK_EQ(floor_on_op(&b, MAC_A, FLOOR_OP_REQUEST, a.prio, t + 3), FLOOR_OP_NONE);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    CHECK(!floor_may_send(&a));
+
+    CHECK_EQ(floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS - 1), FLOOR_OP_NONE);
+    CHECK_EQ(floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS), FLOOR_OP_GRANT);
+    CHECK(floor_may_send(&a));
+    CHECK_EQ(floor_on_op(&b, MAC_A, FLOOR_OP_GRANT, a.prio, t + FLOOR_GRANT_WINDOW_MS + 3), FLOOR_OP_NONE);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    CHECK(memcmp(b.holder, MAC_A, FLOOR_MAC_LEN) == 0);
+
+    // B asking now is told the floor is taken
+    CHECK_EQ(floor_on_op(&a, MAC_B, FLOOR_OP_REQUEST, 0, t + 100), FLOOR_OP_GRANT);
+    CHECK_EQ(floor_want_talk(&b, t + 100), FLOOR_OP_NONE);
+
+    CHECK_EQ(floor_release(&a), FLOOR_OP_RELEASE);
+    CHECK_EQ(floor_release(&a), FLOOR_OP_NONE);
+    CHECK_EQ(floor_on_op(&b, MAC_A, FLOOR_OP_RELEASE, 0, t + 200), FLOOR_OP_NONE);
+    CHECK_EQ(b.state, FLOOR_IDLE);
+    CHECK_EQ(a.stats.granted, 1);
+    CHECK_EQ(b.stats.yielded, 0);
+}
+
+static void test_crossing_requests(void)
+{
+    init_all();
+    uint32_t t = 1000;
+    // Both ask within one packet time; each hears the other's request in flight
+    CHECK_EQ(floor_want_talk(&a, t), FLOOR_OP_REQUEST);
+    CHECK_EQ(floor_want_talk(&b, t + 2), FLOOR_OP_REQUEST);
+    CHECK_EQ(floor_on_op(&a, MAC_B, FLOOR_OP_REQUEST, b.prio, t + 5), FLOOR_OP_NONE);
+    CHECK_EQ(floor_on_op(&b, MAC_A, FLOOR_OP_REQUEST, a.prio, t + 5), FLOOR_OP_NONE);
+
+    // Equal priority: the lower MAC keeps its request, the other yields
+    CHECK_EQ(a.state, FLOOR_REQUESTING);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    CHECK_EQ(b.stats.yielded, 1);
+    CHECK_EQ(b.prio, 1);
+
+    CHECK_EQ(floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS), FLOOR_OP_GRANT);
+    CHECK_EQ(floor_tick(&b, t + FLOOR_GRANT_WINDOW_MS + 2), FLOOR_OP_NONE);
+    CHECK(floor_may_send(&a));
+    CHECK(!floor_may_send(&b));
+    floor_on_op(&b, MAC_A, FLOOR_OP_GRANT, a.prio, t + FLOOR_GRANT_WINDOW_MS + 3);
+    CHECK_EQ(floor_release(&a), FLOOR_OP_RELEASE);
+    floor_on_op(&b, MAC_A, FLOOR_OP_RELEASE, 0, t + 500);
+    CHECK_EQ(b.state, FLOOR_IDLE);
+
+    // Next round the loser's raised priority beats the lower MAC
+    t += 1000;
+    floor_want_talk(&a, t);
+    floor_want_talk(&b, t);
+    uint8_t prio_a = a.prio, prio_b = b.prio; // As carried in the two requests
+    floor_on_op(&a, MAC_B, FLOOR_OP_REQUEST, prio_b, t + 4);
+    floor_on_op(&b, MAC_A, FLOOR_OP_REQUEST, prio_a, t + 4);
+    CHECK_EQ(a.state, FLOOR_LISTENING);
+    CHECK_EQ(b.state, FLOOR_REQUESTING);
+    CHECK_EQ(floor_tick(&b, t + FLOOR_GRANT_WINDOW_MS), FLOOR_OP_GRANT);
+    CHECK_EQ(b.prio, 0);
+    CHECK_EQ(a.prio, 1);
+}
+
+static void test_crossing_grants(void)
+{
+    init_all();
+    uint32_t t = 1000;
+    // Both requests were lost, so both took the floor; the GRANTs cross
+    floor_want_talk(&a, t);
+    floor_want_talk(&b, t);
+    floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS);
+    floor_tick(&b, t + FLOOR_GRANT_WINDOW_MS);
+    CHECK(floor_may_send(&a) && floor_may_send(&b));
+
+    // The winner re-asserts, the loser yields; both count the collision
+    CHECK_EQ(floor_on_op(&a, MAC_B, FLOOR_OP_GRANT, b.prio, t + 35), FLOOR_OP_GRANT);
+    CHECK_EQ(floor_on_op(&b, MAC_A, FLOOR_OP_GRANT, a.prio, t + 35), FLOOR_OP_NONE);
+    CHECK(floor_may_send(&a));
+    CHECK(!floor_may_send(&b));
+    CHECK_EQ(a.stats.collisions, 1);
+    CHECK_EQ(b.stats.collisions, 1);
+    CHECK_EQ(b.stats.yielded, 1);
+
+    // Same for overlapping audio: the lower MAC keeps talking
+    init_all();
+    floor_want_talk(&a, t);
+    floor_want_talk(&b, t);
+    floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS);
+    floor_tick(&b, t + FLOOR_GRANT_WINDOW_MS);
+    floor_on_audio(&a, MAC_B, t + 40);
+    floor_on_audio(&b, MAC_A, t + 40);
+    CHECK(floor_may_send(&a));
+    CHECK(!floor_may_send(&b));
+}
+
+static void test_release_in_flight(void)
+{
+    init_all();
+    uint32_t t = 1000;
+    floor_want_talk(&a, t);
+    floor_on_op(&b, MAC_A, FLOOR_OP_REQUEST, 0, t + 2);
+    floor_on_op(&c, MAC_A, FLOOR_OP_REQUEST, 0, t + 2);
+    floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS);
+    floor_on_op(&b, MAC_A, FLOOR_OP_GRANT, 0, t + 32);
+    floor_on_op(&c, MAC_A, FLOOR_OP_GRANT, 0, t + 32);
+
+    // A releases at t1 while C, which missed A's last audio and saw its
+    // lease run out, asks at the same time: the two packets cross in flight
+    uint32_t t1 = t + 2000;
+    floor_on_audio(&b, MAC_A, t1 - 40);
+    floor_tick(&c, t1 - 1);
+    CHECK_EQ(c.state, FLOOR_IDLE);
+    CHECK_EQ(floor_release(&a), FLOOR_OP_RELEASE);
+    CHECK_EQ(floor_want_talk(&c, t1), FLOOR_OP_REQUEST);
+
+    // A is already idle, so it follows C instead of re-granting
+    CHECK_EQ(floor_on_op(&a, MAC_C, FLOOR_OP_REQUEST, 0, t1 + 3), FLOOR_OP_NONE);
+    CHECK_EQ(a.state, FLOOR_LISTENING);
+    CHECK(memcmp(a.holder, MAC_C, FLOOR_MAC_LEN) == 0);
+    // B hears C's request before A's release; the release then hands the floor to C
+    CHECK_EQ(floor_on_op(&b, MAC_C, FLOOR_OP_REQUEST, 0, t1 + 3), FLOOR_OP_NONE);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    CHECK_EQ(floor_on_op(&b, MAC_A, FLOOR_OP_RELEASE, 0, t1 + 4), FLOOR_OP_NONE);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    CHECK(memcmp(b.holder, MAC_C, FLOOR_MAC_LEN) == 0);
+    // B wanting to talk now must not cut in
+    CHECK_EQ(floor_want_talk(&b, t1 + 5), FLOOR_OP_NONE);
+
+    // A's release means nothing to C, which is requesting; its window runs out and it talks
+    floor_on_op(&c, MAC_A, FLOOR_OP_RELEASE, 0, t1 + 4);
+    CHECK_EQ(c.state, FLOOR_REQUESTING);
+    CHECK_EQ(floor_tick(&c, t1 + FLOOR_GRANT_WINDOW_MS), FLOOR_OP_GRANT);
+
+    // A stale request from long ago doesn't hijack a later release
+    init_all();
+    floor_want_talk(&a, t);
+    floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS);
+    floor_on_op(&b, MAC_A, FLOOR_OP_GRANT, 0, t + 32);
+    floor_on_op(&b, MAC_C, FLOOR_OP_REQUEST, 0, t + 50);
+    floor_on_audio(&b, MAC_A, t + 200);
+    floor_on_op(&b, MAC_A, FLOOR_OP_RELEASE, 0, t + 250);
+    CHECK_EQ(b.state, FLOOR_IDLE);
+}
+
+static void test_holder_timeout(void)
+{
+    init_all();
+    uint32_t t = 1000;
+    floor_want_talk(&a, t);
+    floor_tick(&a, t + FLOOR_GRANT_WINDOW_MS);
+    floor_on_op(&b, MAC_A, FLOOR_OP_GRANT, 0, t + 32);
+
+    // Audio keeps the lease alive
+    uint32_t last = t + 32;
+    for (uint32_t now = t + 64; now < t + 2000; now += 32)
+    {
+        floor_on_audio(&b, MAC_A, now);
+        CHECK_EQ(floor_tick(&b, now), FLOOR_OP_NONE);
+        CHECK_EQ(b.state, FLOOR_LISTENING);
+        last = now;
+    }
+
+    // Holder vanishes without a release: the floor frees after the timeout
+    CHECK_EQ(floor_tick(&b, last + FLOOR_HOLD_TIMEOUT_MS - 1), FLOOR_OP_NONE);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    CHECK_EQ(floor_tick(&b, last + FLOOR_HOLD_TIMEOUT_MS), FLOOR_OP_NONE);
+    CHECK_EQ(b.state, FLOOR_IDLE);
+    CHECK_EQ(floor_want_talk(&b, last + FLOOR_HOLD_TIMEOUT_MS + 1), FLOOR_OP_REQUEST);
+
+    // A request whose sender never follows up expires the same way
+    init_all();
+    floor_on_op(&b, MAC_C, FLOOR_OP_REQUEST, 0, t);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    floor_tick(&b, t + FLOOR_GRANT_WINDOW_MS + FLOOR_HOLD_TIMEOUT_MS - 1);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    floor_tick(&b, t + FLOOR_GRANT_WINDOW_MS + FLOOR_HOLD_TIMEOUT_MS);
+    CHECK_EQ(b.state, FLOOR_IDLE);
+}
+
+static void test_audio_is_implicit_grant(void)
+{
+    init_all();
+    uint32_t t = 1000;
+    // B never heard A's control packets, only its audio
+    floor_want_talk(&b, t);
+    floor_on_audio(&b, MAC_A, t + 10);
+    CHECK_EQ(b.state, FLOOR_LISTENING);
+    CHECK_EQ(b.stats.yielded, 1);
+    CHECK_EQ(floor_tick(&b, t + FLOOR_GRANT_WINDOW_MS), FLOOR_OP_NONE);
+    CHECK(!floor_may_send(&b));
+}
+
+int main(void)
+{
+    RUN(test_uncontested);
+    RUN(test_crossing_requests);
+    RUN(test_crossing_grants);
+    RUN(test_release_in_flight);
+    RUN(test_holder_timeout);
+    RUN(test_audio_is_implicit_grant);
+    return test_result();
+}
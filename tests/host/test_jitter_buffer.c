@@ -0,0 +1,318 @@
+// jitter_buffer.h: arrival/playout traces
+#include "test_util.h"
+#include "jitter_buffer.h"
+
+#define FRAME_MS 31
+#define MIN_DELAY 40
+#define MAX_DELAY 200
+#define STREAM 3
+
+// Sender timestamp of seq, starting from an arbitrary clock value
+#define TS(seq) (100000u + (uint32_t)(seq) * FRAME_MS)
+
+static jitter_buffer_t jb;
+
+static bool put(uint16_t seq, uint32_t arrival_ms)
+{
+    uint8_t data[4] = {(uint8_t)seq, (uint8_t)(seq >> 8), 0xAA, 0x55};
+    return jb_put(&jb, STREAM, seq, TS(seq), data, sizeof(data), arrival_ms);
+}
+
+// jb_get at now_ms; for JB_FRAME returns the seq stored in the payload via *seq
+static jb_result_t get(uint32_t now_ms, int *seq)
+{
+    uint8_t out[JB_MAX_PAYLOAD];
+    size_t len = 0;
+    jb_result_t r = jb_get(&jb, now_ms, out, &len);
+    if (r == JB_FRAME)
+    {
+        CHECK_EQ(len, 4);
+        *seq = out[0] | (out[1] << 8);
+    }
+    return r;
+}
+
+static void test_in_order(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    uint32_t transit = 7;
+    CHECK(put(0, TS(0) + transit));
+    CHECK_EQ(jb.target_delay_ms, MIN_DELAY);
+    CHECK_EQ(jb.offset_ms, transit + MIN_DELAY);
+
+    int seq = -1;
+    // Nothing before the deadline, the frame exactly at it
+    CHECK_EQ(get(TS(0) + transit + MIN_DELAY - 1, &seq), JB_EMPTY);
+    uint32_t due = 0;
+    CHECK(jb_next_due(&jb, TS(0) + transit + MIN_DELAY - 1, &due));
+    CHECK_EQ(due, 1);
+    CHECK_EQ(get(TS(0) + transit + MIN_DELAY, &seq), JB_FRAME);
+    CHECK_EQ(seq, 0);
+
+    for (uint16_t s = 1; s < 20; s++)
+    {
+        CHECK(put(s, TS(s) + transit));
+        CHECK_EQ(get(TS(s) + transit + MIN_DELAY, &seq), JB_FRAME);
+        CHECK_EQ(seq, s);
+    }
+    CHECK_EQ(jb.stats.played, 20);
+    CHECK_EQ(jb.stats.missing, 0);
+    CHECK_EQ(jb_jitter_ms(&jb), 0);
+}
+
+static void test_reordering(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    // 0 3 1 2 5 4: every frame still arrives before its deadline
+    const uint16_t order[] = {0, 3, 1, 2, 5, 4};
+    const uint32_t arrival[] = {TS(0) + 5, TS(3) + 5, TS(3) + 8, TS(3) + 9, TS(5) + 5, TS(5) + 6};
+    for (int i = 0; i < 6; i++)
+    {
+        CHECK(put(order[i], arrival[i]));
+    }
+    CHECK_EQ(jb_depth(&jb), 6);
+
+    int seq = -1;
+    uint32_t now = TS(0) + 5 + MIN_DELAY;
+    for (int s = 0; s < 6; s++, now += FRAME_MS)
+    {
+        CHECK_EQ(get(now, &seq), JB_FRAME);
+        CHECK_EQ(seq, s);
+    }
+    CHECK_EQ(jb.stats.played, 6);
+    CHECK_EQ(jb.stats.missing, 0);
+    CHECK_EQ(jb.stats.late, 0);
+    // Reordering shows up in the jitter estimate
+    CHECK(jb.jitter_q4 > 0);
+}
+
+static void test_duplicates(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    CHECK(put(0, TS(0)));
+    CHECK(put(1, TS(1)));
+    CHECK(!put(1, TS(1) + 2));
+    CHECK(!put(0, TS(1) + 3));
+    CHECK_EQ(jb.stats.duplicate, 2);
+    CHECK_EQ(jb.stats.received, 4);
+
+    int seq = -1;
+    CHECK_EQ(get(TS(0) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK_EQ(seq, 0);
+    // Once played, a copy of the frame is late rather than a duplicate
+    CHECK(!put(0, TS(1) + 4));
+    CHECK_EQ(jb.stats.late, 1);
+    CHECK_EQ(jb.stats.duplicate, 2);
+    CHECK_EQ(get(TS(1) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK_EQ(seq, 1);
+}
+
+static void test_late_and_missing(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    CHECK(put(0, TS(0)));
+    // 1 is delayed past its deadline, 2 and 3 arrive on time
+    CHECK(put(2, TS(2)));
+    CHECK(put(3, TS(3)));
+
+    int seq = -1;
+    CHECK_EQ(get(TS(0) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK_EQ(seq, 0);
+    // Before the deadline of 1 the buffer waits for it
+    CHECK_EQ(get(TS(1) + MIN_DELAY - 1, &seq), JB_EMPTY);
+    // At the deadline with later frames queued: conceal, don't rebuffer
+    CHECK_EQ(get(TS(1) + MIN_DELAY, &seq), JB_MISSING);
+    CHECK_EQ(jb.stats.missing, 1);
+    CHECK(!jb.rebuffer);
+
+    // The straggler is now late and dropped
+    CHECK(!put(1, TS(1) + MIN_DELAY + 1));
+    CHECK_EQ(jb.stats.late, 1);
+
+    CHECK_EQ(get(TS(2) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK_EQ(seq, 2);
+    CHECK_EQ(get(TS(3) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK_EQ(seq, 3);
+    CHECK_EQ(jb.stats.underrun, 0);
+}
+
+static void test_underrun_reanchors(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    CHECK(put(0, TS(0)));
+    CHECK(put(1, TS(1)));
+
+    int seq = -1;
+    CHECK_EQ(get(TS(0) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK_EQ(get(TS(1) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK(!jb_idle(&jb));
+
+    // 2 never arrives and nothing is queued behind it: underrun, not missing
+    CHECK_EQ(get(TS(2) + MIN_DELAY - 1, &seq), JB_EMPTY);
+    CHECK_EQ(get(TS(2) + MIN_DELAY, &seq), JB_UNDERRUN);
+    CHECK_EQ(jb.stats.underrun, 1);
+    CHECK_EQ(jb.stats.missing, 0);
+    CHECK(jb.rebuffer);
+    CHECK(jb_idle(&jb));
+    uint32_t due;
+    CHECK(!jb_next_due(&jb, TS(2) + MIN_DELAY, &due));
+    CHECK_EQ(get(TS(2) + MIN_DELAY + 100, &seq), JB_EMPTY);
+
+    // A frame from before the underrun point is late, it doesn't re-anchor
+    CHECK(!put(1, TS(2) + MIN_DELAY + 1));
+    CHECK(jb.rebuffer);
+
+    // The link comes back 60 ms slower; 3 and 4 were lost as well
+    uint32_t transit = 60;
+    CHECK(put(5, TS(5) + transit));
+    CHECK(!jb.rebuffer);
+    CHECK_EQ(jb.next_seq, 5);
+    CHECK_EQ(jb.offset_ms, (int32_t)(transit + jb.target_delay_ms));
+    // The big transit step raised the jitter estimate, and with it the target
+    CHECK(jb.target_delay_ms > MIN_DELAY);
+
+    uint32_t deadline = TS(5) + transit + jb.target_delay_ms;
+    CHECK_EQ(get(deadline - 1, &seq), JB_EMPTY);
+    CHECK_EQ(get(deadline, &seq), JB_FRAME);
+    CHECK_EQ(seq, 5);
+    // No spurious MISSING for the frames lost during the gap
+    CHECK_EQ(jb.stats.missing, 0);
+}
+
+static void test_new_stream_resets(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    CHECK(put(0, TS(0)));
+    CHECK(put(1, TS(1)));
+    uint8_t data[4] = {9, 0, 0, 0};
+    CHECK(jb_put(&jb, STREAM + 1, 500, TS(10), data, sizeof(data), TS(10) + 3));
+    CHECK_EQ(jb.stream_id, STREAM + 1);
+    CHECK_EQ(jb_depth(&jb), 1);
+    CHECK_EQ(jb.next_seq, 500);
+}
+
+static void test_overrun(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    CHECK(put(0, TS(0)));
+    CHECK(put(1, TS(1)));
+    // Far ahead of the window: the oldest frames give way
+    CHECK(put(JB_SLOTS + 1, TS(1) + 1));
+    CHECK_EQ(jb.stats.overrun, 2);
+    CHECK_EQ(jb.next_seq, 2);
+    CHECK_EQ(jb_depth(&jb), 1);
+}
+
+static void test_redundant_fill(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    CHECK(put(0, TS(0)));
+    CHECK(put(2, TS(2)));
+    CHECK(jb_wants(&jb, STREAM, 1));
+    CHECK(!jb_wants(&jb, STREAM, 2));
+    CHECK(!jb_wants(&jb, STREAM + 1, 1));
+
+    uint8_t copy[4] = {1, 0, 0, 0};
+    uint32_t received = jb.stats.received;
+    CHECK(jb_put_redundant(&jb, STREAM, 1, TS(1), copy, sizeof(copy)));
+    CHECK(!jb_put_redundant(&jb, STREAM, 1, TS(1), copy, sizeof(copy)));
+    CHECK_EQ(jb.stats.received, received);
+    CHECK_EQ(jb.stats.duplicate, 0);
+
+    int seq = -1;
+    for (int s = 0; s < 3; s++)
+    {
+        CHECK_EQ(get(TS(s) + MIN_DELAY, &seq), JB_FRAME);
+        CHECK_EQ(seq, s);
+    }
+    CHECK_EQ(jb.stats.missing, 0);
+}
+
+static void test_redundancy_target(void)
+{
+    for (uint8_t level = 0; level <= 2; level++)
+    {
+        jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+        jb_set_redundancy(&jb, level);
+        uint32_t transit = 5;
+        CHECK(put(0, TS(0) + transit));
+        uint16_t expect = (1 + level) * FRAME_MS > MIN_DELAY ? (1 + level) * FRAME_MS : MIN_DELAY;
+        CHECK_EQ(jb.target_delay_ms, expect);
+
+        // Frame 1 is lost; its copy at this level rides on packet 1 + level
+        int seq = -1;
+        CHECK_EQ(get(TS(0) + transit + jb.target_delay_ms, &seq), JB_FRAME);
+        for (uint16_t s = 2; s <= 1 + level; s++)
+        {
+            CHECK(put(s, TS(s) + transit));
+        }
+        if (level > 0)
+        {
+            uint8_t copy[4] = {1, 0, 0, 0};
+            CHECK(jb_put_redundant(&jb, STREAM, 1, TS(1), copy, sizeof(copy)));
+            CHECK_EQ(get(TS(1) + transit + jb.target_delay_ms, &seq), JB_FRAME);
+            CHECK_EQ(seq, 1);
+            CHECK_EQ(jb.stats.missing, 0);
+        }
+    }
+
+    // Without the longer target the level 2 copy arrives after the hole was concealed
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    CHECK(put(0, TS(0)));
+    int seq = -1;
+    CHECK_EQ(get(TS(0) + MIN_DELAY, &seq), JB_FRAME);
+    CHECK(put(2, TS(2)));
+    CHECK_EQ(get(TS(1) + MIN_DELAY, &seq), JB_MISSING);
+    CHECK(put(3, TS(3)));
+    CHECK(!jb_wants(&jb, STREAM, 1));
+}
+
+static void test_redundancy_raised_mid_stream(void)
+{
+    jb_init(&jb, FRAME_MS, MIN_DELAY, MAX_DELAY);
+    jb_set_redundancy(&jb, 1);
+    CHECK(put(0, TS(0)));
+    int32_t offset = jb.offset_ms;
+    uint16_t target = jb.target_delay_ms;
+
+    // A raise pushes the live playout point back by one frame per level
+    jb_set_redundancy(&jb, 2);
+    CHECK(put(1, TS(1)));
+    CHECK_EQ(jb.offset_ms, offset + FRAME_MS);
+    CHECK_EQ(jb.target_delay_ms, target + FRAME_MS);
+
+    // Lowering it again leaves the current playout point alone...
+    jb_set_redundancy(&jb, 0);
+    CHECK(put(2, TS(2)));
+    CHECK_EQ(jb.offset_ms, offset + FRAME_MS);
+    // ...and going back up to a level already covered doesn't add more
+    jb_set_redundancy(&jb, 2);
+    CHECK(put(3, TS(3)));
+    CHECK_EQ(jb.offset_ms, offset + FRAME_MS);
+
+    // The lower level applies from the next anchor
+    jb_set_redundancy(&jb, 0);
+    int seq = -1;
+    for (int s = 0; s < 4; s++)
+    {
+        CHECK_EQ(get(TS(s) + jb.offset_ms, &seq), JB_FRAME);
+    }
+    CHECK_EQ(get(TS(4) + jb.offset_ms, &seq), JB_UNDERRUN);
+    CHECK(put(10, TS(10)));
+    CHECK_EQ(jb.target_delay_ms, MIN_DELAY);
+}
+
+int main(void)
+{
+    RUN(test_in_order);
+    RUN(test_reordering);
+    RUN(test_duplicates);
+    RUN(test_late_and_missing);
+    RUN(test_underrun_reanchors);
+    RUN(test_new_stream_resets);
+    RUN(test_overrun);
+    RUN(test_redundant_fill);
+    RUN(test_redundancy_target);
+    RUN(test_redundancy_raised_mid_stream);
+    return test_result();
+}
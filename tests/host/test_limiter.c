@@ -0,0 +1,169 @@
+// limiter.h: ceiling, drain, and THD+N of AGC + limiter against hard clipping
+#include <math.h>
+#include <stdlib.h>
+#include "test_util.h"
+#include "agc.h"
+#include "limiter.h"
+
+#define FRAME 505
+#define QUIET_S 3
+#define LOUD_S 3
+#define SAMPLES ((QUIET_S + LOUD_S) * 16000 / FRAME * FRAME)
+#define LOUD_START (QUIET_S * 16000 / FRAME * FRAME)
+
+static void test_ceiling(void)
+{
+    limiter_t lim;
+    limiter_init(&lim);
+    int peak = 0;
+    // Random full-range bursts at up to 8x gain
+    for (int n = 0; n < 200000; n++)
+    {
+        int32_t v = (int32_t)(test_rand() % 65536) - 32768;
+        if ((n / 3000) & 1)
+        {
+            v *= 8;
+        }
+        int y = abs(limiter_step(&lim, v));
+        if (y > peak)
+        {
+            peak = y;
+        }
+    }
+    CHECK(peak <= LIMITER_CEILING);
+    CHECK(lim.limited > 0);
+}
+
+static void test_drain(void)
+{
+    limiter_t lim;
+    limiter_init(&lim);
+    int16_t tail[LIMITER_LOOKAHEAD];
+    CHECK_EQ(limiter_drain(&lim, tail), 0);
+
+    // Quiet ramp, so the gain stays at unity and the tail comes out unchanged
+    int16_t buf[FRAME];
+    for (int i = 0; i < FRAME; i++)
+    {
+        buf[i] = (int16_t)(i * 10);
+    }
+    limiter_process(&lim, buf, FRAME, LIMITER_UNITY, LIMITER_UNITY);
+    // Output lags by the look-ahead
+    CHECK_EQ(buf[LIMITER_LOOKAHEAD - 1], 0);
+    CHECK_EQ(buf[LIMITER_LOOKAHEAD], 0);
+    CHECK_EQ(buf[LIMITER_LOOKAHEAD + 1], 10);
+    CHECK_EQ(buf[FRAME - 1], (FRAME - 1 - LIMITER_LOOKAHEAD) * 10);
+
+    CHECK_EQ(limiter_drain(&lim, tail), LIMITER_LOOKAHEAD);
+    for (int i = 0; i < LIMITER_LOOKAHEAD; i++)
+    {
+        CHECK_EQ(tail[i], (FRAME - LIMITER_LOOKAHEAD + i) * 10);
+    }
+    CHECK_EQ(limiter_drain(&lim, tail), 0);
+}
+
+// Voiced speech stand-in: quiet talker, so the AGC climbs to full gain,
+// then shouting with a syllabic envelope
+static void make_signal(int16_t *x)
+{
+    double phase = 0.0;
+    for (int n = 0; n < SAMPLES; n++)
+    {
+        double t = n / 16000.0;
+        phase += 2 * M_PI * 150.0 / 16000.0;
+        double v = sin(phase) + 0.5 * sin(2 * phase) + 0.25 * sin(3 * phase);
+        double level = n < LOUD_START ? 400.0 : 14000.0 * (0.6 + 0.4 * sin(2 * M_PI * 4.0 * t));
+        x[n] = (int16_t)(level * v / 1.75);
+    }
+}
+
+// THD+N of out against ref over the loud part: the residual after fitting a
+// separate gain to each THD_BLOCK, so slow gain changes (AGC, limiter
+// release) don't count as distortion but clipped or bent waveforms do
+#define THD_BLOCK 80
+static double thdn(const int16_t *out, const double *ref, int delay)
+{
+    double res = 0, sig = 0;
+    for (int b = LOUD_START + delay; b + THD_BLOCK <= SAMPLES; b += THD_BLOCK)
+    {
+        double xy = 0, yy = 1e-9;
+        for (int n = b; n < b + THD_BLOCK; n++)
+        {
+            xy += out[n] * ref[n - delay];
+            yy += ref[n - delay] * ref[n - delay];
+        }
+        double a = xy / yy;
+        for (int n = b; n < b + THD_BLOCK; n++)
+        {
+            double d = out[n] - a * ref[n - delay];
+            res += d * d;
+            sig += (double)out[n] * out[n];
+        }
+    }
+    return sqrt(res / sig);
+}
+
+static void test_thd(void)
+{
+    static int16_t in[SAMPLES], clip[SAMPLES], lim_out[SAMPLES];
+    static double ideal[SAMPLES];
+    make_signal(in);
+    memcpy(clip, in, sizeof(in));
+    memcpy(lim_out, in, sizeof(in));
+
+    // Hard clip: agc_apply as used before the limiter; the ideal is the same ramp unclamped
+    agc_t agc = {.current_gain = 1.0f, .target_rms = TARGET_RMS,
+                 .attack_rate = AGC_ATTACK, .release_rate = AGC_RELEASE};
+    agc_t ideal_agc = agc;
+    for (int n = 0; n < SAMPLES; n += FRAME)
+    {
+        int32_t g0 = agc_update(&ideal_agc, &in[n], FRAME);
+        int32_t step = (ideal_agc.gain_q15 - g0) / FRAME, g = g0;
+        for (int i = 0; i < FRAME; i++)
+        {
+            g += step;
+            ideal[n + i] = ((int32_t)in[n + i] * (g >> 3)) >> 12;
+        }
+        agc_apply(&agc, &clip[n], FRAME);
+    }
+
+    agc_t agc2 = {.current_gain = 1.0f, .target_rms = TARGET_RMS,
+                  .attack_rate = AGC_ATTACK, .release_rate = AGC_RELEASE};
+    limiter_t lim;
+    limiter_init(&lim);
+    double t0 = now_ns();
+    for (int n = 0; n < SAMPLES; n += FRAME)
+    {
+        int32_t g0 = agc_update(&agc2, &lim_out[n], FRAME);
+        limiter_process(&lim, &lim_out[n], FRAME, g0, agc2.gain_q15);
+    }
+    double ns = (now_ns() - t0) / SAMPLES;
+
+    int clip_fs = 0, lim_fs = 0, lim_peak = 0;
+    for (int n = LOUD_START; n < SAMPLES; n++)
+    {
+        clip_fs += clip[n] == 32767 || clip[n] == -32768;
+        lim_fs += lim_out[n] == 32767 || lim_out[n] == -32768;
+        if (abs(lim_out[n]) > lim_peak)
+        {
+            lim_peak = abs(lim_out[n]);
+        }
+    }
+    double d_clip = thdn(clip, ideal, 0), d_lim = thdn(lim_out, ideal, LIMITER_LOOKAHEAD);
+    printf("  hard clip:     THD+N %5.1f%% (%.1f dB), %d samples at full scale\n",
+           100 * d_clip, 20 * log10(d_clip), clip_fs);
+    printf("  AGC + limiter: THD+N %5.1f%% (%.1f dB), %d samples at full scale, %.1f ns/sample\n",
+           100 * d_lim, 20 * log10(d_lim), lim_fs, ns);
+    CHECK(lim_peak <= LIMITER_CEILING);
+    CHECK_EQ(lim_fs, 0);
+    CHECK(clip_fs > 0);
+    CHECK(d_lim < d_clip / 2);
+}
+
+int main(void)
+{
+    RUN(test_ceiling);
+    RUN(test_drain);
+    RUN(test_thd);
+    return test_result();
+}
@@ -0,0 +1,50 @@
+// link_adapt.h: redundancy level choice
+#include "test_util.h"
+#include "link_adapt.h"
+
+#define FRAME_BYTES 259   // ADPCM_ENC_MAX_BYTES
+#define FRAME_MS 31.0f
+
+static uint8_t choose(int rssi, float loss, float min_delay, float max_delay)
+{
+    return link_choose_red_level(rssi, (uint32_t)(loss * 65536.0f), FRAME_BYTES, 12, 800, 2,
+                                 FRAME_MS, min_delay, max_delay);
+}
+
+static void test_clean_link(void)
+{
+    CHECK_EQ(choose(-40, 0.0f, 40, 200), 0);
+}
+
+static void test_lossy_link(void)
+{
+    CHECK(choose(-40, 0.05f, 40, 200) >= 1);
+    CHECK_EQ(choose(-40, 0.30f, 40, 200), 2);
+    // Weak signal alone is enough to make redundancy worth it
+    CHECK(choose(-76, 0.0f, 40, 200) >= 1);
+}
+
+static void test_latency_charge(void)
+{
+    // Level 1 costs (62 - 40) ms over the 40 ms receiver floor, i.e. the same as
+    // 2.2% residual loss. At 3% measured loss level 1 pays off with the floor,
+    // not when the full frame time is charged as if the receiver had no floor.
+    CHECK_EQ(choose(-40, 0.03f, 40, 200), 1);
+    CHECK_EQ(choose(-40, 0.03f, 0, 200), 0);
+}
+
+static void test_receiver_cap(void)
+{
+    // A receiver that can't hold (1 + level) frames never gets that level
+    CHECK(choose(-40, 0.30f, 40, 80) <= 1);
+    CHECK_EQ(choose(-40, 0.30f, 40, 50), 0);
+}
+
+int main(void)
+{
+    RUN(test_clean_link);
+    RUN(test_lossy_link);
+    RUN(test_latency_charge);
+    RUN(test_receiver_cap);
+    return test_result();
+}
@@ -0,0 +1,89 @@
+// mixer.h: saturating int16 accumulate (scalar path; the PIE blocks need the S3)
+#include "test_util.h"
+#include "mixer.h"
+
+static int16_t ref_add(int16_t a, int16_t b)
+{
+    int32_t v = (int32_t)a + b;
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+static void test_sat16(void)
+{
+    CHECK_EQ(mixer_sat16(32767), 32767);
+    CHECK_EQ(mixer_sat16(32768), 32767);
+    CHECK_EQ(mixer_sat16(65534), 32767);
+    CHECK_EQ(mixer_sat16(-32768), -32768);
+    CHECK_EQ(mixer_sat16(-32769), -32768);
+    CHECK_EQ(mixer_sat16(-65536), -32768);
+    CHECK_EQ(mixer_sat16(0), 0);
+    CHECK_EQ(mixer_sat16(-1), -1);
+}
+
+static void test_clipping(void)
+{
+    // Full-scale pairs clip to the rails, never wrap
+    const int16_t a[] = {32767, 32767, 32000, -32768, -32768, -32000, 32767, -32768, 1, -1};
+    const int16_t b[] = {1, 32767, 800, -1, -32768, -800, -32768, 32767, 32767, -32768};
+    const int16_t want[] = {32767, 32767, 32767, -32768, -32768, -32768, -1, -1, 32767, -32768};
+    int16_t dst[10];
+    memcpy(dst, a, sizeof(dst));
+    mixer_add_s16(dst, b, 10);
+    for (int i = 0; i < 10; i++)
+    {
+        CHECK_EQ(dst[i], want[i]);
+    }
+}
+
+static void test_lengths_and_alignment(void)
+{
+    // Every length up to a few PIE blocks past a chunk, at every element
+    // offset from 16-byte alignment, so block and tail split both ways
+    static int16_t dst[600] __attribute__((aligned(MIXER_ALIGN)));
+    static int16_t src[600] __attribute__((aligned(MIXER_ALIGN)));
+    static int16_t want[600];
+    for (size_t off = 0; off < 8; off++)
+    {
+        for (size_t n = 0; n <= 530; n += (n < 40 ? 1 : 37))
+        {
+            for (size_t i = 0; i < sizeof(dst) / sizeof(dst[0]); i++)
+            {
+                // Loud enough that about half the sums clip
+                dst[i] = (int16_t)test_rand();
+                src[i] = (int16_t)test_rand();
+                want[i] = dst[i];
+            }
+            for (size_t i = 0; i < n; i++)
+            {
+                want[off + i] = ref_add(dst[off + i], src[(off * 3) % 8 + i]);
+            }
+            mixer_add_s16(&dst[off], &src[(off * 3) % 8], n);
+            // Inside the range summed, outside untouched
+            CHECK(memcmp(dst, want, sizeof(dst)) == 0);
+        }
+    }
+}
+
+static void test_three_talkers(void)
+{
+    // Accumulating several sources saturates at each step, as mix_rx_streams does
+    int16_t mix[8] = {20000, -20000, 30000, -30000, 100, 0, 16384, -16384};
+    const int16_t s1[8] = {20000, -20000, 5000, -5000, 100, 0, 16384, -16384};
+    const int16_t s2[8] = {-10000, 10000, -30000, 30000, 100, 0, -1, 1};
+    mixer_add_s16(mix, s1, 8);
+    mixer_add_s16(mix, s2, 8);
+    const int16_t want[8] = {22767, -22768, 2767, -2768, 300, 0, 32766, -32767};
+    for (int i = 0; i < 8; i++)
+    {
+        CHECK_EQ(mix[i], want[i]);
+    }
+}
+
+int main(void)
+{
+    RUN(test_sat16);
+    RUN(test_clipping);
+    RUN(test_lengths_and_alignment);
+    RUN(test_three_talkers);
+    return test_result();
+}
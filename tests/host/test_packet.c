@@ -0,0 +1,211 @@
+// packet.h: header parse and RED payload encode/decode
+#include "test_util.h"
+#include "packet.h"
+
+static size_t make_frame(uint8_t *buf, bb_pkt_type_t type, uint16_t payload_len)
+{
+    for (uint16_t i = 0; i < payload_len; i++)
+    {
+        buf[BB_PKT_HEADER_SIZE + i] = (uint8_t)i;
+    }
+    return bb_pkt_write_header(buf, type, BB_CODEC_ADPCM, 7, 0xBEEF, 0x12345678, payload_len);
+}
+
+static void test_roundtrip(void)
+{
+    uint8_t buf[64];
+    size_t len = make_frame(buf, BB_PKT_AUDIO, 20);
+    CHECK_EQ(len, BB_PKT_HEADER_SIZE + 20);
+
+    bb_pkt_t pkt;
+    CHECK(bb_pkt_parse(buf, len, &pkt));
+    CHECK_EQ(pkt.version, BB_PKT_VERSION);
+    CHECK_EQ(pkt.type, BB_PKT_AUDIO);
+    CHECK_EQ(pkt.codec, BB_CODEC_ADPCM);
+    CHECK_EQ(pkt.stream_id, 7);
+    CHECK_EQ(pkt.seq, 0xBEEF);
+    CHECK_EQ(pkt.timestamp, 0x12345678);
+    CHECK_EQ(pkt.payload_len, 20);
+    CHECK(pkt.payload == buf + BB_PKT_HEADER_SIZE);
+
+    // Little endian on the wire
+    CHECK_EQ(buf[4], 0xEF);
+    CHECK_EQ(buf[5], 0xBE);
+    CHECK_EQ(buf[6], 0x78);
+    CHECK_EQ(buf[9], 0x12);
+}
+
+static void test_too_short(void)
+{
+    uint8_t buf[64];
+    make_frame(buf, BB_PKT_PING, 0);
+    bb_pkt_t pkt;
+    for (size_t len = 0; len < BB_PKT_HEADER_SIZE; len++)
+    {
+        CHECK(!bb_pkt_parse(buf, len, &pkt));
+    }
+    CHECK(bb_pkt_parse(buf, BB_PKT_HEADER_SIZE, &pkt));
+    CHECK_EQ(pkt.payload_len, 0);
+}
+
+static void test_bad_magic_version_type(void)
+{
+    uint8_t buf[64];
+    size_t len = make_frame(buf, BB_PKT_CMD, 2);
+    bb_pkt_t pkt;
+
+    buf[0] = 0xBA;
+    CHECK(!bb_pkt_parse(buf, len, &pkt));
+    buf[0] = BB_PKT_MAGIC;
+
+    for (int version = 0; version < 16; version++)
+    {
+        buf[1] = (uint8_t)((version << 4) | BB_PKT_CMD);
+        CHECK_EQ(bb_pkt_parse(buf, len, &pkt), version == BB_PKT_VERSION);
+    }
+
+    for (int type = 0; type < 16; type++)
+    {
+        buf[1] = (uint8_t)((BB_PKT_VERSION << 4) | type);
+        CHECK_EQ(bb_pkt_parse(buf, len, &pkt), type <= BB_PKT_FLOOR);
+    }
+
+    // The old ASCII prefixes must not parse
+    const char *ascii = "CMD:1234567890";
+    CHECK(!bb_pkt_parse((const uint8_t *)ascii, strlen(ascii), &pkt));
+}
+
+static void test_payload_overrun(void)
+{
+    uint8_t buf[64];
+    size_t len = make_frame(buf, BB_PKT_MSG, 10);
+    bb_pkt_t pkt;
+
+    // Truncated frame: payload_len says more than arrived
+    for (size_t cut = 1; cut <= 10; cut++)
+    {
+        CHECK(!bb_pkt_parse(buf, len - cut, &pkt));
+    }
+
+    // Declared length past the end, including values that would wrap
+    const uint16_t lens[] = {11, 52, 0x7FFF, 0xFFFF};
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+    {
+        bb_wr16(&buf[10], lens[i]);
+        CHECK(!bb_pkt_parse(buf, len, &pkt));
+    }
+
+    // Trailing bytes after the payload are allowed and ignored
+    bb_wr16(&buf[10], 4);
+    CHECK(bb_pkt_parse(buf, len, &pkt));
+    CHECK_EQ(pkt.payload_len, 4);
+}
+
+static void test_red_roundtrip(void)
+{
+    uint8_t r1[30], r2[17], primary[40];
+    memset(r1, 0x11, sizeof(r1));
+    memset(r2, 0x22, sizeof(r2));
+    memset(primary, 0x33, sizeof(primary));
+    const uint8_t *red[BB_RED_MAX] = {r1, r2};
+    const uint16_t red_len[BB_RED_MAX] = {sizeof(r1), sizeof(r2)};
+
+    for (uint8_t count = 0; count <= BB_RED_MAX; count++)
+    {
+        uint8_t payload[128];
+        size_t off = bb_red_write(payload, count, red, red_len);
+        CHECK_EQ(off, bb_red_block_size(count, red_len));
+        memcpy(&payload[off], primary, sizeof(primary));
+
+        bb_red_t out = {0};
+        CHECK(bb_red_parse(payload, off + sizeof(primary), &out));
+        CHECK_EQ(out.count, count);
+        for (uint8_t i = 0; i < count; i++)
+        {
+            CHECK_EQ(out.red_len[i], red_len[i]);
+            CHECK(memcmp(out.red[i], red[i], red_len[i]) == 0);
+        }
+        CHECK_EQ(out.primary_len, sizeof(primary));
+        CHECK(memcmp(out.primary, primary, sizeof(primary)) == 0);
+    }
+}
+
+static void test_red_walk_bounds(void)
+{
+    uint8_t r1[30], r2[17];
+    memset(r1, 0x11, sizeof(r1));
+    memset(r2, 0x22, sizeof(r2));
+    const uint8_t *red[BB_RED_MAX] = {r1, r2};
+    const uint16_t red_len[BB_RED_MAX] = {sizeof(r1), sizeof(r2)};
+    uint8_t payload[128];
+    size_t block = bb_red_write(payload, 2, red, red_len);
+    bb_red_t out;
+
+    CHECK(!bb_red_parse(payload, 0, &out));
+
+    // Every cut inside the redundancy block fails; at its end the primary is empty
+    for (size_t len = 1; len < block; len++)
+    {
+        CHECK(!bb_red_parse(payload, len, &out));
+    }
+    CHECK(bb_red_parse(payload, block, &out));
+    CHECK_EQ(out.primary_len, 0);
+
+    // Count above BB_RED_MAX
+    payload[0] = BB_RED_MAX + 1;
+    CHECK(!bb_red_parse(payload, block, &out));
+    payload[0] = 0xFF;
+    CHECK(!bb_red_parse(payload, block, &out));
+    payload[0] = 2;
+
+    // A redundant length that runs past the payload
+    bb_wr16(&payload[1], 0xFFFF);
+    CHECK(!bb_red_parse(payload, block, &out));
+    bb_wr16(&payload[1], (uint16_t)(block));
+    CHECK(!bb_red_parse(payload, block, &out));
+    bb_wr16(&payload[1], sizeof(r1));
+
+    // Second length overruns by one
+    bb_wr16(&payload[1 + 2 + sizeof(r1)], sizeof(r2) + 1);
+    CHECK(!bb_red_parse(payload, block, &out));
+}
+
+static void test_red_fuzz(void)
+{
+    // Random payloads must never parse to pointers outside the buffer
+    uint8_t payload[64];
+    for (int it = 0; it < 200000; it++)
+    {
+        size_t len = test_rand() % sizeof(payload);
+        for (size_t i = 0; i < len; i++)
+        {
+            payload[i] = (uint8_t)test_rand();
+        }
+        if (len > 0 && (test_rand() & 1))
+        {
+            payload[0] = (uint8_t)(test_rand() % (BB_RED_MAX + 1));
+        }
+        bb_red_t out = {0};
+        if (!bb_red_parse(payload, len, &out))
+        {
+            continue;
+        }
+        for (uint8_t i = 0; i < out.count; i++)
+        {
+            CHECK(out.red[i] >= payload && out.red[i] + out.red_len[i] <= payload + len);
+        }
+        CHECK(out.primary >= payload && out.primary + out.primary_len == payload + len);
+    }
+}
+
+int main(void)
+{
+    RUN(test_roundtrip);
+    RUN(test_too_short);
+    RUN(test_bad_magic_version_type);
+    RUN(test_payload_overrun);
+    RUN(test_red_roundtrip);
+    RUN(test_red_walk_bounds);
+    RUN(test_red_fuzz);
+    return test_result();
+}
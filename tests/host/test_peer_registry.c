@@ -0,0 +1,265 @@
+// peer_registry.h: insert/find/remove against a reference set, backward-shift removal, expiry
+#include "test_util.h"
+#include "peer_registry.h"
+
+static peer_registry_t reg;
+
+static void make_mac(uint8_t *mac, uint32_t id)
+{
+    // Shared vendor prefix, like real units
+    mac[0] = 0x48;
+    mac[1] = 0x27;
+    mac[2] = 0xE2;
+    mac[3] = (uint8_t)(id >> 16);
+    mac[4] = (uint8_t)(id >> 8);
+    mac[5] = (uint8_t)id;
+}
+
+static uint32_t home_of(uint32_t id)
+{
+    uint8_t mac[PEER_MAC_LEN];
+    make_mac(mac, id);
+    return peer_hash(mac) & (PEER_SLOTS - 1);
+}
+
+// First `count` ids from `start` whose home slot is `home`
+static int ids_with_home(uint32_t home, uint32_t *ids, int count, uint32_t start)
+{
+    int n = 0;
+    for (uint32_t id = start; n < count && id < start + 1000000; id++)
+    {
+        if (home_of(id) == home)
+        {
+            ids[n++] = id;
+        }
+    }
+    return n;
+}
+
+// Every used slot must be reachable from its home without crossing an empty slot
+static bool probe_runs_intact(void)
+{
+    for (uint32_t i = 0; i < PEER_SLOTS; i++)
+    {
+        if (!reg.slots[i].used)
+        {
+            continue;
+        }
+        uint32_t j = peer_hash(reg.slots[i].mac) & (PEER_SLOTS - 1);
+        while (j != i)
+        {
+            if (!reg.slots[j].used)
+            {
+                return false;
+            }
+            j = (j + 1) & (PEER_SLOTS - 1);
+        }
+    }
+    return true;
+}
+
+static bool touch(uint32_t id, uint32_t now_ms, bool *added)
+{
+    uint8_t mac[PEER_MAC_LEN];
+    make_mac(mac, id);
+    return peer_touch(&reg, mac, now_ms, added) != NULL;
+}
+
+static peer_t *find(uint32_t id)
+{
+    uint8_t mac[PEER_MAC_LEN];
+    make_mac(mac, id);
+    return peer_find(&reg, mac);
+}
+
+static bool remove_id(uint32_t id)
+{
+    uint8_t mac[PEER_MAC_LEN];
+    make_mac(mac, id);
+    return peer_remove(&reg, mac);
+}
+
+static void test_capacity(void)
+{
+    peer_reg_init(&reg);
+    bool added;
+    for (uint32_t id = 0; id < PEER_MAX; id++)
+    {
+        CHECK(touch(id, 1000, &added));
+        CHECK(added);
+    }
+    CHECK_EQ(reg.count, PEER_MAX);
+    CHECK(!touch(PEER_MAX, 1000, &added));
+    CHECK(!added);
+    CHECK_EQ(reg.full, 1);
+    // Known peers are still found and refreshed when full
+    CHECK(touch(5, 2000, &added));
+    CHECK(!added);
+    CHECK_EQ(find(5)->last_seen_ms, 2000);
+    CHECK(probe_runs_intact());
+}
+
+static void test_backward_shift(void)
+{
+    // A run of three colliding peers, then one whose home is inside the run
+    uint32_t home = 40;
+    uint32_t same[3], next[1];
+    CHECK_EQ(ids_with_home(home, same, 3, 0), 3);
+    CHECK_EQ(ids_with_home(home + 1, next, 1, 0), 1);
+
+    peer_reg_init(&reg);
+    bool added;
+    for (int i = 0; i < 3; i++)
+    {
+        touch(same[i], 0, &added);
+    }
+    touch(next[0], 0, &added);
+    // Slots 40..43: same[0], same[1], same[2], next (displaced from 41)
+    CHECK(find(same[0]) == &reg.slots[home]);
+    CHECK(find(next[0]) == &reg.slots[home + 3]);
+
+    // Removing the head shifts every entry of the run back by one, no tombstone
+    CHECK(remove_id(same[0]));
+    CHECK(find(same[0]) == NULL);
+    CHECK(find(same[1]) == &reg.slots[home]);
+    CHECK(find(same[2]) == &reg.slots[home + 1]);
+    CHECK(find(next[0]) == &reg.slots[home + 2]);
+    CHECK(!reg.slots[home + 3].used);
+    CHECK(probe_runs_intact());
+
+    // An entry already at its home is not pulled in front of it
+    uint32_t far[1];
+    CHECK_EQ(ids_with_home(home + 3, far, 1, 0), 1);
+    touch(far[0], 0, &added);
+    CHECK(find(far[0]) == &reg.slots[home + 3]);
+    CHECK(remove_id(same[1]));
+    CHECK(find(same[2]) == &reg.slots[home]);
+    CHECK(find(next[0]) == &reg.slots[home + 1]);
+    CHECK(find(far[0]) == &reg.slots[home + 3]);
+    CHECK(probe_runs_intact());
+    CHECK(!remove_id(same[1]));
+    CHECK_EQ(reg.count, 3);
+}
+
+static void test_backward_shift_wraps(void)
+{
+    // A run starting in the last slot continues at slot 0
+    uint32_t last[3], zero[1];
+    CHECK_EQ(ids_with_home(PEER_SLOTS - 1, last, 3, 0), 3);
+    CHECK_EQ(ids_with_home(0, zero, 1, 0), 1);
+
+    peer_reg_init(&reg);
+    bool added;
+    for (int i = 0; i < 3; i++)
+    {
+        touch(last[i], 0, &added);
+    }
+    touch(zero[0], 0, &added);
+    CHECK(find(last[1]) == &reg.slots[0]);
+    CHECK(find(zero[0]) == &reg.slots[2]);
+
+    CHECK(remove_id(last[0]));
+    CHECK(find(last[1]) == &reg.slots[PEER_SLOTS - 1]);
+    CHECK(find(last[2]) == &reg.slots[0]);
+    CHECK(find(zero[0]) == &reg.slots[1]);
+    CHECK(probe_runs_intact());
+}
+
+static void test_random_against_reference(void)
+{
+    // Ids drawn from a small space so inserts, hits and removals all happen often
+    enum { SPACE = 256 };
+    static bool present[SPACE];
+    memset(present, 0, sizeof(present));
+    peer_reg_init(&reg);
+    int count = 0;
+    test_rand_state = 7;
+    for (int op = 0; op < 2000000; op++)
+    {
+        uint32_t id = test_rand() % SPACE;
+        uint32_t kind = test_rand() % 3;
+        bool added;
+        if (kind == 0)
+        {
+            bool ok = touch(id, (uint32_t)op, &added);
+            if (present[id])
+            {
+                CHECK(ok && !added);
+            }
+            else if (count < PEER_MAX)
+            {
+                CHECK(ok && added);
+                present[id] = true;
+                count++;
+            }
+            else
+            {
+                CHECK(!ok);
+            }
+        }
+        else if (kind == 1)
+        {
+            CHECK_EQ(remove_id(id), present[id]);
+            if (present[id])
+            {
+                present[id] = false;
+                count--;
+            }
+        }
+        else
+        {
+            CHECK_EQ(find(id) != NULL, present[id]);
+        }
+        if (test_failures)
+        {
+            return;
+        }
+    }
+    CHECK_EQ(reg.count, count);
+    CHECK(probe_runs_intact());
+}
+
+static void test_expire(void)
+{
+    peer_reg_init(&reg);
+    bool added;
+    for (uint32_t id = 0; id < PEER_MAX; id++)
+    {
+        touch(id, (id & 1) ? 5000 : 1000, &added);
+    }
+    CHECK_EQ(peer_expire(&reg, 21001, 20000), PEER_MAX / 2);
+    CHECK_EQ(reg.count, PEER_MAX / 2);
+    CHECK_EQ(reg.expired, PEER_MAX / 2);
+    for (uint32_t id = 0; id < PEER_MAX; id++)
+    {
+        CHECK_EQ(find(id) != NULL, (id & 1) != 0);
+    }
+    CHECK(probe_runs_intact());
+    CHECK_EQ(peer_expire(&reg, 21001, 20000), 0);
+}
+
+static void test_jitter(void)
+{
+    peer_reg_init(&reg);
+    bool added;
+    touch(1, 0, &added);
+    peer_t *p = find(1);
+    // Transit alternating +-8 ms: |D| is 16 every packet, J converges to 16
+    for (uint32_t n = 0; n < 500; n++)
+    {
+        uint32_t ts = n * 31;
+        peer_update_transit(p, ts, ts + 20 + ((n & 1) ? 8 : -8));
+    }
+    CHECK(peer_jitter_ms(p) >= 15 && peer_jitter_ms(p) <= 16); // Q4 rounding settles just below
+}
+
+int main(void)
+{
+    RUN(test_capacity);
+    RUN(test_backward_shift);
+    RUN(test_backward_shift_wraps);
+    RUN(test_random_against_reference);
+    RUN(test_expire);
+    RUN(test_jitter);
+    return test_result();
+}
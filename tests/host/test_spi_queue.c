@@ -0,0 +1,147 @@
+// esp32-spi-ssd1327.c: queued transfers on a bus slower than the drawing
+#include "test_util.h"
+#include "ssd1327_host.h"
+
+static struct spi_ssd1327 dev;
+static int expect_slot;     // Next dev.trans slot to go out
+static bool expect_data;    // A data transaction follows each command one
+static int bad_order, bad_dc, bad_window;
+static uint16_t window_len; // Data bytes the last command window asks for
+
+static void on_transfer(spi_transaction_t *t, const uint8_t *bytes, size_t len)
+{
+    // Results come back in queue order, which is the trans ring order
+    if (t != &dev.trans[expect_slot])
+    {
+        bad_order++;
+    }
+    expect_slot = (expect_slot + 1) % SSD1327_QUEUE_DEPTH;
+
+    // Command and data alternate, each with its own DC level
+    const ssd1327_xfer_ctx_t *want = expect_data ? &dev.ctx_data : &dev.ctx_cmd;
+    if (t->user != want || GPIO.level[HOST_DC_PIN] != want->dc_level)
+    {
+        bad_dc++;
+    }
+    if (!expect_data)
+    {
+        if (len != SSD1327_CMD_BYTES || bytes[0] != 0x15 || bytes[3] != 0x75 ||
+            bytes[1] > bytes[2] || bytes[4] > bytes[5])
+        {
+            bad_window++;
+        }
+        window_len = (uint16_t)((bytes[2] - bytes[1] + 1) * (bytes[5] - bytes[4] + 1));
+    }
+    else if (len != window_len)
+    {
+        bad_window++;
+    }
+    expect_data = !expect_data;
+}
+
+static void start(void)
+{
+    host_display_start(&dev);
+    host_spi.on_transfer = on_transfer;
+    spi_oled_set_compose(&dev, true);
+    expect_slot = 0;
+    expect_data = false;
+    bad_order = bad_dc = bad_window = 0;
+}
+
+static void finish(void)
+{
+    spi_oled_wait_idle(&dev);
+    CHECK_EQ(dev.in_flight, 0);
+    CHECK_EQ(dev.staging_used, 0);
+    CHECK_EQ(host_spi_pending(), 0);
+    CHECK_EQ(host_spi.queued, host_spi.completed);
+    CHECK_EQ(host_spi.overwritten, 0);
+    CHECK_EQ(host_spi.overflows, 0);
+    CHECK_EQ(host_spi.stuck, 0);
+    CHECK_EQ(bad_order, 0);
+    CHECK_EQ(bad_dc, 0);
+    CHECK_EQ(bad_window, 0);
+    host_display_stop(&dev);
+}
+
+// One display tick: scribble over the frame buffer, mark, flush
+static void frame(int marks, int max_w, int max_h)
+{
+    for (int m = 0; m < marks; m++)
+    {
+        int x = test_rand() % SSD1327_WIDTH, y = test_rand() % SSD1327_HEIGHT;
+        int w = 1 + test_rand() % max_w, h = 1 + test_rand() % max_h;
+        spi_oled_draw_square(&dev, x, y, w, h, (ssd1327_gs_t)(test_rand() & 15));
+    }
+    spi_oled_flush(&dev);
+}
+
+static void test_stalled_bus(void)
+{
+    // Nothing finishes unless the driver waits: every reuse of staging or a
+    // queue slot has to go through a blocking wait first
+    start();
+    host_spi.instant = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        frame(1 + test_rand() % 12, 60, 40);
+    }
+    ssd1327_stats_t stats;
+    spi_oled_get_stats(&dev, &stats);
+    CHECK(stats.stalls > 0);
+    CHECK(host_spi.queued > 2 * SSD1327_QUEUE_DEPTH);
+    finish();
+}
+
+static void test_full_frames_back_to_back(void)
+{
+    // A full screen is most of the staging buffer: the next one must wait
+    start();
+    host_spi.instant = 0;
+    for (int i = 0; i < 50; i++)
+    {
+        spi_oled_mark_dirty(&dev, 0, 0, SSD1327_WIDTH, SSD1327_HEIGHT);
+        spi_oled_flush(&dev);
+        CHECK(dev.staging_used <= SSD1327_STAGING_SIZE);
+    }
+    finish();
+}
+
+static void test_partial_progress(void)
+{
+    // The bus gets a few transactions done between ticks, so the ring wraps
+    // at every offset and staging is reclaimed whenever it drains
+    start();
+    for (int i = 0; i < 5000; i++)
+    {
+        host_spi.instant = test_rand() % 6;
+        frame(1 + test_rand() % 10, (i & 1) ? 128 : 12, (i & 2) ? 128 : 10);
+        CHECK(dev.in_flight <= SSD1327_QUEUE_DEPTH);
+        CHECK_EQ(dev.in_flight, host_spi_pending());
+    }
+    finish();
+}
+
+static void test_blocking_after_queued(void)
+{
+    // Blocking command helpers wait for the queue to drain before DC changes hands
+    start();
+    host_spi.instant = 0;
+    frame(4, 30, 30);
+    CHECK(dev.in_flight > 0);
+    spi_oled_send_cmd(&dev, 0xA4);
+    CHECK_EQ(dev.in_flight, 0);
+    CHECK_EQ(host_spi_pending(), 0);
+    frame(4, 30, 30);
+    finish();
+}
+
+int main(void)
+{
+    RUN(test_stalled_bus);
+    RUN(test_full_frames_back_to_back);
+    RUN(test_partial_progress);
+    RUN(test_blocking_after_queued);
+    return test_result();
+}
@@ -0,0 +1,65 @@
+#pragma once
+// Minimal test and benchmark helpers for the host tests
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                               \
+    do                                                                            \
+    {                                                                             \
+        if (!(cond))                                                              \
+        {                                                                         \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                      \
+        }                                                                         \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                            \
+    do                                                                            \
+    {                                                                             \
+        long long _a = (long long)(a), _b = (long long)(b);                       \
+        if (_a != _b)                                                             \
+        {                                                                         \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld != %lld)\n",  \
+                    __FILE__, __LINE__, #a, #b, _a, _b);                          \
+            test_failures++;                                                      \
+        }                                                                         \
+    } while (0)
+
+#define RUN(test)                            \
+    do                                       \
+    {                                        \
+        int _before = test_failures;         \
+        test();                              \
+        printf("%-40s %s\n", #test,          \
+               test_failures == _before ? "ok" : "FAILED"); \
+    } while (0)
+
+static inline int test_result(void)
+{
+    if (test_failures)
+    {
+        printf("%d check(s) failed\n", test_failures);
+        return 1;
+    }
+    return 0;
+}
+
+static inline double now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Deterministic generator, so runs are reproducible
+static uint32_t test_rand_state = 1;
+static inline uint32_t test_rand(void)
+{
+    test_rand_state = test_rand_state * 1103515245u + 12345u;
+    return test_rand_state >> 8;
+}
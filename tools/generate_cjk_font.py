@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Generate the CJK subset font used by the OLED text renderer.
+
+Only glyphs that the speech-command vocabularies can produce are kept:
+commands_cn.txt lists MultiNet phrases as pinyin, so every phrase is mapped
+to its hanzi below and the characters of those strings are rasterised from
+the Fusion Pixel 10px font with the same geometry as generateFont.html
+(ink threshold 128, one pixel of left padding dropped), so CJK glyphs share
+rows with font_10.  Blank rows above and below each glyph are trimmed and
+rows are bit-packed without per-row padding.
+
+Usage (from the repository root, needs Pillow):
+    python3 tools/generate_cjk_font.py
+"""
+
+import argparse
+import os
+import sys
+
+from PIL import Image, ImageDraw, ImageFont
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# MultiNet 拼音命令 -> 显示用汉字
+PHRASES = {
+    "qian mian zuo zhuan": "前面左转",
+    "qian mian you zhuan": "前面右转",
+    "bao chi zhi xing": "保持直行",
+    "ting che xiu xi": "停车休息",
+    "zan ting xiu xi": "暂停休息",
+    "deng deng wo": "等等我",
+    "you ren zai ma": "有人在吗",
+    "shou dao qing hui da": "收到请回答",
+    "shou dao le": "收到了",
+    "qing qiu zhi yuan": "请求支援",
+    "shang po lu": "上坡路",
+    "xia po lu": "下坡路",
+    "jian su man xing": "减速慢行",
+    "zhu yi an quan": "注意安全",
+    "kai shi zou lu": "开始走路",
+    "wo e le": "我饿了",
+    "chi dong xi": "吃东西",
+    "he shui le": "喝水了",
+    "jia you zhan": "加油站",
+    "kai shi lu xiang": "开始录像",
+    "jing tou fang da": "镜头放大",
+    "jing tou suo xiao": "镜头缩小",
+    "ting zhi bian jiao": "停止变焦",
+}
+
+# generateFont.html draws at (1, 1) with textBaseline 'top'; with Pillow's
+# default ascender anchor that is this offset for the 10px face
+DRAW_Y = -3
+THRESHOLD = 128
+
+
+def read_commands(path):
+    """Return the phrase column of an esp-sr commands_*.txt file."""
+    phrases = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            fields = line.strip().split(",")
+            if len(fields) >= 2 and fields[1]:
+                phrases.append(fields[1].strip())
+    return phrases
+
+
+def render(font, ch, height):
+    width = int(round(font.getlength(ch)))
+    im = Image.new("L", (width + 2, height + 2), 0)
+    ImageDraw.Draw(im).text((0, DRAW_Y), ch, font=font, fill=255)
+    return width, [[im.getpixel((x, y)) >= THRESHOLD for x in range(width)]
+                   for y in range(height)]
+
+
+def pack(rows):
+    """Trim blank rows and pack the rest MSB first with no row padding."""
+    inked = [i for i, row in enumerate(rows) if any(row)]
+    if not inked:
+        return 0, 0, b""
+    top, bottom = inked[0], inked[-1] + 1
+    bits = [b for row in rows[top:bottom] for b in row]
+    out = bytearray((len(bits) + 7) // 8)
+    for i, b in enumerate(bits):
+        if b:
+            out[i // 8] |= 0x80 >> (i % 8)
+    return top, bottom - top, bytes(out)
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--ttf", default=os.path.join(
+        ROOT, "tools", "fusion-pixel-10px-proportional-zh_hans.ttf"))
+    ap.add_argument("--commands", default=os.path.join(
+        ROOT, "build", "srmodels", "fst"))
+    ap.add_argument("--height", type=int, default=10)
+    ap.add_argument("--name", default="font_cjk_10")
+    ap.add_argument("-o", "--output", default=os.path.join(
+        ROOT, "esp-idf", "src", "main", "include", "fonts",
+        "fusion_pixel_cjk.h"))
+    args = ap.parse_args()
+
+    texts = []
+    table = []
+    for lang in ("cn", "en"):
+        path = os.path.join(args.commands, "commands_%s.txt" % lang)
+        if not os.path.exists(path):
+            continue
+        for phrase in read_commands(path):
+            if lang == "cn":
+                if phrase not in PHRASES:
+                    sys.exit("%s: no hanzi for '%s', add it to PHRASES"
+                             % (path, phrase))
+                if (phrase, PHRASES[phrase]) not in table:
+                    table.append((phrase, PHRASES[phrase]))
+                texts.append(PHRASES[phrase])
+            else:
+                texts.append(phrase)
+    if not texts:
+        sys.exit("no command lists under %s" % args.commands)
+
+    chars = sorted({c for t in texts for c in t if ord(c) > 126})
+    if any(ord(c) > 0xFFFF for c in chars):
+        sys.exit("only BMP code points are supported")
+
+    font = ImageFont.truetype(args.ttf, args.height)
+    glyphs = []
+    data = bytearray()
+    for ch in chars:
+        width, rows = render(font, ch, args.height)
+        top, count, bits = pack(rows)
+        glyphs.append((ch, width, top, count, len(data)))
+        data += bits
+    padded = sum(((w + 7) // 8) * args.height for _, w, _, _, _ in glyphs)
+
+    n = args.name
+    out = []
+    out.append("// Generated by tools/generate_cjk_font.py, do not edit")
+    out.append("// Font height: %d pixels, variable width" % args.height)
+    out.append("// %d glyphs from the speech command vocabularies" % len(glyphs))
+    out.append("// Total size: %d bytes (%d row-padded)" % (len(data), padded))
+    out.append("")
+    out.append("// Glyph table, sorted by code point")
+    out.append("const packed_glyph_t %s_glyphs[%d] = {" % (n, len(glyphs)))
+    for i, (ch, width, top, count, offset) in enumerate(glyphs):
+        sep = "," if i + 1 < len(glyphs) else ""
+        out.append("    {0x%04X, %d, %d, %d, %d}%s // '%s'"
+                   % (ord(ch), width, top, count, offset, sep, ch))
+    out.append("};")
+    out.append("")
+    out.append("// Bit-packed glyph rows, MSB first, no row padding")
+    out.append("const uint8_t %s_data[%d] = {" % (n, len(data)))
+    for i, (ch, width, top, count, offset) in enumerate(glyphs):
+        end = glyphs[i + 1][4] if i + 1 < len(glyphs) else len(data)
+        out.append("    // '%s' (U+%04X) - %dx%d pixels"
+                   % (ch, ord(ch), width, count))
+        chunk = data[offset:end]
+        for j in range(0, len(chunk), 8):
+            last = i + 1 == len(glyphs) and j + 8 >= len(chunk)
+            out.append("    " + ",".join("0x%02X" % b for b in chunk[j:j + 8])
+                       + ("" if last else ","))
+    out.append("};")
+    out.append("")
+    out.append("// Pinyin command string -> display text")
+    out.append("const char *const %s_phrases[][2] = {" % n)
+    for i, (pinyin, hanzi) in enumerate(table):
+        sep = "," if i + 1 < len(table) else ""
+        out.append("    {%s, %s}%s" % (c_string(pinyin), c_string(hanzi), sep))
+    out.append("};")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write("\n".join(out) + "\n")
+    print("%s: %d glyphs, %d bytes (%d row-padded), %d phrases"
+          % (args.output, len(glyphs), len(data), padded, len(table)))
+
+
+if __name__ == "__main__":
+    main()